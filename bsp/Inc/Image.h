@@ -3,19 +3,26 @@
 
 #include "einkPaper_2_13.h"
 
+/* Exported macros */
+
+// Geometry of the tamagotchi images (122x125 pixels), drawn on the bottom half of the display
+#define IMAGE_SPRITE_WIDTH 122
+#define IMAGE_SPRITE_STRIDE EINK_PANEL_STRIDE(IMAGE_SPRITE_WIDTH)
+#define IMAGE_SPRITE_HEIGHT 125
+
 /* Extern variables */
 
-// display array, used to write text
-extern uint8_t Image_array[ ];
+// display array (top half of the display), used to write text
+extern uint8_t Image_array[EINK_DISPLAY_HALF_SIZE];
 
 // Tamagotchi image, used to display new image
-extern uint8_t focus_monkey[];
+extern const uint8_t focus_monkey[];
 
 // Pointer to the Tamagotchi image that will be displayed
-extern uint8_t *current_tamagotchi;
+extern const uint8_t *current_tamagotchi;
 
 // Array that contains the letters an numbers
-extern uint8_t alphaNumbers[];
+extern const uint8_t alphaNumbers[];
 
 // Variables that defines the char height and width
 extern uint8_t char_height;
@@ -32,8 +39,10 @@ void Image_drawMinutesLeft(uint16_t minutesLeft);
 void Image_clearStrings(void);
 void Image_clearMinutesLeft(void);
 
-// Display function
-void Image_displayImage(void);
+// Display functions, non blocking
+DriverStatus Image_displayImage(void);
+DriverStatus Image_processImage(void);
+DriverStatus Image_sleepDisplays(void);
 
 
 #endif
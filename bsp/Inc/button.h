@@ -0,0 +1,76 @@
+#ifndef __BUTTON_H__
+#define __BUTTON_H__
+
+#include "stm32f429zi.h"
+
+/* Exported macros */
+
+// Gesture timings (ms, software timers). An edge is confirmed once the pin keeps its level for BUTTON_DEBOUNCE_MS,
+// a press held for BUTTON_LONG_MS is a long press and a second press within BUTTON_DOUBLE_MS of the release is a
+// double press
+#define BUTTON_DEBOUNCE_MS 30
+#define BUTTON_DOUBLE_MS 300
+#define BUTTON_LONG_MS 1500
+
+// A level confirmed more than BUTTON_LATE_MS after the debounce time (the task was delayed) may have changed again
+// while the line was masked, the level recorded at the edge is applied first
+#define BUTTON_LATE_MS 20
+
+/* Exported TypeDefs */
+
+/*
+ * Gestures recognized on a button
+ */
+typedef enum {
+  Button_Gesture_Short,         // Pressed and released once, no second press followed
+  Button_Gesture_Double,        // Pressed twice within BUTTON_DOUBLE_MS
+  Button_Gesture_Long,          // Held for BUTTON_LONG_MS, reported before the release
+} Button_Gesture;
+
+/*
+ * States of the gesture recognizer, changed by the confirmed edges and the gesture timer
+ */
+typedef enum {
+  Button_State_Released,        // No gesture in progress
+  Button_State_Pressed,         // First press, a long press once the gesture timer expires
+  Button_State_WaitSecond,      // Released after a short press, a short press once the gesture timer expires
+  Button_State_SecondPress,     // Second press, a double press once released
+  Button_State_Held,            // Long press reported, waits for the release
+} Button_State;
+
+/*
+ * Edge of the button recorded by the interruption, passed to Button_Edge
+ */
+typedef struct {
+  uint32_t Ms;                        // Time of the edge (SysTick_GetMs32)
+  uint8_t Pressed;                    // Level read right after the edge, 1 if pressed
+} Button_EdgeTypeDef;
+
+/*
+ * Debounced button on an EXTI line (both edges). GPIODriver and ActiveLevel are set by the user, the rest is managed
+ * by the Button API. The interruption only records the edge and masks the line, the level is confirmed by the
+ * debounce timer (no busy waiting)
+ */
+typedef struct {
+  GPIO_DriverTypeDef GPIODriver;      // Pin of the button, configured by Button_Init
+  PinLogicalLevel ActiveLevel;        // Level of the pin while the button is pressed
+  Button_State State;                 // State of the gesture recognizer, values can be of Button_State
+  uint8_t Pressed;                    // Confirmed (debounced) level, 1 while pressed
+  Button_EdgeTypeDef Edge;            // Last edge passed to Button_Edge, confirmed by the debounce timer
+  SWTimer_TypeDef DebounceTimer;      // Expires BUTTON_DEBOUNCE_MS after the last edge, confirms the level
+  SWTimer_TypeDef GestureTimer;       // Long press and double press windows
+} Button_TypeDef;
+
+/* Exported functions */
+
+// Initialization function
+void Button_Init(Button_TypeDef *pButton);
+
+// Edge handling, the interruption side and the task side
+Button_EdgeTypeDef Button_IRQHandling(Button_TypeDef *pButton);
+void Button_Edge(Button_TypeDef *pButton, const Button_EdgeTypeDef *pEdge);
+
+// Weak implementation of callback when a gesture is recognized
+void Button_CallbackGesture(Button_TypeDef *pButton, Button_Gesture Gesture);
+
+#endif // !__BUTTON_H__
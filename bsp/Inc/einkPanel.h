@@ -0,0 +1,83 @@
+#ifndef __EINKPANEL_H__
+#define __EINKPANEL_H__
+
+#include "stm32f429zi.h"
+
+/* Exported macros */
+
+// Geometry helpers, one RAM unit of the SSD16xx controllers holds 8 pixels
+#define EINK_PANEL_STRIDE(width) (((width) + 7) / 8)                                   // Bytes per line
+#define EINK_PANEL_HALF_SIZE(width, height) (EINK_PANEL_STRIDE(width) * ((height) / 2)) // Bytes of each half
+
+// Geometry of every supported panel of the SSD16xx family (source outputs x gate outputs)
+#define EINK_PANEL_1_54_WIDTH 200   // 1.54" panel (SSD1681), 200x200
+#define EINK_PANEL_1_54_HEIGHT 200
+#define EINK_PANEL_2_13_WIDTH 122   // 2.13" panel (SSD1680), 122x250
+#define EINK_PANEL_2_13_HEIGHT 250
+#define EINK_PANEL_2_9_WIDTH 128    // 2.9" panel (SSD1680), 128x296
+#define EINK_PANEL_2_9_HEIGHT 296
+
+// Panel built into the firmware, selected with -D EINK_PANEL_<size> (PANEL variable of the makefile).
+// Its geometry is fixed at compile time so loop bounds and offsets fold into constants
+#if defined(EINK_PANEL_1_54)
+#define EINK_DISPLAY_PANEL einkPanel_1_54
+#define EINK_DISPLAY_WIDTH EINK_PANEL_1_54_WIDTH
+#define EINK_DISPLAY_HEIGHT EINK_PANEL_1_54_HEIGHT
+#elif defined(EINK_PANEL_2_9)
+#define EINK_DISPLAY_PANEL einkPanel_2_9
+#define EINK_DISPLAY_WIDTH EINK_PANEL_2_9_WIDTH
+#define EINK_DISPLAY_HEIGHT EINK_PANEL_2_9_HEIGHT
+#else
+#define EINK_DISPLAY_PANEL einkPanel_2_13
+#define EINK_DISPLAY_WIDTH EINK_PANEL_2_13_WIDTH
+#define EINK_DISPLAY_HEIGHT EINK_PANEL_2_13_HEIGHT
+#endif
+
+#define EINK_DISPLAY_STRIDE EINK_PANEL_STRIDE(EINK_DISPLAY_WIDTH)                        // Bytes per line
+#define EINK_DISPLAY_HALF_HEIGHT (EINK_DISPLAY_HEIGHT / 2)                               // Lines of each half of the display
+#define EINK_DISPLAY_HALF_SIZE EINK_PANEL_HALF_SIZE(EINK_DISPLAY_WIDTH, EINK_DISPLAY_HEIGHT) // Bytes of each half
+#define EINK_DISPLAY_FRAME_SIZE (EINK_DISPLAY_STRIDE * EINK_DISPLAY_HEIGHT)                // Bytes of a full frame
+
+// Terminates the init table of a panel descriptor
+#define EINK_PANEL_INIT_END 0xFF
+
+/* Exported TypeDefs */
+
+typedef struct EinkPanel_TypeDef EinkPanel_TypeDef;
+typedef struct EinkPaper_TypeDef EinkPaper_TypeDef;
+
+/*
+ * Operations of a panel, invoked on the display instance wired to it. The generic SSD16xx implementations are
+ * shared, while WriteRAM is specialised per panel so the frame push runs with constant bounds
+ */
+typedef struct {
+  void (*Init)(EinkPaper_TypeDef *pDisplay);                                      // Sends the init table, invoked after the SW reset
+  void (*SetWindow)(EinkPaper_TypeDef *pDisplay, uint16_t xStart,
+                    uint16_t yStart, uint16_t xEnd, uint16_t yEnd);               // Sets the RAM window (pixels) and moves the address counter to its origin
+  void (*WriteRAM)(EinkPaper_TypeDef *pDisplay, const uint8_t *pTop,
+                   const uint8_t *pBottom);                                       // Streams both halves of a frame into the black/white RAM
+  void (*Refresh)(EinkPaper_TypeDef *pDisplay);                                   // Triggers the update of the display with the RAM content
+  void (*Sleep)(EinkPaper_TypeDef *pDisplay);                                     // Enters deep sleep, a HW reset is needed to wake up
+} EinkPanel_OpsTypeDef;
+
+/*
+ * Describes a panel of the SSD16xx family: geometry, init table and operations
+ */
+struct EinkPanel_TypeDef {
+  uint16_t Width;               // Source outputs (pixels in x direction)
+  uint16_t Height;              // Gate outputs (lines in y direction)
+  uint16_t Stride;              // Bytes per line
+  uint16_t HalfSize;            // Bytes of each half of a frame
+  const uint8_t *pInitTable;    // Sequence of {command, amount of data bytes, data bytes...}, ends with EINK_PANEL_INIT_END
+  uint8_t UpdateSequence;       // Data of the display update control 2 command (0x22)
+  EinkPanel_OpsTypeDef Ops;     // Operations of the panel
+};
+
+/* Extern variables */
+
+// Supported panels
+extern const EinkPanel_TypeDef einkPanel_1_54;
+extern const EinkPanel_TypeDef einkPanel_2_13;
+extern const EinkPanel_TypeDef einkPanel_2_9;
+
+#endif // !__EINKPANEL_H__
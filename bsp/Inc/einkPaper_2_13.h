@@ -2,12 +2,14 @@
 #define __EINKPAPER_H__
 
 #include "stm32f429zi.h"
+#include "einkPanel.h"
 
-/* Extern variables */
+/* Exported macros */
+
+// Period (ms, software timer) of the Busy pin polling of a display without the Busy interruption
+#define EINK_BUSY_POLL_MS 10
 
-// Display sizes
-extern uint8_t einkDisplay_Width;
-extern uint8_t einkDisplay_Height;
+/* Extern variables */
 
 // Pointer to the current Tamgotchi image
 extern uint8_t *pImage;
@@ -15,27 +17,119 @@ extern uint8_t *pImage;
 /* Exported TypeDefs  */
 
 /*
- * Gathers the pin numbering of the used GPIO pins by the e-ink paper. All of these pins should be on the same GPIOx port
+ * Stage of a non blocking display update, advanced by eInkDisplay_Process
+ */
+typedef enum {
+ EinkPaper_State_Idle,                // No update in progress, the display accepts a new frame
+ EinkPaper_State_Wake,                // HW reset and initialization sequence of a display in deep sleep, waits on the SysTick and Busy pin
+ EinkPaper_State_WriteRAM,            // Write RAM command and both halves of the frame being streamed by the DMA stream
+ EinkPaper_State_Refresh,             // Display updating the image (Busy pin HIGH), the SPIx is free
+} EinkPaper_State;
+
+/*
+ * Defines how the chip selection of the display is driven
+ */
+typedef enum {
+ EinkPaper_CS_Software,               // CS is a GPIO output of pGPIOx, driven LOW around every transaction
+ EinkPaper_CS_Hardware,               // CS is the NSS pin of the SPIx (on pSPI_GPIOx), driven LOW by the SPIx while it transfers a burst
+} EinkPaper_CS_Mode;
+
+/*
+ * Command followed by its payload, sent as a single operation: D/C changes once and the chip selection is held
+ * for the whole transaction. Transactions are queued to the SPIx interruption
+ */
+typedef struct {
+  uint8_t Command;                    // Command byte, sent with D/C LOW
+  const uint8_t *pData;               // Payload sent with D/C HIGH, can be NULL when Len is 0
+  uint16_t Len;                       // Bytes of the payload
+} EinkPaper_TransactionTypeDef;
+
+/*
+ * e-ink paper display instance. Gathers the panel, the SPIx and DMA stream that drive it and the pin numbering of
+ * the used GPIO pins. Control pins (DC, CS, Busy and Reset) should be on the same GPIOx port, as well as the SPI pins
+ */
+struct EinkPaper_TypeDef {
+  const EinkPanel_TypeDef *pPanel;    // Panel wired to this instance, its operations drive every RAM and update command
+  SPI_DriverTypeDef SPIDriver;        // SPIx used as communication interface (only pSPIx is set by the user, configured on initialization)
+  GPIO_TypeDef *pSPI_GPIOx;           // GPIOx of the SCK and MOSI pins
+  uint8_t SCK_PinNumber;              // SPI clock pin number (alternate function)
+  uint8_t MOSI_PinNumber;             // SPI MOSI pin number (alternate function)
+  uint8_t SPI_AlternateFunction;      // Alternate function that maps the SCK and MOSI pins to the SPIx
+  IRQn_Type SPI_IRQNumber;            // Interruption of the SPIx, serves the transaction queue (its handler invokes SPI_IRQ_Handling)
+  GPIO_TypeDef *pGPIOx;               // GPIOx common to all control pins used in the display
+  uint8_t DC_PinNumber;               // Data Selection pin number (outupt), defines if the byte sent is data or a command
+  EinkPaper_CS_Mode CSMode;           // How CS is driven, values can be of EinkPaper_CS_Mode
+  uint8_t CS_PinNumber;               // Chip Selection pin number (output), notifies the display to expect new incomming data. NSS pin in hardware mode
+  uint8_t Busy_PinNumber;             // Busy Pin number (input), to inform that the display is busy, no operation should be done
+  EnableDisable BusyInterrupt;        // ENABLE: the falling edge of Busy (EXTI line) ends the waits. DISABLE: Busy is polled every EINK_BUSY_POLL_MS, for a line taken by another port
+  IRQn_Type Busy_IRQNumber;           // EXTI interruption of the Busy line, used with BusyInterrupt (the GPIO API dispatches the line)
+  uint8_t Reset_PinNumber;            // Reset Pin number (output), resets the display
+  DMA_DriverTypeDef DMADriver;        // DMA stream and channel mapped to the SPIx Tx request. With pStream NULL frames are pushed by polling
+  IRQn_Type DMA_IRQNumber;            // Interruption of the DMA stream, chains the frame segments (its handler invokes eInkDisplay_DMA_IRQHandling)
+  EinkPaper_State State;              // Stage of the current update, values can be of EinkPaper_State
+  PT_TypeDef Thread;                  // Protothread of the current update (eInkDisplay_Process)
+  PT_TypeDef WakeThread;              // Protothread of the wake up, spawned by the update or run to completion
+  uint64_t Deadline;                  // Deadline (SysTick) the protothreads wait for
+  SWTimer_TypeDef Timer;              // Signals the progress of the waits on the Deadline and of the Busy polling
+  const uint8_t *pTop;                // Top half of the frame of the current update
+  const uint8_t *pBottom;             // Bottom half of the frame of the current update
+  uint8_t Asleep;                     // Set after entering deep sleep, a HW reset and the initialization sequence are needed
+  SPI_SegmentTypeDef Segments[3];     // Frame push in flight: Write RAM command, top half and bottom half of the frame
+};
+
+/*
+ * Frame to display on an instance, used to update several displays at once
  */
 typedef struct {
-  GPIO_TypeDef *pGPIOx;         // GPIOx common to all GPIO pins used in the display
-  uint8_t DC_PinNumber;         // Data Selection pin number (outupt), defines if the byte sent is data or a command
-  uint8_t CS_PinNumber;         // Chip Selection pin number (output), notifies the display to expect new incomming data
-  uint8_t Busy_PinNumber;       // Busy Pin number (input), to inform that the display is busy, no operation should be done
-  uint8_t Reset_PinNumber;      // Reset Pin number (output), resets the display
-} EinkPaper_TypeDef;
+  EinkPaper_TypeDef *pDisplay;        // Display to update
+  const uint8_t *pTop;                // Top half of the frame (strings)
+  const uint8_t *pBottom;             // Bottom half of the frame (tamagotchi image)
+} EinkPaper_UpdateTypeDef;
+
+/* Extern variables */
 
+// Main display, SPI1 and DMA2 stream 3
+extern EinkPaper_TypeDef epaper;
+#ifdef EINK_STATUS_DISPLAY
+// Status board display, SPI2 and DMA1 stream 4
+extern EinkPaper_TypeDef epaper_status;
+#endif
 
 /* Exported functions */
 
 // Initialization function
-void eInkDisplay_Init(void);
+void eInkDisplay_Init(EinkPaper_TypeDef *pDisplay);
+
+// Power function
+DriverStatus eInkDisplay_Sleep(EinkPaper_TypeDef *pDisplay);
 
 // Clear functions
-void eInkDisplay_FillWhite(void);
-void eInkDisplay_FillBlack(void);
+void eInkDisplay_FillWhite(EinkPaper_TypeDef *pDisplay);
+void eInkDisplay_FillBlack(EinkPaper_TypeDef *pDisplay);
 
 // Display function
-void eInkDisplay_DisplayImage(uint8_t *pImage, uint8_t *character_bitmap);
+void eInkDisplay_DisplayImage(EinkPaper_TypeDef *pDisplay, const uint8_t *pImage, const uint8_t *character_bitmap);
+
+// Non blocking display functions, eInkDisplay_CallbackProgress tells when to process again
+DriverStatus eInkDisplay_StartImage(EinkPaper_TypeDef *pDisplay, const uint8_t *pImage, const uint8_t *character_bitmap);
+DriverStatus eInkDisplay_Process(EinkPaper_TypeDef *pDisplay);
+DriverStatus eInkDisplay_StartImages(EinkPaper_UpdateTypeDef *pUpdates, uint8_t Count);
+DriverStatus eInkDisplay_ProcessImages(EinkPaper_UpdateTypeDef *pUpdates, uint8_t Count);
+
+// Interruption handling of the DMA stream
+void eInkDisplay_DMA_IRQHandling(EinkPaper_TypeDef *pDisplay);
+
+// Low level functions, used by the panel operations (einkPanel.c)
+void eInkDisplay_SendData(EinkPaper_TypeDef *pDisplay, uint8_t data);
+void eInkDisplay_SendCommand(EinkPaper_TypeDef *pDisplay, uint8_t command);
+void eInkDisplay_SendBuffer(EinkPaper_TypeDef *pDisplay, const uint8_t *pData, uint16_t Len);
+void eInkDisplay_SendTransactions(EinkPaper_TypeDef *pDisplay, const EinkPaper_TransactionTypeDef *pTransactions, uint8_t Count);
+void eInkDisplay_WaitBusy(EinkPaper_TypeDef *pDisplay);
+
+// Weak implementation of callback when only the refresh of an update is left
+void eInkDisplay_CallbackRefreshing(void);
+
+// Weak implementation of callback when an update can go on (eInkDisplay_Process)
+void eInkDisplay_CallbackProgress(EinkPaper_TypeDef *pDisplay);
 
 #endif // !__EINKPAPER_H__
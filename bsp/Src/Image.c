@@ -1,5 +1,25 @@
 #include "Image.h"
 #include <stdio.h>
+#include <string.h>
+
+// The tamagotchi images are streamed as they are when they match the geometry
+// of the bottom half of the panel, otherwise they are centered on a bottom half
+// buffer
+#if (EINK_DISPLAY_STRIDE != IMAGE_SPRITE_STRIDE) ||                            \
+    (EINK_DISPLAY_HALF_HEIGHT != IMAGE_SPRITE_HEIGHT)
+#define IMAGE_COMPOSE_SPRITE
+#endif
+
+// Array representation of the top half of the display, used for drawing
+// operations. Starts white (0 is black and 1 is white). Streamed by the DMA
+uint8_t __dmabuf Image_array[EINK_DISPLAY_HALF_SIZE] = {
+    [0 ... EINK_DISPLAY_HALF_SIZE - 1] = 0xFF};
+
+#ifdef IMAGE_COMPOSE_SPRITE
+// Array representation of the bottom half of the display, holds the centered
+// tamagotchi image. Streamed by the DMA
+static uint8_t __dmabuf Image_bottomArray[EINK_DISPLAY_HALF_SIZE];
+#endif
 
 // Variables to keep track of the current character position, pos_x corresponds
 // to the x position in the x directoin of the display whereas pos_y corresponds
@@ -9,40 +29,147 @@ static uint8_t pos_x = 0;
 static uint8_t pos_y = 0;
 
 // Pointer to the current tamagotchi to display
-uint8_t *current_tamagotchi = focus_monkey;
+const uint8_t *current_tamagotchi = focus_monkey;
+
+// Updates of the displays, every display shows the same frame. The bottom half
+// is set when the update starts
+static EinkPaper_UpdateTypeDef Image_updates[] = {
+    {&epaper, Image_array, NULL},
+#ifdef EINK_STATUS_DISPLAY
+    {&epaper_status, Image_array, NULL},
+#endif
+};
+#define IMAGE_DISPLAYS (sizeof(Image_updates) / sizeof(Image_updates[0]))
 
 /* Static functions */
-static void Image_drawChar(uint8_t *c);
+static __ramfunc void Image_drawChar(uint8_t *c);
+#ifdef IMAGE_COMPOSE_SPRITE
+static void Image_composeSprite(const uint8_t *pSprite);
+#endif
 
 /*
- * Displays the current array in the e-ink paper
+ * Starts displaying the current array on every display, without waiting for
+ * the updates to end. Image_processImage must be invoked until it returns OK.
+ * The arrays are streamed by the DMA until then, a frame drawn meanwhile may
+ * be partly sent and is shown whole by the next update
  *
  * Params:
  *    * None
  * Returns:
- *    * None
+ *    * DriverStatus, BUSY while the previous update is in progress (nothing is
+ * started)
  */
-void Image_displayImage(void) {
+DriverStatus Image_displayImage(void) {
+    if (Image_processImage() != OK) {
+        return BUSY;
+    }
+
+#ifdef IMAGE_COMPOSE_SPRITE
+    Image_composeSprite(current_tamagotchi);
+    const uint8_t *pBottom = Image_bottomArray;
+#else
+    const uint8_t *pBottom = current_tamagotchi;
+#endif
+
+    for (uint8_t i = 0; i < IMAGE_DISPLAYS; i++) {
+        Image_updates[i].pBottom = pBottom;
+    }
+
     // Invoking the bsp e-ink function
-    eInkDisplay_DisplayImage(Image_array, current_tamagotchi);
+    return eInkDisplay_StartImages(Image_updates, IMAGE_DISPLAYS);
+}
+
+/*
+ * Advances the updates started by Image_displayImage, never waits
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * DriverStatus, BUSY while a display is updating, OK once every display
+ * is idle
+ */
+DriverStatus Image_processImage(void) {
+    return eInkDisplay_ProcessImages(Image_updates, IMAGE_DISPLAYS);
+}
+
+/*
+ * Puts every display in deep sleep, they keep the image shown
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * DriverStatus, BUSY while a display is updating (it is not put to sleep)
+ */
+DriverStatus Image_sleepDisplays(void) {
+    DriverStatus status = OK;
+
+    for (uint8_t i = 0; i < IMAGE_DISPLAYS; i++) {
+        if (eInkDisplay_Sleep(Image_updates[i].pDisplay) != OK) {
+            status = BUSY;
+        }
+    }
+    return status;
+}
+
+#ifdef IMAGE_COMPOSE_SPRITE
+/*
+ * Centers a tamagotchi image on the bottom half of the display, cropping it
+ * when the panel is smaller than the image
+ *
+ * Params:
+ *    * pSprite, a pointer to a 8 bit-wide integer with the tamagotchi image
+ * Returns:
+ *    * None
+ */
+static void Image_composeSprite(const uint8_t *pSprite) {
+    // Lines and bytes per line copied from the image
+    const uint16_t lines = (IMAGE_SPRITE_HEIGHT < EINK_DISPLAY_HALF_HEIGHT)
+                               ? IMAGE_SPRITE_HEIGHT
+                               : EINK_DISPLAY_HALF_HEIGHT;
+    const uint16_t bytes = (IMAGE_SPRITE_STRIDE < EINK_DISPLAY_STRIDE)
+                               ? IMAGE_SPRITE_STRIDE
+                               : EINK_DISPLAY_STRIDE;
+
+    // Offsets that center the image, in lines and bytes
+    const uint16_t dst_y = (EINK_DISPLAY_HALF_HEIGHT - lines) / 2;
+    const uint16_t dst_x = (EINK_DISPLAY_STRIDE - bytes) / 2;
+    const uint16_t src_y = (IMAGE_SPRITE_HEIGHT - lines) / 2;
+    const uint16_t src_x = (IMAGE_SPRITE_STRIDE - bytes) / 2;
+
+    // Padding bits of the last byte of every line of the image (122 pixels
+    // leave 6 bits), set as white when the whole line is copied
+    const uint8_t padding =
+        (bytes == IMAGE_SPRITE_STRIDE)
+            ? (1 << (8 * IMAGE_SPRITE_STRIDE - IMAGE_SPRITE_WIDTH)) - 1
+            : 0;
+
+    memset(Image_bottomArray, 0xFF, EINK_DISPLAY_HALF_SIZE);
+    for (uint16_t y = 0; y < lines; y++) {
+        uint8_t *pLine =
+            &Image_bottomArray[(dst_y + y) * EINK_DISPLAY_STRIDE + dst_x];
+        memcpy(pLine, &pSprite[(src_y + y) * IMAGE_SPRITE_STRIDE + src_x],
+               bytes);
+        pLine[bytes - 1] |= padding;
+    }
 }
+#endif
 
 /*
- * Draws a single char in the curent position (pos_x, pos_y)
+ * Draws a single char in the curent position (pos_x, pos_y). Runs from SRAM
+ * (__ramfunc), every string blits its glyphs through it
  *
  * Params:
  *    * c, a pointer to a 8 bit-wide integer which is the desired char to draw
  * Returns:
  *    * None
  */
-static void Image_drawChar(uint8_t *c) {
+static __ramfunc void Image_drawChar(uint8_t *c) {
     // Finding the character possition in alphaNumbers array (starts with '0')
     uint8_t letterNumber = *c - (uint8_t)'0';
 
-    // Image (array representation of the display) is 16 bytes width (122 pixels
-    // / 8 bits), each char occupies 2 bytes:
-    uint8_t display_width = (einkDisplay_Width / 8) + 1;
-    uint8_t chars_in_x = display_width / char_width - 1;
+    // Image (array representation of the display) is EINK_DISPLAY_STRIDE bytes
+    // width (122 pixels / 8 bits), each char occupies 2 bytes:
+    uint8_t chars_in_x = EINK_DISPLAY_STRIDE / char_width - 1;
 
     // If the char is an space, there's no need of modifying the Image array
     if (*c != ' ') {
@@ -55,8 +182,8 @@ static void Image_drawChar(uint8_t *c) {
                 // the char is at y * char_widt (since each line in y direction
                 // has 2 bytes of the x direction) plus an offset corresponding
                 // to the ascii number in the array
-                Image_array[(y * display_width) +
-                            (display_width * char_height * pos_y) + (x) +
+                Image_array[(y * EINK_DISPLAY_STRIDE) +
+                            (EINK_DISPLAY_STRIDE * char_height * pos_y) + (x) +
                             (pos_x * 2)] =
                     alphaNumbers[x + (y * char_width) +
                                  (letterNumber * char_height * char_width)];
@@ -69,7 +196,7 @@ static void Image_drawChar(uint8_t *c) {
     pos_x %= chars_in_x;
     if ((pos_x) == 0) {
         pos_y++;
-        pos_y %= display_width;
+        pos_y %= EINK_DISPLAY_HALF_HEIGHT / char_height;
     }
 }
 
@@ -84,8 +211,7 @@ static void Image_drawChar(uint8_t *c) {
 void Image_clearStrings(void) {
 
     // Get the maximum amounf of chars that fit in x direction
-    uint8_t display_width = (einkDisplay_Width / 8) + 1;
-    uint8_t chars_in_x = display_width / char_width - 1;
+    uint8_t chars_in_x = EINK_DISPLAY_STRIDE / char_width - 1;
 
     // Find the amount of already written chars to clear
     uint8_t amountOfChars = (pos_y * chars_in_x) + (pos_x);
@@ -136,8 +262,8 @@ void Image_drawString(uint8_t *c) {
  */
 void Image_drawMinutesLeft(uint16_t minutesLeft) {
 
-    // Draw in the fourth line
-    pos_y = 4;
+    // Draw in the last line of the top half (fourth line in the 2.13 panel)
+    pos_y = EINK_DISPLAY_HALF_HEIGHT / char_height - 1;
 
     // Create a buffer to contain a string
     char buf[8];
@@ -166,7 +292,7 @@ void Image_clearMinutesLeft(void) {
 
     // Sets the cursos at the beginning of the minutes left line
     pos_x = 0;
-    pos_y = 4;
+    pos_y = EINK_DISPLAY_HALF_HEIGHT / char_height - 1;
 
     // Use a character that has no representation in the alphaNumbers array
     uint8_t c = ':';
@@ -9,7 +9,7 @@ uint8_t char_width = 2;
 
 // Exported array, contains the array representation of each character
 
-uint8_t alphaNumbers[] = {
+const uint8_t alphaNumbers[] = {
     // 0 : ascii 0x30, 0
     //        v
     0b11111111, 0b11111111, // 1111111111111111
@@ -0,0 +1,230 @@
+#include "button.h"
+
+/* Static functions */
+static void Button_Debounced(SWTimer_TypeDef *pTimer);
+static void Button_Confirm(Button_TypeDef *pButton, uint8_t Pressed);
+static void Button_GestureExpired(SWTimer_TypeDef *pTimer);
+static void Button_Pressed(Button_TypeDef *pButton);
+static void Button_Released(Button_TypeDef *pButton);
+
+/*
+ * Initializes the button pin with an interruption on both edges and the
+ * gesture recognizer. The interruption must invoke Button_IRQHandling and the
+ * edges must be passed to Button_Edge out of it. Must be invoked after
+ * SWTimer_Init
+ *
+ * Params:
+ *    * pButton, pointer to the Button_TypeDef with the pin and its active level
+ * set
+ * Returns:
+ *    * None
+ */
+void Button_Init(Button_TypeDef *pButton) {
+    pButton->GPIODriver.Config.Mode = GPIO_Mode_Input;
+    pButton->GPIODriver.InterruptMode = GPIO_It_RiseFall;
+    GPIO_Init(&pButton->GPIODriver);
+
+    pButton->DebounceTimer = (SWTimer_TypeDef){.Callback = Button_Debounced,
+                                               .pContext = pButton};
+    pButton->GestureTimer = (SWTimer_TypeDef){
+        .Callback = Button_GestureExpired, .pContext = pButton};
+
+    // A button held at initialization reports no gesture until released
+    pButton->Pressed = (GPIO_Pin_Read(pButton->GPIODriver.pGPIOx,
+                                      pButton->GPIODriver.Config.Number) ==
+                        pButton->ActiveLevel);
+    pButton->State =
+        pButton->Pressed ? Button_State_Held : Button_State_Released;
+}
+
+/*
+ * Handles an edge of the button in its interruption. The line is masked until
+ * the level is confirmed, the bounces raise no more interruptions. Lock-free,
+ * it only records the time and the level of the edge
+ *
+ * Params:
+ *    * pButton, pointer to the Button_TypeDef
+ * Returns:
+ *    * Button_EdgeTypeDef, the edge, passed to Button_Edge
+ */
+Button_EdgeTypeDef Button_IRQHandling(Button_TypeDef *pButton) {
+    Button_EdgeTypeDef edge;
+
+    GPIO_IRQ_LineControl(pButton->GPIODriver.Config.Number, DISABLE);
+    edge.Ms = SysTick_GetMs32();
+    edge.Pressed = (GPIO_Pin_Read(pButton->GPIODriver.pGPIOx,
+                                  pButton->GPIODriver.Config.Number) ==
+                    pButton->ActiveLevel);
+
+    return edge;
+}
+
+/*
+ * Starts the debounce of an edge, the level is read once BUTTON_DEBOUNCE_MS
+ * have elapsed since the edge. Invoked out of the interruption (task) with the
+ * edge returned by Button_IRQHandling
+ *
+ * Params:
+ *    * pButton, pointer to the Button_TypeDef
+ *    * pEdge, pointer to the Button_EdgeTypeDef of the edge (copied)
+ * Returns:
+ *    * None
+ */
+void Button_Edge(Button_TypeDef *pButton, const Button_EdgeTypeDef *pEdge) {
+    uint32_t elapsed = SysTick_GetMs32() - pEdge->Ms;
+    uint32_t left = 0;
+
+    pButton->Edge = *pEdge;
+
+    if (elapsed < BUTTON_DEBOUNCE_MS) {
+        left = BUTTON_DEBOUNCE_MS - elapsed;
+    }
+    SWTimer_Start(&pButton->DebounceTimer, left);
+}
+
+/*
+ * Weak implementation of the gesture callback, overriden in user layer. It
+ * runs from the deferred work (PendSV)
+ *
+ * Params:
+ *    * pButton, pointer to the Button_TypeDef
+ *    * Gesture, the recognized gesture, values can be of Button_Gesture
+ * Returns:
+ *    * None
+ */
+__weak void Button_CallbackGesture(Button_TypeDef *pButton,
+                                   Button_Gesture Gesture) {
+    (void)pButton;
+    (void)Gesture;
+}
+
+/*
+ * Confirms the level of the button once the debounce time has elapsed, a
+ * level back to the confirmed one was a bounce. A confirmation run late (the
+ * task was delayed, i.e. by a display update) applies the level recorded at the
+ * edge first: a short press may have ended while the line was masked. Invoked
+ * by the SWTimer API
+ *
+ * Params:
+ *    * pTimer, pointer to the debounce timer of the button
+ * Returns:
+ *    * None
+ */
+static void Button_Debounced(SWTimer_TypeDef *pTimer) {
+    Button_TypeDef *pButton = pTimer->pContext;
+    uint32_t elapsed = SysTick_GetMs32() - pButton->Edge.Ms;
+    uint8_t pressed;
+
+    // The line is unmasked before the level is read, an edge from here on
+    // raises a new interruption and is debounced again
+    GPIO_IRQ_LineControl(pButton->GPIODriver.Config.Number, ENABLE);
+    pressed = (GPIO_Pin_Read(pButton->GPIODriver.pGPIOx,
+                             pButton->GPIODriver.Config.Number) ==
+               pButton->ActiveLevel);
+
+    if (elapsed > BUTTON_DEBOUNCE_MS + BUTTON_LATE_MS) {
+        Button_Confirm(pButton, pButton->Edge.Pressed);
+    }
+    Button_Confirm(pButton, pressed);
+}
+
+/*
+ * Applies a confirmed level to the gesture recognizer, the same level as the
+ * confirmed one is ignored
+ *
+ * Params:
+ *    * pButton, pointer to the Button_TypeDef
+ *    * Pressed, an 8 bit-wide integer with the level, 1 if pressed
+ * Returns:
+ *    * None
+ */
+static void Button_Confirm(Button_TypeDef *pButton, uint8_t Pressed) {
+    if (Pressed == pButton->Pressed) {
+        return;
+    }
+    pButton->Pressed = Pressed;
+
+    if (Pressed) {
+        Button_Pressed(pButton);
+    } else {
+        Button_Released(pButton);
+    }
+}
+
+/*
+ * Ends the long press and the double press windows. Invoked by the SWTimer
+ * API
+ *
+ * Params:
+ *    * pTimer, pointer to the gesture timer of the button
+ * Returns:
+ *    * None
+ */
+static void Button_GestureExpired(SWTimer_TypeDef *pTimer) {
+    Button_TypeDef *pButton = pTimer->pContext;
+
+    switch (pButton->State) {
+    case Button_State_Pressed:
+        // Still held, reported at once and the release is ignored
+        pButton->State = Button_State_Held;
+        Button_CallbackGesture(pButton, Button_Gesture_Long);
+        break;
+    case Button_State_WaitSecond:
+        // No second press followed
+        pButton->State = Button_State_Released;
+        Button_CallbackGesture(pButton, Button_Gesture_Short);
+        break;
+    default:
+        break;
+    }
+}
+
+/*
+ * Handles a confirmed press
+ *
+ * Params:
+ *    * pButton, pointer to the Button_TypeDef
+ * Returns:
+ *    * None
+ */
+static void Button_Pressed(Button_TypeDef *pButton) {
+    switch (pButton->State) {
+    case Button_State_Released:
+        pButton->State = Button_State_Pressed;
+        SWTimer_Start(&pButton->GestureTimer, BUTTON_LONG_MS);
+        break;
+    case Button_State_WaitSecond:
+        pButton->State = Button_State_SecondPress;
+        SWTimer_Stop(&pButton->GestureTimer);
+        break;
+    default:
+        break;
+    }
+}
+
+/*
+ * Handles a confirmed release
+ *
+ * Params:
+ *    * pButton, pointer to the Button_TypeDef
+ * Returns:
+ *    * None
+ */
+static void Button_Released(Button_TypeDef *pButton) {
+    switch (pButton->State) {
+    case Button_State_Pressed:
+        // Short so far, a second press may follow
+        pButton->State = Button_State_WaitSecond;
+        SWTimer_Start(&pButton->GestureTimer, BUTTON_DOUBLE_MS);
+        break;
+    case Button_State_SecondPress:
+        pButton->State = Button_State_Released;
+        Button_CallbackGesture(pButton, Button_Gesture_Double);
+        break;
+    case Button_State_Held:
+        pButton->State = Button_State_Released;
+        break;
+    default:
+        break;
+    }
+}
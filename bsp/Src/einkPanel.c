@@ -0,0 +1,289 @@
+#include "einkPaper_2_13.h"
+
+/* Static functions */
+static void eInkPanel_Init(EinkPaper_TypeDef *pDisplay);
+static void eInkPanel_SetWindow(EinkPaper_TypeDef *pDisplay, uint16_t xStart,
+                                uint16_t yStart, uint16_t xEnd, uint16_t yEnd);
+static void eInkPanel_Refresh(EinkPaper_TypeDef *pDisplay);
+static void eInkPanel_Sleep(EinkPaper_TypeDef *pDisplay);
+static void eInkPanel_1_54_WriteRAM(EinkPaper_TypeDef *pDisplay,
+                                    const uint8_t *pTop,
+                                    const uint8_t *pBottom);
+static void eInkPanel_2_13_WriteRAM(EinkPaper_TypeDef *pDisplay,
+                                    const uint8_t *pTop,
+                                    const uint8_t *pBottom);
+static void eInkPanel_2_9_WriteRAM(EinkPaper_TypeDef *pDisplay,
+                                   const uint8_t *pTop,
+                                   const uint8_t *pBottom);
+
+/* Init tables */
+
+// Every entry is {command, amount of data bytes, data bytes...}:
+//    * Driver output control (0x01):
+//        [8:0]: MUX Gate lines - 1
+//        [2:0]: Gate scanning sequence, 0 scans from gate 0 in sequential
+//        order, from button to top
+//    * Data entry mode (0x11): y increment, x increment, updating the
+//    address counter in x direction (0x03)
+//    * Border waveform control (0x3C)
+//    * Display update control 1 (0x21): normal RAM content, source output
+//    mode S8..S167 (only SSD1680)
+//    * Temperature sensor control (0x18): internal temperature sensor (0x80)
+
+// clang-format off
+
+static const uint8_t eInkPanel_1_54_InitTable[] = {
+    0x01, 3, (EINK_PANEL_1_54_HEIGHT - 1) & 0xFF, (EINK_PANEL_1_54_HEIGHT - 1) >> 8, 0x00,
+    0x11, 1, 0x03,
+    0x3C, 1, 0x05,
+    0x18, 1, 0x80,
+    EINK_PANEL_INIT_END,
+};
+
+static const uint8_t eInkPanel_2_13_InitTable[] = {
+    0x01, 3, (EINK_PANEL_2_13_HEIGHT - 1) & 0xFF, (EINK_PANEL_2_13_HEIGHT - 1) >> 8, 0x00,
+    0x11, 1, 0x03,
+    0x3C, 1, 0x05,
+    0x21, 2, 0x00, 0x80,
+    0x18, 1, 0x80,
+    EINK_PANEL_INIT_END,
+};
+
+static const uint8_t eInkPanel_2_9_InitTable[] = {
+    0x01, 3, (EINK_PANEL_2_9_HEIGHT - 1) & 0xFF, (EINK_PANEL_2_9_HEIGHT - 1) >> 8, 0x00,
+    0x11, 1, 0x03,
+    0x3C, 1, 0x05,
+    0x21, 2, 0x00, 0x80,
+    0x18, 1, 0x80,
+    EINK_PANEL_INIT_END,
+};
+// clang-format on
+
+/* Panel descriptors */
+
+const EinkPanel_TypeDef einkPanel_1_54 = {
+    .Width = EINK_PANEL_1_54_WIDTH,
+    .Height = EINK_PANEL_1_54_HEIGHT,
+    .Stride = EINK_PANEL_STRIDE(EINK_PANEL_1_54_WIDTH),
+    .HalfSize =
+        EINK_PANEL_HALF_SIZE(EINK_PANEL_1_54_WIDTH, EINK_PANEL_1_54_HEIGHT),
+    .pInitTable = eInkPanel_1_54_InitTable,
+    .UpdateSequence = 0xF7,
+    .Ops = {eInkPanel_Init, eInkPanel_SetWindow, eInkPanel_1_54_WriteRAM,
+            eInkPanel_Refresh, eInkPanel_Sleep},
+};
+
+const EinkPanel_TypeDef einkPanel_2_13 = {
+    .Width = EINK_PANEL_2_13_WIDTH,
+    .Height = EINK_PANEL_2_13_HEIGHT,
+    .Stride = EINK_PANEL_STRIDE(EINK_PANEL_2_13_WIDTH),
+    .HalfSize =
+        EINK_PANEL_HALF_SIZE(EINK_PANEL_2_13_WIDTH, EINK_PANEL_2_13_HEIGHT),
+    .pInitTable = eInkPanel_2_13_InitTable,
+    .UpdateSequence = 0xF7,
+    .Ops = {eInkPanel_Init, eInkPanel_SetWindow, eInkPanel_2_13_WriteRAM,
+            eInkPanel_Refresh, eInkPanel_Sleep},
+};
+
+const EinkPanel_TypeDef einkPanel_2_9 = {
+    .Width = EINK_PANEL_2_9_WIDTH,
+    .Height = EINK_PANEL_2_9_HEIGHT,
+    .Stride = EINK_PANEL_STRIDE(EINK_PANEL_2_9_WIDTH),
+    .HalfSize =
+        EINK_PANEL_HALF_SIZE(EINK_PANEL_2_9_WIDTH, EINK_PANEL_2_9_HEIGHT),
+    .pInitTable = eInkPanel_2_9_InitTable,
+    .UpdateSequence = 0xF7,
+    .Ops = {eInkPanel_Init, eInkPanel_SetWindow, eInkPanel_2_9_WriteRAM,
+            eInkPanel_Refresh, eInkPanel_Sleep},
+};
+
+/*
+ * Sends the init table of the panel, invoked after the SW reset
+ *
+ * Params:
+ *    * pDisplay, a pointer to the EinkPaper_TypeDef of the display
+ * Returns:
+ *    * None
+ */
+static void eInkPanel_Init(EinkPaper_TypeDef *pDisplay) {
+    const uint8_t *pEntry = pDisplay->pPanel->pInitTable;
+
+    while (*pEntry != EINK_PANEL_INIT_END) {
+        // First byte is the command, followed by the amount of data bytes. The
+        // entry is sent as a single transaction
+        EinkPaper_TransactionTypeDef transaction = {pEntry[0], &pEntry[2],
+                                                    pEntry[1]};
+        eInkDisplay_SendTransactions(pDisplay, &transaction, 1);
+        pEntry += 2 + pEntry[1];
+    }
+}
+
+/*
+ * Sets the RAM window and moves the RAM address counter to its origin
+ *
+ * Params:
+ *    * pDisplay, a pointer to the EinkPaper_TypeDef of the display
+ *    * xStart, xEnd, 16 bit-wide integers with the first and last pixel in x
+ * direction
+ *    * yStart, yEnd, 16 bit-wide integers with the first and last line in y
+ * direction
+ * Returns:
+ *    * None
+ */
+static void eInkPanel_SetWindow(EinkPaper_TypeDef *pDisplay, uint16_t xStart,
+                                uint16_t yStart, uint16_t xEnd, uint16_t yEnd) {
+
+    // Set RAM x address start/end position (0x44) data:
+    //    [5:0]: x RAM start position
+    //    [5:0]: x RAM end position
+    // by every RAM unit (8 bits)
+    const uint8_t xWindow[] = {xStart / 8, xEnd / 8};
+
+    // Set RAM y address start/end position (0x45) data:
+    //    [8:0]: y RAM start position
+    //    [8:0]: y RAM end position
+    const uint8_t yWindow[] = {
+        yStart & 0xFF, // [7:0]
+        yStart >> 8,   // [8]
+        yEnd & 0xFF,   // [7:0]
+        yEnd >> 8,     // [8]
+    };
+
+    // Set RAM x/y Counter (0x4E/0x4F) data, the window origin
+    const uint8_t xCounter[] = {xStart / 8};
+    const uint8_t yCounter[] = {yStart & 0xFF, yStart >> 8};
+
+    const EinkPaper_TransactionTypeDef transactions[] = {
+        {0x44, xWindow, sizeof(xWindow)},
+        {0x45, yWindow, sizeof(yWindow)},
+        {0x4E, xCounter, sizeof(xCounter)},
+        {0x4F, yCounter, sizeof(yCounter)},
+    };
+
+    eInkDisplay_SendTransactions(pDisplay, transactions, 4);
+}
+
+/*
+ * Updates the image on the display with the RAM content. Does not wait for the
+ * display to end the update
+ *
+ * Params:
+ *    * pDisplay, a pointer to the EinkPaper_TypeDef of the display
+ * Returns:
+ *    * None
+ */
+static void eInkPanel_Refresh(EinkPaper_TypeDef *pDisplay) {
+    // Command: Display update control 2 (0x22), followed by the Master
+    // activation (0x20)
+    const EinkPaper_TransactionTypeDef transactions[] = {
+        {0x22, &pDisplay->pPanel->UpdateSequence, 1},
+        {0x20, NULL, 0},
+    };
+
+    eInkDisplay_SendTransactions(pDisplay, transactions, 2);
+}
+
+/*
+ * Enters deep sleep mode, the display keeps the image with no energy supplied
+ *
+ * Params:
+ *    * pDisplay, a pointer to the EinkPaper_TypeDef of the display
+ * Returns:
+ *    * None
+ */
+static void eInkPanel_Sleep(EinkPaper_TypeDef *pDisplay) {
+
+    // Command: Deep sleep mode (0x10)
+    // Data:
+    //    [1:0]: 00 normal mode, 01 deep sleep mode 1 (RAM retained)
+    const uint8_t mode = 0x01;
+    const EinkPaper_TransactionTypeDef transaction = {0x10, &mode, 1};
+
+    eInkDisplay_SendTransactions(pDisplay, &transaction, 1);
+}
+
+/*
+ * Streams both halves of a frame into the black/white RAM. Inlined in the
+ * WriteRAM operation of every panel so HalfSize folds into a constant
+ *
+ * Params:
+ *    * pDisplay, a pointer to the EinkPaper_TypeDef of the display
+ *    * pTop, a pointer to a 8 bit-wide integer with the top half of the frame
+ *    * pBottom, a pointer to a 8 bit-wide integer with the bottom half
+ *    * HalfSize, a 16 bit-wide integer with the bytes of each half
+ * Returns:
+ *    * None
+ */
+static inline __attribute__((always_inline)) void
+eInkPanel_StreamHalves(EinkPaper_TypeDef *pDisplay, const uint8_t *pTop,
+                       const uint8_t *pBottom, const uint16_t HalfSize) {
+    // The SPIx stays enabled across the command and both halves
+    SPI_OpenSession(&pDisplay->SPIDriver);
+
+    // Command: Write to RAM (0x24)
+    eInkDisplay_SendCommand(pDisplay, 0x24);
+
+    // Both halves are 1-D arrays laid out line by line, the same order the RAM
+    // address counter follows (x increment, then y increment), so they are
+    // streamed as a flat sequence of bytes
+    eInkDisplay_SendBuffer(pDisplay, pTop, HalfSize);
+
+    // The RAM address counter continues where the top half ended
+    eInkDisplay_SendBuffer(pDisplay, pBottom, HalfSize);
+
+    SPI_CloseSession(&pDisplay->SPIDriver);
+}
+
+/*
+ * Write RAM operation of the 1.54" panel
+ *
+ * Params:
+ *    * pDisplay, a pointer to the EinkPaper_TypeDef of the display
+ *    * pTop, a pointer to a 8 bit-wide integer with the top half of the frame
+ *    * pBottom, a pointer to a 8 bit-wide integer with the bottom half
+ * Returns:
+ *    * None
+ */
+static void eInkPanel_1_54_WriteRAM(EinkPaper_TypeDef *pDisplay,
+                                    const uint8_t *pTop,
+                                    const uint8_t *pBottom) {
+    eInkPanel_StreamHalves(
+        pDisplay, pTop, pBottom,
+        EINK_PANEL_HALF_SIZE(EINK_PANEL_1_54_WIDTH, EINK_PANEL_1_54_HEIGHT));
+}
+
+/*
+ * Write RAM operation of the 2.13" panel
+ *
+ * Params:
+ *    * pDisplay, a pointer to the EinkPaper_TypeDef of the display
+ *    * pTop, a pointer to a 8 bit-wide integer with the top half of the frame
+ *    * pBottom, a pointer to a 8 bit-wide integer with the bottom half
+ * Returns:
+ *    * None
+ */
+static void eInkPanel_2_13_WriteRAM(EinkPaper_TypeDef *pDisplay,
+                                    const uint8_t *pTop,
+                                    const uint8_t *pBottom) {
+    eInkPanel_StreamHalves(
+        pDisplay, pTop, pBottom,
+        EINK_PANEL_HALF_SIZE(EINK_PANEL_2_13_WIDTH, EINK_PANEL_2_13_HEIGHT));
+}
+
+/*
+ * Write RAM operation of the 2.9" panel
+ *
+ * Params:
+ *    * pDisplay, a pointer to the EinkPaper_TypeDef of the display
+ *    * pTop, a pointer to a 8 bit-wide integer with the top half of the frame
+ *    * pBottom, a pointer to a 8 bit-wide integer with the bottom half
+ * Returns:
+ *    * None
+ */
+static void eInkPanel_2_9_WriteRAM(EinkPaper_TypeDef *pDisplay,
+                                   const uint8_t *pTop,
+                                   const uint8_t *pBottom) {
+    eInkPanel_StreamHalves(
+        pDisplay, pTop, pBottom,
+        EINK_PANEL_HALF_SIZE(EINK_PANEL_2_9_WIDTH, EINK_PANEL_2_9_HEIGHT));
+}
@@ -1,95 +1,248 @@
 #include "einkPaper_2_13.h"
+#include <string.h>
 
 /* Global variables */
-EinkPaper_TypeDef epaper_2_13;
-SPI_DriverTypeDef spi1;
 
-// Display dimensions
-uint8_t einkDisplay_Width = 122;
-uint8_t einkDisplay_Height = 250;
+// Main display: SPI1 (SCK PA5, MOSI PA7), control pins on GPIOB. SPI1_TX is
+// served by DMA2 stream 3, channel 3. With EINK_HW_NSS, CS is wired to
+// SPI1_NSS (PA4). The instance is only accessed by the CPU
+__ccmram EinkPaper_TypeDef epaper = {
+    .pPanel = &EINK_DISPLAY_PANEL,
+    .SPIDriver = {.pSPIx = SPI1},
+    .pSPI_GPIOx = GPIOA,
+    .SCK_PinNumber = 5,
+    .MOSI_PinNumber = 7,
+    .SPI_AlternateFunction = 5,
+    .SPI_IRQNumber = SPI1_IRQn,
+    .pGPIOx = GPIOB,
+    .DC_PinNumber = 2,
+#ifdef EINK_HW_NSS
+    .CSMode = EinkPaper_CS_Hardware,
+    .CS_PinNumber = 4,
+#else
+    .CSMode = EinkPaper_CS_Software,
+    .CS_PinNumber = 0,
+#endif
+    .Busy_PinNumber = 5,
+    .BusyInterrupt = ENABLE,
+    .Busy_IRQNumber = EXTI9_5_IRQn,
+    .Reset_PinNumber = 8,
+    .DMADriver = {.pStream = DMA2_Stream3, .Config = {.Channel = 3}},
+    .DMA_IRQNumber = DMA2_Stream3_IRQn,
+};
+
+#ifdef EINK_STATUS_DISPLAY
+// Status board display: SPI2 (SCK PB13, MOSI PB15), control pins on GPIOD.
+// SPI2_TX is served by DMA1 stream 4, channel 0. With EINK_HW_NSS, CS is wired
+// to SPI2_NSS (PB12). The instance is only accessed by the CPU
+__ccmram EinkPaper_TypeDef epaper_status = {
+    .pPanel = &EINK_DISPLAY_PANEL,
+    .SPIDriver = {.pSPIx = SPI2},
+    .pSPI_GPIOx = GPIOB,
+    .SCK_PinNumber = 13,
+    .MOSI_PinNumber = 15,
+    .SPI_AlternateFunction = 5,
+    .SPI_IRQNumber = SPI2_IRQn,
+    .pGPIOx = GPIOD,
+    .DC_PinNumber = 15,
+#ifdef EINK_HW_NSS
+    .CSMode = EinkPaper_CS_Hardware,
+    .CS_PinNumber = 12,
+#else
+    .CSMode = EinkPaper_CS_Software,
+    .CS_PinNumber = 14,
+#endif
+    // Busy (PD13) shares the EXTI line 13 with the button (PC13), it is polled
+    .Busy_PinNumber = 13,
+    .BusyInterrupt = DISABLE,
+    .Reset_PinNumber = 12,
+    .DMADriver = {.pStream = DMA1_Stream4, .Config = {.Channel = 0}},
+    .DMA_IRQNumber = DMA1_Stream4_IRQn,
+};
+#endif
 
 /* Static functions */
-static void eInkDisplay_GPIO_Init(void);
-static void eInkDisplay_SPI_Init(void);
-static void eInkDisplay_Sequence_Init(void);
-static void eInkDisplay_HW_Reset(void);
-static void eInkDisplay_SendData(uint8_t data);
-static void eInkDisplay_SendCommand(uint8_t command);
-static void eInkDisplay_UpdateDisplay(void);
+static void eInkDisplay_GPIO_Init(EinkPaper_TypeDef *pDisplay);
+static void eInkDisplay_SPI_Init(EinkPaper_TypeDef *pDisplay);
+static void eInkDisplay_DMA_Init(EinkPaper_TypeDef *pDisplay);
+static DriverStatus eInkDisplay_WakeSteps(EinkPaper_TypeDef *pDisplay);
+static void eInkDisplay_Wake(EinkPaper_TypeDef *pDisplay);
+static DriverStatus eInkDisplay_Update(EinkPaper_TypeDef *pDisplay);
+static uint8_t eInkDisplay_Elapsed(EinkPaper_TypeDef *pDisplay);
+static uint8_t eInkDisplay_Ready(EinkPaper_TypeDef *pDisplay);
+static uint8_t eInkDisplay_Streamed(EinkPaper_TypeDef *pDisplay);
+static uint8_t eInkDisplay_Transferring(EinkPaper_UpdateTypeDef *pUpdates,
+                                        uint8_t Count);
+static void eInkDisplay_BusyIRQ(uint8_t PinNumber, void *pContext);
+static void eInkDisplay_TimerExpired(SWTimer_TypeDef *pTimer);
+static void eInkDisplay_UpdateDisplay(EinkPaper_TypeDef *pDisplay);
+static void eInkDisplay_SendPayload(EinkPaper_TypeDef *pDisplay,
+                                    const uint8_t *pData, uint16_t Len);
+static void eInkDisplay_QueuePush(EinkPaper_TypeDef *pDisplay,
+                                  const SPI_DescriptorTypeDef *pDescriptor);
+static void eInkDisplay_QueueWait(EinkPaper_TypeDef *pDisplay, uint8_t Free);
 
 /*
- * Initialazes the Display
+ * Selects the display with the D/C level of the following bytes. In software
+ * mode D/C and CS change in one write, in hardware mode the SPIx drives CS.
+ * Within an SPIx session the pins change once the previous bytes are shifted
+ * out
  *
  * Params:
+ *    * pDisplay, a pointer to the EinkPaper_TypeDef of the display
+ *    * DC, a PinLogicalLevel with the D/C level (LOW command, HIGH data)
+ * Returns:
  *    * None
+ */
+static inline void eInkDisplay_Select(EinkPaper_TypeDef *pDisplay,
+                                      PinLogicalLevel DC) {
+    uint16_t dc = (1U << pDisplay->DC_PinNumber);
+    uint16_t cs = (pDisplay->CSMode == EinkPaper_CS_Software)
+                      ? (1U << pDisplay->CS_PinNumber)
+                      : 0;
+
+    SPI_Flush(&pDisplay->SPIDriver);
+    if (DC == HIGH) {
+        GPIO_Port_Write(pDisplay->pGPIOx, dc, cs);
+    } else {
+        GPIO_Port_Write(pDisplay->pGPIOx, 0, dc | cs);
+    }
+}
+
+/*
+ * Releases the chip selection, only needed in software mode
+ *
+ * Params:
+ *    * pDisplay, a pointer to the EinkPaper_TypeDef of the display
+ * Returns:
+ *    * None
+ */
+static inline void eInkDisplay_Deselect(EinkPaper_TypeDef *pDisplay) {
+    if (pDisplay->CSMode == EinkPaper_CS_Software) {
+        SPI_Flush(&pDisplay->SPIDriver);
+        GPIO_Pin_Set(pDisplay->pGPIOx, pDisplay->CS_PinNumber);
+    }
+}
+
+/*
+ * Initialazes the Display. The initialization sequence of the display is run
+ * by the first update, as after a deep sleep. Must be invoked after
+ * SWTimer_Init
+ *
+ * Params:
+ *    * pDisplay, a pointer to the EinkPaper_TypeDef of the display
  * Returns:
  *    * None
  */
-void eInkDisplay_Init(void) {
+void eInkDisplay_Init(EinkPaper_TypeDef *pDisplay) {
+
+    pDisplay->State = EinkPaper_State_Idle;
+    pDisplay->Timer = (SWTimer_TypeDef){.Callback = eInkDisplay_TimerExpired,
+                                        .pContext = pDisplay};
 
     // GPIO initialization (SPI low level configuration and GPIO pins)
-    eInkDisplay_GPIO_Init();
+    eInkDisplay_GPIO_Init(pDisplay);
+
+    // Configure the SPIx peripheral as communication interface
+    eInkDisplay_SPI_Init(pDisplay);
 
-    // Configure the SPI 1 peripheral as communication interface
-    eInkDisplay_SPI_Init();
+    // Configure the DMA stream that streams the frames
+    eInkDisplay_DMA_Init(pDisplay);
 
-    // Follows the initialization sequence of the display
-    eInkDisplay_Sequence_Init();
+    // The display is woken up by the first update
+    pDisplay->Asleep = 1;
 }
 
 /*
  * Clears the display with white pixels by sending (0 is black and 1 is white)
  *
  * Params:
- *    * None
+ *    * pDisplay, a pointer to the EinkPaper_TypeDef of the display
  * Returns:
  *    * None
  */
-void eInkDisplay_FillWhite(void) {
+void eInkDisplay_FillWhite(EinkPaper_TypeDef *pDisplay) {
 
-    // Command: Write to RAM (0x24)
-    eInkDisplay_SendCommand(0x24);
+    // Wait for a non blocking update in progress
+    while (eInkDisplay_Process(pDisplay) != OK) {
+        ;
+    }
 
-    // Loop trough the height and widt of the display. Since a data transaction
-    // sends one byte, the width is divided by 8
-    for (uint8_t h = 0; h < einkDisplay_Height; h++) {
-        for (uint8_t w = 0; w < einkDisplay_Width / 8 + 1; w++) {
-            eInkDisplay_SendData(0xFF);
-        }
+    eInkDisplay_Wake(pDisplay);
+
+    uint8_t line[EINK_DISPLAY_STRIDE];
+    memset(line, 0xFF, sizeof(line));
+
+    // The SPIx stays enabled for the whole RAM, the lines follow each other
+    // without draining the bus
+    SPI_OpenSession(&pDisplay->SPIDriver);
+
+    // Command: Write to RAM (0x24)
+    eInkDisplay_SendCommand(pDisplay, 0x24);
+
+    // Loop trough the whole RAM, every line holds EINK_DISPLAY_STRIDE bytes (8
+    // pixels each), all of them within one chip selection and in 16-bit frames
+    eInkDisplay_Select(pDisplay, HIGH);
+    SPI_SetDataFormat(&pDisplay->SPIDriver, SPI_DataFormat_16bit);
+    for (uint16_t i = 0; i < EINK_DISPLAY_HEIGHT; i++) {
+        SPI_SendData(&pDisplay->SPIDriver, line, sizeof(line));
     }
+    SPI_SetDataFormat(&pDisplay->SPIDriver, SPI_DataFormat_8bit);
+    eInkDisplay_Deselect(pDisplay);
+    SPI_CloseSession(&pDisplay->SPIDriver);
     // Update the display after writing in RAM
-    eInkDisplay_UpdateDisplay();
+    eInkDisplay_UpdateDisplay(pDisplay);
 }
 
 /*
  * Clears the display with black pixels by sending (0 is black and 1 is white)
  *
  * Params:
- *    * None
+ *    * pDisplay, a pointer to the EinkPaper_TypeDef of the display
  * Returns:
  *    * None
  */
-void eInkDisplay_FillBlack(void) {
+void eInkDisplay_FillBlack(EinkPaper_TypeDef *pDisplay) {
 
-    // Command: Write to RAM (0x24)
-    eInkDisplay_SendCommand(0x24);
+    // Wait for a non blocking update in progress
+    while (eInkDisplay_Process(pDisplay) != OK) {
+        ;
+    }
 
-    // Loop trough the height and widt of the display. Since a data transaction
-    // sends one byte, the width is divided by 8
-    for (uint8_t h = 0; h < einkDisplay_Height; h++) {
-        for (uint8_t w = 0; w < einkDisplay_Width / 8 + 1; w++) {
-            eInkDisplay_SendData(0x00);
-        }
+    eInkDisplay_Wake(pDisplay);
+
+    uint8_t line[EINK_DISPLAY_STRIDE];
+    memset(line, 0x00, sizeof(line));
+
+    // The SPIx stays enabled for the whole RAM, the lines follow each other
+    // without draining the bus
+    SPI_OpenSession(&pDisplay->SPIDriver);
+
+    // Command: Write to RAM (0x24)
+    eInkDisplay_SendCommand(pDisplay, 0x24);
+
+    // Loop trough the whole RAM, every line holds EINK_DISPLAY_STRIDE bytes (8
+    // pixels each), all of them within one chip selection and in 16-bit frames
+    eInkDisplay_Select(pDisplay, HIGH);
+    SPI_SetDataFormat(&pDisplay->SPIDriver, SPI_DataFormat_16bit);
+    for (uint16_t i = 0; i < EINK_DISPLAY_HEIGHT; i++) {
+        SPI_SendData(&pDisplay->SPIDriver, line, sizeof(line));
     }
+    SPI_SetDataFormat(&pDisplay->SPIDriver, SPI_DataFormat_8bit);
+    eInkDisplay_Deselect(pDisplay);
+    SPI_CloseSession(&pDisplay->SPIDriver);
 
     // Update the display after writing in RAM
-    eInkDisplay_UpdateDisplay();
+    eInkDisplay_UpdateDisplay(pDisplay);
 }
 
 /*
- * Displays the image in the e-ink paper display
+ * Displays the image in the e-ink paper display, blocking until the display
+ * ends the update. Not to be used from the tasks, they start the update and
+ * process it on every eInkDisplay_CallbackProgress
  *
  * Params:
+ *    * pDisplay, a pointer to the EinkPaper_TypeDef of the display
  *    * pImage, a pointer to a 8 bit-wide integer that corresponeds to the top
  * half of the display, this contains the strings
  *    * character_bitmap, a pointer to a 8 bit-wide integer which points to the
@@ -98,50 +251,249 @@ void eInkDisplay_FillBlack(void) {
  * Returns:
  *    * None
  */
-void eInkDisplay_DisplayImage(uint8_t *pImage, uint8_t *character_bitmap) {
+void eInkDisplay_DisplayImage(EinkPaper_TypeDef *pDisplay,
+                              const uint8_t *pImage,
+                              const uint8_t *character_bitmap) {
+    EinkPaper_UpdateTypeDef update = {pDisplay, pImage, character_bitmap};
+
+    // The waits are conditions on the pins and registers, they are polled
+    while (eInkDisplay_StartImages(&update, 1) != OK) {
+        eInkDisplay_Process(pDisplay);
+    }
+    while (eInkDisplay_ProcessImages(&update, 1) != OK) {
+        ;
+    }
+}
 
-    // This corresponds to the top half of the display
-    // Command: Write to RAM (0x24)
-    eInkDisplay_SendCommand(0x24);
-    for (uint8_t h = 0; h < (einkDisplay_Height) / 2; h++) {
-        for (uint8_t w = 0; w < einkDisplay_Width / 8 + 1; w++) {
-            // Send the corresponding byte of the pImage array, this is a 1-D
-            // array, to get the desired byte: w is the width byte, every time w
-            // increases, the char will follow to the following byte. h is the
-            // line, every time h increases, it adds an offset of the amount of
-            // bytes that fit in the x direction
-            eInkDisplay_SendData(pImage[w + h * (einkDisplay_Width / 8 + 1)]);
+/*
+ * Starts a display update without waiting for it to end, its first steps run
+ * at once (see eInkDisplay_Update). eInkDisplay_Process must be invoked until
+ * it returns OK, on every eInkDisplay_CallbackProgress
+ *
+ * Params:
+ *    * pDisplay, a pointer to the EinkPaper_TypeDef of the display
+ *    * pImage, a pointer to a 8 bit-wide integer with the top half of the
+ * frame, it must be kept unmodified until the update ends
+ *    * character_bitmap, a pointer to a 8 bit-wide integer with the bottom half
+ * of the frame, it must be kept unmodified until the update ends
+ * Returns:
+ *    * DriverStatus, BUSY if an update is already in progress
+ */
+DriverStatus eInkDisplay_StartImage(EinkPaper_TypeDef *pDisplay,
+                                    const uint8_t *pImage,
+                                    const uint8_t *character_bitmap) {
+    if (pDisplay->State != EinkPaper_State_Idle) {
+        return BUSY;
+    }
+
+    pDisplay->pTop = pImage;
+    pDisplay->pBottom = character_bitmap;
+    pDisplay->State = EinkPaper_State_Wake;
+    PT_INIT(&pDisplay->Thread);
+    eInkDisplay_Update(pDisplay);
+
+    return OK;
+}
+
+/*
+ * Advances a non blocking display update, never waits for the SPIx nor the
+ * display. Updates of several displays interleave by invoking it for each one
+ *
+ * Params:
+ *    * pDisplay, a pointer to the EinkPaper_TypeDef of the display
+ * Returns:
+ *    * DriverStatus, BUSY while the update is in progress, OK when the display
+ * is idle
+ */
+DriverStatus eInkDisplay_Process(EinkPaper_TypeDef *pDisplay) {
+    if (pDisplay->State == EinkPaper_State_Idle) {
+        return OK;
+    }
+    return eInkDisplay_Update(pDisplay);
+}
+
+/*
+ * Starts a frame on several displays at once, the frame transfer of a display
+ * overlaps the refresh (Busy period) of the others. Displays without a DMA
+ * stream push their frame here. eInkDisplay_ProcessImages must be invoked until
+ * it returns OK
+ *
+ * Params:
+ *    * pUpdates, a pointer to EinkPaper_UpdateTypeDef array with the display
+ * and frame of every update, it must be kept until the updates end
+ *    * Count, an 8 bit-wide integer with the amount of updates
+ * Returns:
+ *    * DriverStatus, BUSY if a display is still updating (nothing is started)
+ */
+DriverStatus eInkDisplay_StartImages(EinkPaper_UpdateTypeDef *pUpdates,
+                                     uint8_t Count) {
+    for (uint8_t i = 0; i < Count; i++) {
+        if (pUpdates[i].pDisplay->State != EinkPaper_State_Idle) {
+            return BUSY;
         }
     }
 
-    // This corresponds to the bottom half of the display
-    // Command: Write to RAM (0x24)
-    for (uint8_t h = 0; h < (einkDisplay_Height) / 2; h++) {
-        for (uint8_t w = 0; w < einkDisplay_Width / 8 + 1; w++) {
-            // Send the corresponding byte of the pImage array, this is a 1-D
-            // array, to get the desired byte: w is the width byte, every time w
-            // increases, the char will follow to the following byte. h is the
-            // line, every time h increases, it adds an offset of the amount of
-            // bytes that fit in the x direction
-            eInkDisplay_SendData(
-                character_bitmap[w + h * (einkDisplay_Width / 8 + 1)]);
+    for (uint8_t i = 0; i < Count; i++) {
+        eInkDisplay_StartImage(pUpdates[i].pDisplay, pUpdates[i].pTop,
+                               pUpdates[i].pBottom);
+    }
+
+    // Every frame is in the display RAM already, only the refresh is left
+    if (!eInkDisplay_Transferring(pUpdates, Count)) {
+        eInkDisplay_CallbackRefreshing();
+    }
+    return OK;
+}
+
+/*
+ * Advances the updates started by eInkDisplay_StartImages. Once every frame is
+ * in the display RAM eInkDisplay_CallbackRefreshing is invoked
+ *
+ * Params:
+ *    * pUpdates, a pointer to the EinkPaper_UpdateTypeDef array
+ *    * Count, an 8 bit-wide integer with the amount of updates
+ * Returns:
+ *    * DriverStatus, BUSY while an update is in progress, OK once all of them
+ * ended
+ */
+DriverStatus eInkDisplay_ProcessImages(EinkPaper_UpdateTypeDef *pUpdates,
+                                       uint8_t Count) {
+    uint8_t transferring = eInkDisplay_Transferring(pUpdates, Count);
+    DriverStatus status = OK;
+
+    for (uint8_t i = 0; i < Count; i++) {
+        if (eInkDisplay_Process(pUpdates[i].pDisplay) != OK) {
+            status = BUSY;
         }
     }
 
-    // Update the display after writing in RAM
-    eInkDisplay_UpdateDisplay();
+    if (transferring && !eInkDisplay_Transferring(pUpdates, Count)) {
+        eInkDisplay_CallbackRefreshing();
+    }
+    return status;
+}
+
+/*
+ * Handles the interruption of the DMA stream of the display: chains the frame
+ * segments and signals the progress once the last one is in the SPIx
+ *
+ * Params:
+ *    * pDisplay, a pointer to the EinkPaper_TypeDef of the display
+ * Returns:
+ *    * None
+ */
+void eInkDisplay_DMA_IRQHandling(EinkPaper_TypeDef *pDisplay) {
+    SPI_DMA_IRQHandling(&pDisplay->SPIDriver, &pDisplay->DMADriver);
+
+    // The stream is enabled again while segments are left
+    if ((pDisplay->State == EinkPaper_State_WriteRAM) &&
+        (DMA_GetEnabled(&pDisplay->DMADriver) == FLAG_LOW)) {
+        eInkDisplay_CallbackProgress(pDisplay);
+    }
+}
+
+/*
+ * Protothread of a display update: wake up, frame streaming and refresh. It
+ * returns BUSY at every wait and goes on from there on the next invocation,
+ * the end of every wait is signaled by eInkDisplay_CallbackProgress. With a
+ * DMA stream the Write RAM command and both halves of the frame are streamed
+ * as one segment list, straight from their buffers. Otherwise the frame is
+ * pushed by polling. Standby mode is locked for the whole update, Stop mode
+ * only while a wait needs the SysTick or the DMA stream
+ *
+ * Params:
+ *    * pDisplay, a pointer to the EinkPaper_TypeDef of the display
+ * Returns:
+ *    * DriverStatus, BUSY while the update is in progress, OK once it ends
+ */
+static DriverStatus eInkDisplay_Update(EinkPaper_TypeDef *pDisplay) {
+    // Command: Write to RAM (0x24)
+    static const uint8_t writeRAM = 0x24;
+    const EinkPanel_TypeDef *pPanel = pDisplay->pPanel;
+    PT_TypeDef *pPt = &pDisplay->Thread;
+
+    PT_BEGIN(pPt);
+
+    // The reset of Standby mode would lose the update
+    Power_Lock(Power_Mode_Standby);
+
+    // A display in deep sleep is reset and initialized again. The steps wait on
+    // SysTick deadlines, the SysTick stops in Stop mode
+    Power_Lock(Power_Mode_Stop);
+    PT_SPAWN(pPt, &pDisplay->WakeThread, eInkDisplay_WakeSteps(pDisplay));
+    Power_Unlock(Power_Mode_Stop);
+
+    pDisplay->State = EinkPaper_State_WriteRAM;
+    if (pDisplay->DMADriver.pStream == NULL) {
+        // The panel streams the top half and then the bottom half into its RAM
+        pPanel->Ops.WriteRAM(pDisplay, pDisplay->pTop, pDisplay->pBottom);
+    } else {
+        // Both halves are sent in data mode within the same chip selection as
+        // the command, the RAM address counter continues where the top half
+        // ends
+        pDisplay->Segments[0] =
+            (SPI_SegmentTypeDef){.pTxBuffer = &writeRAM, .Len = 1, .DC = LOW};
+        pDisplay->Segments[1] = (SPI_SegmentTypeDef){
+            .pTxBuffer = pDisplay->pTop, .Len = pPanel->HalfSize, .DC = HIGH};
+        pDisplay->Segments[2] =
+            (SPI_SegmentTypeDef){.pTxBuffer = pDisplay->pBottom,
+                                 .Len = pPanel->HalfSize,
+                                 .DC = HIGH};
+
+        // The DMA stream stops in Stop mode, Sleep mode at most while it runs.
+        // Its interruption signals the end of the last segment
+        Power_Lock(Power_Mode_Stop);
+        SPI_SendSegmentsDMA(&pDisplay->SPIDriver, &pDisplay->DMADriver,
+                            pDisplay->Segments, 3);
+        PT_WAIT_UNTIL(pPt, eInkDisplay_Streamed(pDisplay));
+        Power_Unlock(Power_Mode_Stop);
+    }
+
+    // Display update control and activation, the SPIx is free while the
+    // display refreshes. The falling edge of Busy (EXTI line) or the polling
+    // timer signals the end, both wake the MCU up from Stop mode
+    pPanel->Ops.Refresh(pDisplay);
+    pDisplay->State = EinkPaper_State_Refresh;
+    PT_WAIT_UNTIL(pPt, eInkDisplay_Ready(pDisplay));
+
+    pDisplay->State = EinkPaper_State_Idle;
+    Power_Unlock(Power_Mode_Standby);
+
+    PT_END(pPt);
 }
 
+/*
+ * Puts the display in deep sleep mode, the RAM content is kept on the display
+ * but no command is accepted until the next HW reset. The following display
+ * update wakes the display up. Never waits for an update in progress
+ *
+ * Params:
+ *    * pDisplay, a pointer to the EinkPaper_TypeDef of the display
+ * Returns:
+ *    * DriverStatus, BUSY while an update is in progress (nothing is done), OK
+ * once the display sleeps
+ */
+DriverStatus eInkDisplay_Sleep(EinkPaper_TypeDef *pDisplay) {
+    if (pDisplay->State != EinkPaper_State_Idle) {
+        return BUSY;
+    }
+
+    if (!pDisplay->Asleep) {
+        pDisplay->pPanel->Ops.Sleep(pDisplay);
+        pDisplay->Asleep = 1;
+    }
+    return OK;
+}
 
 /*
  * Initialazes the GPIO pins (SPI low level initializaion and GPIO pins of the e-ink paper display)
  *
  * Params:
- *    * None
+ *    * pDisplay, a pointer to the EinkPaper_TypeDef of the display
  * Returns:
  *    * None
  */
-void eInkDisplay_GPIO_Init(void) {
+static void eInkDisplay_GPIO_Init(EinkPaper_TypeDef *pDisplay) {
 
     /* Gpio pin initialization */
 
@@ -149,37 +501,45 @@ void eInkDisplay_GPIO_Init(void) {
 
     GPIO_DriverTypeDef spi_MOSI = {0};
 
-    spi_MOSI.pGPIOx = GPIOA;
-    spi_MOSI.Config.Number = 7;
+    spi_MOSI.pGPIOx = pDisplay->pSPI_GPIOx;
+    spi_MOSI.Config.Number = pDisplay->MOSI_PinNumber;
     spi_MOSI.Config.Mode = GPIO_Mode_AlternateFunction;
     spi_MOSI.Config.OutputType = GPIO_OpType_PushPull;
     spi_MOSI.Config.Speed = GPIO_Speed_High;
     spi_MOSI.Config.PullUpDown = GPIO_PuPd_None;
-    spi_MOSI.Config.AlternateFunction = 5;
+    spi_MOSI.Config.AlternateFunction = pDisplay->SPI_AlternateFunction;
 
     GPIO_Init(&spi_MOSI);
 
     GPIO_DriverTypeDef spi_SCK = {0};
 
-    spi_SCK.pGPIOx = GPIOA;
-    spi_SCK.Config.Number = 5;
+    spi_SCK.pGPIOx = pDisplay->pSPI_GPIOx;
+    spi_SCK.Config.Number = pDisplay->SCK_PinNumber;
     spi_SCK.Config.Mode = GPIO_Mode_AlternateFunction;
     spi_SCK.Config.OutputType = GPIO_OpType_PushPull;
     spi_SCK.Config.Speed = GPIO_Speed_High;
     spi_SCK.Config.PullUpDown = GPIO_PuPd_None;
-    spi_SCK.Config.AlternateFunction = 5;
+    spi_SCK.Config.AlternateFunction = pDisplay->SPI_AlternateFunction;
 
     GPIO_Init(&spi_SCK);
 
     GPIO_DriverTypeDef spi_CS = {0};
 
-    spi_CS.pGPIOx = GPIOB;
-    spi_CS.Config.Number = 0;
-    spi_CS.Config.Mode = GPIO_Mode_Output;
+    spi_CS.Config.Number = pDisplay->CS_PinNumber;
     spi_CS.Config.OutputType = GPIO_OpType_PushPull;
     spi_CS.Config.Speed = GPIO_Speed_VeryHigh;
     spi_CS.Config.PullUpDown = GPIO_PuPd_None;
 
+    if (pDisplay->CSMode == EinkPaper_CS_Hardware) {
+        // NSS pin, driven by the SPIx
+        spi_CS.pGPIOx = pDisplay->pSPI_GPIOx;
+        spi_CS.Config.Mode = GPIO_Mode_AlternateFunction;
+        spi_CS.Config.AlternateFunction = pDisplay->SPI_AlternateFunction;
+    } else {
+        spi_CS.pGPIOx = pDisplay->pGPIOx;
+        spi_CS.Config.Mode = GPIO_Mode_Output;
+    }
+
     GPIO_Init(&spi_CS);
 
     // Data/Command Pin (GPIO Output Pin):
@@ -187,8 +547,8 @@ void eInkDisplay_GPIO_Init(void) {
     //  data.
 
     GPIO_DriverTypeDef DS_Pin = {0};
-    DS_Pin.pGPIOx = GPIOB;
-    DS_Pin.Config.Number = 2;
+    DS_Pin.pGPIOx = pDisplay->pGPIOx;
+    DS_Pin.Config.Number = pDisplay->DC_PinNumber;
     DS_Pin.Config.Mode = GPIO_Mode_Output;
     DS_Pin.Config.OutputType = GPIO_OpType_PushPull;
     DS_Pin.Config.Speed = GPIO_Speed_VeryHigh;
@@ -196,9 +556,9 @@ void eInkDisplay_GPIO_Init(void) {
     GPIO_Init(&DS_Pin);
 
     // Reset Pin is used to make  a HW reset
-    GPIO_DriverTypeDef Reset_Pin;
-    Reset_Pin.pGPIOx = GPIOB;
-    Reset_Pin.Config.Number = 8;
+    GPIO_DriverTypeDef Reset_Pin = {0};
+    Reset_Pin.pGPIOx = pDisplay->pGPIOx;
+    Reset_Pin.Config.Number = pDisplay->Reset_PinNumber;
     Reset_Pin.Config.Mode = GPIO_Mode_Output;
     Reset_Pin.Config.OutputType = GPIO_OpType_PushPull;
     Reset_Pin.Config.Speed = GPIO_Speed_VeryHigh;
@@ -207,243 +567,505 @@ void eInkDisplay_GPIO_Init(void) {
 
     // Busy pin is used to indicate whenever the display's CPU is busy, it
     // should not be interurpted during this
-    GPIO_DriverTypeDef Busy_Pin;
-    Busy_Pin.pGPIOx = GPIOB;
-    Busy_Pin.Config.Number = 5;
+    GPIO_DriverTypeDef Busy_Pin = {0};
+    Busy_Pin.pGPIOx = pDisplay->pGPIOx;
+    Busy_Pin.Config.Number = pDisplay->Busy_PinNumber;
     Busy_Pin.Config.Mode = GPIO_Mode_Input;
     Busy_Pin.Config.PullUpDown = GPIO_PuPd_None;
+
+    // The falling edge of Busy signals the end of the waits, the line is
+    // polled instead when another pin holds it
+    if ((pDisplay->BusyInterrupt == ENABLE) &&
+        (GPIO_IRQ_Register(pDisplay->Busy_PinNumber, eInkDisplay_BusyIRQ,
+                           pDisplay) == OK)) {
+        Busy_Pin.InterruptMode = GPIO_It_Fall;
+    } else {
+        pDisplay->BusyInterrupt = DISABLE;
+    }
     GPIO_Init(&Busy_Pin);
+    if (pDisplay->BusyInterrupt == ENABLE) {
+        GPIO_IRQ_Control(pDisplay->Busy_IRQNumber, ENABLE);
+    }
+
+    eInkDisplay_Deselect(pDisplay);
+}
+
+
+/*
+ * Initialazes the SPIx of the display as communication interface
+ *
+ * Params:
+ *    * pDisplay, a pointer to the EinkPaper_TypeDef of the display
+ * Returns:
+ *    * None
+ */
+static void eInkDisplay_SPI_Init(EinkPaper_TypeDef *pDisplay) {
+    /* SPI Pin Initialization */
+
+    // The SPIx is used as the communication interface between with the
+    // display, Selecting the 4-wire configuration available.
+    SPI_DriverTypeDef *pSPIDriver = &pDisplay->SPIDriver;
+
+    pSPIDriver->Config.Type = SPI_Type_FullDuplex;
+    pSPIDriver->Config.Mode = SPI_Mode_0;
+    pSPIDriver->Config.Hierarchy = SPI_Hierarchy_Master;
+    pSPIDriver->Config.BaudRate = SPI_BaudRate_div2;
+    // SSD16xx write cycle is 50 ns at least, the divider follows the clock
+    // profile to stay within 20 MHz
+    pSPIDriver->Config.MaxClock = 20000000;
+    pSPIDriver->Config.FrameFormat = SPI_FrameFormat_MSBFirst;
+    // In hardware mode the SPIx drives NSS LOW while it is enabled (SSOE),
+    // every burst frames its own chip selection
+    pSPIDriver->Config.SSM = (pDisplay->CSMode == EinkPaper_CS_Hardware)
+                                 ? SPI_SSM_Disable
+                                 : SPI_SSM_Enable;
+    pSPIDriver->Config.DataFormat = SPI_DataFormat_8bit;
+    // Payloads are switched to 16-bit frames, the bytes keep the order of the
+    // buffer on the wire
+    pSPIDriver->Config.ByteOrder = SPI_ByteOrder_Stream;
+    pSPIDriver->TxState = SPI_TxState_Ready;
+    pSPIDriver->InterruptMode = SPI_It_Enable;
+
+    SPI_Init(pSPIDriver);
+
+    // Transactions are queued to the SPIx interruption and frames are streamed
+    // as segment lists, both drive D/C and CS (only in software mode)
+    SPI_ControlPins_Init(pSPIDriver, pDisplay->pGPIOx,
+                         (1U << pDisplay->DC_PinNumber),
+                         (pDisplay->CSMode == EinkPaper_CS_Software)
+                             ? (1U << pDisplay->CS_PinNumber)
+                             : 0);
+    SPI_IRQ_Control(pDisplay->SPI_IRQNumber, ENABLE);
+}
+
+/*
+ * Initialazes the DMA stream mapped to the Tx request of the SPIx, used to
+ * stream the frames into the display RAM. Displays without a stream push the
+ * frames by polling
+ *
+ * Params:
+ *    * pDisplay, a pointer to the EinkPaper_TypeDef of the display
+ * Returns:
+ *    * None
+ */
+static void eInkDisplay_DMA_Init(EinkPaper_TypeDef *pDisplay) {
+    if (pDisplay->DMADriver.pStream == NULL) {
+        return;
+    }
 
-    // Initialaze EinkPaper_TypeDef struct with information related with
-    // initialization
+    pDisplay->DMADriver.Config.Direction = DMA_Direction_MemToPeriph;
+    pDisplay->DMADriver.Config.Priority = DMA_Priority_Medium;
+    pDisplay->DMADriver.Config.DataSize = DMA_DataSize_8bit;
+    // The transfer complete interruption chains the segments of a frame, its
+    // handler must invoke eInkDisplay_DMA_IRQHandling
+    pDisplay->DMADriver.Config.TCInterrupt = ENABLE;
+
+    DMA_Init(&pDisplay->DMADriver);
+    DMA_IRQ_Control(pDisplay->DMA_IRQNumber, ENABLE);
+}
+
+/*
+ * Protothread of the wake up after deep sleep: HW reset and initialization
+ * procedure of the e-ink paper display. Ends at once if the display is awake.
+ * The waits on the SysTick and the Busy pin end with
+ * eInkDisplay_CallbackProgress
+ *
+ * Params:
+ *    * pDisplay, a pointer to the EinkPaper_TypeDef of the display
+ * Returns:
+ *    * DriverStatus, BUSY while waiting, OK once the display is awake
+ */
+static DriverStatus eInkDisplay_WakeSteps(EinkPaper_TypeDef *pDisplay) {
+    const EinkPanel_TypeDef *pPanel = pDisplay->pPanel;
+    PT_TypeDef *pPt = &pDisplay->WakeThread;
+
+    PT_BEGIN(pPt);
+
+    if (!pDisplay->Asleep) {
+        PT_EXIT(pPt);
+    }
+
+    // Wait for 10 ms after energy supply, the timebase starts on power up so
+    // it has usually elapsed already
+    pDisplay->Deadline = 10;
+    PT_WAIT_UNTIL(pPt, eInkDisplay_Elapsed(pDisplay));
+
+    // HW reset, the Reset pin goes low. Every level is held 2 ms, the deadlines
+    // follow each other so the pulse does not stretch when a step is resumed
+    // late
+    pDisplay->Deadline = SysTick_Deadline(2);
+    GPIO_Pin_Write(pDisplay->pGPIOx, pDisplay->Reset_PinNumber, HIGH);
+    PT_WAIT_UNTIL(pPt, eInkDisplay_Elapsed(pDisplay));
+    pDisplay->Deadline += 2;
+    GPIO_Pin_Write(pDisplay->pGPIOx, pDisplay->Reset_PinNumber, LOW);
+    PT_WAIT_UNTIL(pPt, eInkDisplay_Elapsed(pDisplay));
+    pDisplay->Deadline += 2;
+    GPIO_Pin_Write(pDisplay->pGPIOx, pDisplay->Reset_PinNumber, HIGH);
+    PT_WAIT_UNTIL(pPt, eInkDisplay_Elapsed(pDisplay));
+
+    // Wait until e-ink display is not busy
+    PT_WAIT_UNTIL(pPt, eInkDisplay_Ready(pDisplay));
+
+    // Command: SW Reset (0x12), followed by 10 ms at least and the busy time
+    eInkDisplay_SendCommand(pDisplay, 0x12);
+    pDisplay->Deadline = SysTick_Deadline(10);
+    PT_WAIT_UNTIL(pPt,
+                  eInkDisplay_Elapsed(pDisplay) && eInkDisplay_Ready(pDisplay));
+
+    // Panel specific configuration (gate driver output, data entry mode,
+    // border, temperature sensor...)
+    pPanel->Ops.Init(pDisplay);
+
+    // Set the RAM window as the whole display, starting at the origin
+    pPanel->Ops.SetWindow(pDisplay, 0, 0, pPanel->Width - 1,
+                          pPanel->Height - 1);
+
+    // Wait busy
+    PT_WAIT_UNTIL(pPt, eInkDisplay_Ready(pDisplay));
 
-    epaper_2_13.pGPIOx = GPIOB;
-    epaper_2_13.DC_PinNumber = DS_Pin.Config.Number;
-    epaper_2_13.CS_PinNumber = spi_CS.Config.Number;
-    epaper_2_13.Busy_PinNumber = Busy_Pin.Config.Number;
-    epaper_2_13.Reset_PinNumber = Reset_Pin.Config.Number;
+    pDisplay->Asleep = 0;
 
-    GPIO_Pin_Write(epaper_2_13.pGPIOx, epaper_2_13.CS_PinNumber, HIGH);
+    PT_END(pPt);
 }
 
+/*
+ * Wakes the display up after deep sleep, following the initialization
+ * procedure again. Blocks until the wake up protothread ends, the CPU sleeps
+ * between its steps (the SysTick wakes it up every millisecond). Only used by
+ * the blocking fills
+ *
+ * Params:
+ *    * pDisplay, a pointer to the EinkPaper_TypeDef of the display
+ * Returns:
+ *    * None
+ */
+static void eInkDisplay_Wake(EinkPaper_TypeDef *pDisplay) {
+    PT_INIT(&pDisplay->WakeThread);
+    while (eInkDisplay_WakeSteps(pDisplay) != OK) {
+        __WFI();
+    }
+}
 
 /*
- * Initialazes SPI1 as communication interface
+ * Sends a byte in data mode
  *
  * Params:
+ *    * pDisplay, a pointer to the EinkPaper_TypeDef of the display
+ *    * data, a 8 bit-wide integer that will be sent in data mode 
+ * Returns:
  *    * None
+ */
+void eInkDisplay_SendData(EinkPaper_TypeDef *pDisplay, uint8_t data) {
+    // Send Data, D/C should be HIGH
+    eInkDisplay_Select(pDisplay, HIGH);
+    SPI_SendData(&pDisplay->SPIDriver, &data, 1);
+    eInkDisplay_Deselect(pDisplay);
+}
+
+/*
+ * Sends a byte in command mode
+ *
+ * Params:
+ *    * pDisplay, a pointer to the EinkPaper_TypeDef of the display
+ *    * data, a 8 bit-wide integer that will be sent in command mode 
  * Returns:
  *    * None
  */
-void eInkDisplay_SPI_Init(void) {
-    /* SPI Pin Initialization */
+void eInkDisplay_SendCommand(EinkPaper_TypeDef *pDisplay, uint8_t command) {
+    // Send Command, D/C should be LOW
+    eInkDisplay_Select(pDisplay, LOW);
+    SPI_SendData(&pDisplay->SPIDriver, &command, 1);
+    eInkDisplay_Deselect(pDisplay);
+}
 
-    // SPI1 is used as the communication interface between with the display,
-    // Selecting the 4-wire configuration available.
+/*
+ * Sends a buffer in data mode as a single burst, the chip selection is held
+ * for the whole buffer
+ *
+ * Params:
+ *    * pDisplay, a pointer to the EinkPaper_TypeDef of the display
+ *    * pData, a pointer to a 8 bit-wide integer with the data to send
+ *    * Len, a 16 bit-wide integer with the bytes to send
+ * Returns:
+ *    * None
+ */
+void eInkDisplay_SendBuffer(EinkPaper_TypeDef *pDisplay, const uint8_t *pData,
+                            uint16_t Len) {
+    eInkDisplay_Select(pDisplay, HIGH);
+    eInkDisplay_SendPayload(pDisplay, pData, Len);
+    eInkDisplay_Deselect(pDisplay);
+}
 
-    spi1.pSPIx = SPI1;
-    spi1.Config.Type = SPI_Type_FullDuplex;
-    spi1.Config.Mode = SPI_Mode_0;
-    spi1.Config.Hierarchy = SPI_Hierarchy_Master;
-    spi1.Config.BaudRate = SPI_BaudRate_div2;
-    spi1.Config.FrameFormat = SPI_FrameFormat_MSBFirst;
-    spi1.Config.SSM = SPI_SSM_Enable;
-    spi1.Config.DataFormat = SPI_DataFormat_8bit;
+/*
+ * Sends a sequence of transactions (command followed by its payload). The
+ * transactions are queued to the SPIx interruption, which changes D/C and CS
+ * between descriptors, while the CPU sleeps until the queue is sent
+ *
+ * Params:
+ *    * pDisplay, a pointer to the EinkPaper_TypeDef of the display
+ *    * pTransactions, a pointer to EinkPaper_TransactionTypeDef array
+ *    * Count, an 8 bit-wide integer with the amount of transactions
+ * Returns:
+ *    * None
+ */
+void eInkDisplay_SendTransactions(
+    EinkPaper_TypeDef *pDisplay,
+    const EinkPaper_TransactionTypeDef *pTransactions, uint8_t Count) {
+    for (uint8_t i = 0; i < Count; i++) {
+        // Command byte, D/C LOW. CS is kept LOW for the payload
+        SPI_DescriptorTypeDef command = {0};
+        command.pTxBuffer = &pTransactions[i].Command;
+        command.Len = 1;
+        command.DC = LOW;
+        command.CS = pTransactions[i].Len ? SPI_CS_Keep : SPI_CS_Release;
+        eInkDisplay_QueuePush(pDisplay, &command);
+
+        // Payload, D/C HIGH
+        if (pTransactions[i].Len) {
+            SPI_DescriptorTypeDef payload = {0};
+            payload.pTxBuffer = pTransactions[i].pData;
+            payload.Len = pTransactions[i].Len;
+            payload.DC = HIGH;
+            payload.CS = SPI_CS_Release;
+            eInkDisplay_QueuePush(pDisplay, &payload);
+        }
+    }
 
-    SPI_Init(&spi1);
+    // The transactions may point to the stack of the caller, they must be sent
+    // before returning
+    eInkDisplay_QueueWait(pDisplay, SPI_QUEUE_SIZE);
 }
 
 /*
- * Resets the e-ink display using Reset Pin
- * 
+ * Pushes a descriptor into the transaction queue of the display, sleeping while
+ * the queue is full
+ *
  * Params:
+ *    * pDisplay, a pointer to the EinkPaper_TypeDef of the display
+ *    * pDescriptor, a pointer to the SPI_DescriptorTypeDef to push
+ * Returns:
  *    * None
+ */
+static void eInkDisplay_QueuePush(EinkPaper_TypeDef *pDisplay,
+                                  const SPI_DescriptorTypeDef *pDescriptor) {
+    eInkDisplay_QueueWait(pDisplay, 1);
+    SPI_Queue_Push(&pDisplay->SPIDriver, pDescriptor);
+}
+
+/*
+ * Sleeps until the transaction queue of the display has the desired free
+ * descriptors. Interruptions are masked between the check and WFI, a pending
+ * interruption still wakes the CPU up so no descriptor completion is missed
+ *
+ * Params:
+ *    * pDisplay, a pointer to the EinkPaper_TypeDef of the display
+ *    * Free, an 8 bit-wide integer with the descriptors needed
  * Returns:
  *    * None
  */
-static void eInkDisplay_HW_Reset(void) {
-    // To make a HW reset, Reset pin must go low
-    GPIO_Pin_Write(epaper_2_13.pGPIOx, epaper_2_13.Reset_PinNumber, HIGH);
-    delay(2);
-    GPIO_Pin_Write(epaper_2_13.pGPIOx, epaper_2_13.Reset_PinNumber, LOW);
-    delay(2);
-    GPIO_Pin_Write(epaper_2_13.pGPIOx, epaper_2_13.Reset_PinNumber, HIGH);
-    delay(2);
+static void eInkDisplay_QueueWait(EinkPaper_TypeDef *pDisplay, uint8_t Free) {
+    __disable_irq();
+    while (SPI_Queue_GetFree(&pDisplay->SPIDriver) < Free) {
+        __WFI();
+        __enable_irq();
+        __disable_irq();
+    }
+    __enable_irq();
 }
 
 /*
- * Follows the initialization procedure of the e-ink paper display
- * 
+ * Sends a payload in data mode, the display must already be selected. Payloads
+ * longer than a byte are sent in 16-bit frames (half the data register writes
+ * and TXE waits), commands are kept in 8-bit frames
+ *
  * Params:
+ *    * pDisplay, a pointer to the EinkPaper_TypeDef of the display
+ *    * pData, a pointer to a 8 bit-wide integer with the data to send
+ *    * Len, a 16 bit-wide integer with the bytes to send
+ * Returns:
  *    * None
+ */
+static void eInkDisplay_SendPayload(EinkPaper_TypeDef *pDisplay,
+                                    const uint8_t *pData, uint16_t Len) {
+    if (Len > 1) {
+        SPI_SetDataFormat(&pDisplay->SPIDriver, SPI_DataFormat_16bit);
+        SPI_SendData(&pDisplay->SPIDriver, pData, Len);
+        SPI_SetDataFormat(&pDisplay->SPIDriver, SPI_DataFormat_8bit);
+    } else {
+        SPI_SendData(&pDisplay->SPIDriver, pData, Len);
+    }
+}
+
+/*
+ * Updates the image on the display after the RAM content is modified
+ *
+ * Params:
+ *    * pDisplay, a pointer to the EinkPaper_TypeDef of the display
  * Returns:
  *    * None
  */
-static void eInkDisplay_Sequence_Init(void) {
-    /* Display initialization */
+static void eInkDisplay_UpdateDisplay(EinkPaper_TypeDef *pDisplay) {
 
-    // Wait for 10 ms after energy supply
-    delay(10);
+    // Display update control and activation, defined by the panel
+    pDisplay->pPanel->Ops.Refresh(pDisplay);
+    eInkDisplay_CallbackRefreshing();
 
-    // HW reset
-    eInkDisplay_HW_Reset();
+    // Wait until busy
+    eInkDisplay_WaitBusy(pDisplay);
+}
 
-    // Halt until e-ink display is not busy
-    while (GPIO_Pin_Read(epaper_2_13.pGPIOx, epaper_2_13.Busy_PinNumber)) {
+/*
+ * Halts the CPU until the display is not busy
+ *
+ * Params:
+ *    * pDisplay, a pointer to the EinkPaper_TypeDef of the display
+ * Returns:
+ *    * None
+ */
+void eInkDisplay_WaitBusy(EinkPaper_TypeDef *pDisplay) {
+    while (GPIO_Pin_Read(pDisplay->pGPIOx, pDisplay->Busy_PinNumber)) {
         ;
     }
+}
 
-    // Command: SW Reset (0x12)
-    eInkDisplay_SendCommand(0x12);
+/*
+ * Checks the deadline a protothread waits for. The timer of the display is
+ * started to the deadline while it has not elapsed, its expiry signals the
+ * progress
+ *
+ * Params:
+ *    * pDisplay, a pointer to the EinkPaper_TypeDef of the display
+ * Returns:
+ *    * elapsed, 1 once the deadline (SysTick) has elapsed
+ */
+static uint8_t eInkDisplay_Elapsed(EinkPaper_TypeDef *pDisplay) {
+    uint64_t now = SysTick_GetMs();
 
-    // Halt until e-ink display is not busy
-    while (GPIO_Pin_Read(epaper_2_13.pGPIOx, epaper_2_13.Busy_PinNumber)) {
-        ;
+    if (now >= pDisplay->Deadline) {
+        return 1;
     }
-    // Wait 10 ms
-    // TODO: Delay function
-    delay(10);
-    // Command: gate driver output (0x01)
-    eInkDisplay_SendCommand(0x01);
-    // Data:
-    //    [8:0]: MUX Gate lines - 1
-    //    [2:0]: Gate Scanning sequence:
-    //        [2]: Select first gate to scan:
-    //          0: Gate 0 is the first to scan
-    //          1: Gate 1 is the first to scan
-    //        [1]: Scanning order:
-    //          0: Sequential (0 .. gate outputs)
-    //          1: Split in order (0, gate outputs/2, 1, gate outputs/2 +1, ...)
-    //        [0]: Direction scanning:
-    //          0: From button to top
-    //          1: Frrom top to button (reversed)
-
-    // Selecting 250 - 1 gate outputs
-    eInkDisplay_SendData(einkDisplay_Height - 1); // first byte [7:0]
-    eInkDisplay_SendData(0x00);                   // last bit [8]
-    // Select 0 as the first gate to scan in sequential order,
-    // from button to top
-    eInkDisplay_SendData(0x00);
-
-    // Set RAM size (0x11, 0x44, 0x45)
-
-    // Command: Data entry mode (0x11)
-    eInkDisplay_SendCommand(0x11);
-
-    // Data:
-    //    [2:0]: Define data entry sequence
-    //          [1:0]: Increment/decrement setting:
-    //              00: y decrement, x decrement
-    //              01: y decrement, x increment
-    //              10: y increment, x decrement
-    //              11: y increment, x increment
-    //          [2]: Set which direction to increment the address:
-    //              0: increment in x direction
-    //              1: increment in y direction
-    // Select x and y incrementing direction, updating counter in x direction
-    eInkDisplay_SendData(0x03);
-
-    // Command: Set RAM x widht (0x44)
-    eInkDisplay_SendCommand(0x44);
-
-    // Data:
-    //    [5:0]: x RAM start position
-    //    [5:0]: x RAM end position
-    // Select x start as 0 and end as source outputs - 1
-    eInkDisplay_SendData(0x00);
-    eInkDisplay_SendData((einkDisplay_Width - 1) /
-                         8); // by every RAM unit (8 bits)
-
-    // Command: Set RAM x widht (0x45)
-    eInkDisplay_SendCommand(0x45);
-
-    // Data:
-    //    [8:0]: y RAM start position
-    //    [8:0]: y RAM end position
-    // Select y start as 0 and end as gate outputs - 1
-
-    eInkDisplay_SendData(0x00);                     // [7:0]
-    eInkDisplay_SendData(0x00);                     // [8]
-    eInkDisplay_SendData((einkDisplay_Height - 1)); // [7:0]
-    eInkDisplay_SendData(0x00);                     // [8]
-
-    // Command: Set RAM x Counter (0x4E)
-    eInkDisplay_SendCommand(0x4E);
-    eInkDisplay_SendData(0x00);
-
-    // Command: Set RAM y Counter (0x4F)
-    eInkDisplay_SendCommand(0x4F);
-    eInkDisplay_SendData(0x00);
-    eInkDisplay_SendData(0x00);
-
-    // Command: Set panel border (0x3C)
-    eInkDisplay_SendCommand(0x3C);
-    eInkDisplay_SendData(0x05);
-
-    eInkDisplay_SendCommand(0x21);
-    eInkDisplay_SendData(0x00);
-    eInkDisplay_SendData(0x80);
-    //
-    // Command: Sense temperature by int/ext TS (0x18)
-    eInkDisplay_SendCommand(0x18);
-    eInkDisplay_SendData(0x80); // int temperature sensor
+    SWTimer_Start(&pDisplay->Timer, (uint32_t)(pDisplay->Deadline - now));
 
-    // Wait busy
-    while (GPIO_Pin_Read(epaper_2_13.pGPIOx, epaper_2_13.Busy_PinNumber)) {
+    return 0;
+}
+
+/*
+ * Checks whether the display is ready (Busy pin LOW). Without the Busy
+ * interruption the timer of the display polls the pin again
+ *
+ * Params:
+ *    * pDisplay, a pointer to the EinkPaper_TypeDef of the display
+ * Returns:
+ *    * ready, 1 once the Busy pin is LOW
+ */
+static uint8_t eInkDisplay_Ready(EinkPaper_TypeDef *pDisplay) {
+    if (!GPIO_Pin_Read(pDisplay->pGPIOx, pDisplay->Busy_PinNumber)) {
+        return 1;
+    }
+    if (pDisplay->BusyInterrupt != ENABLE) {
+        SWTimer_Start(&pDisplay->Timer, EINK_BUSY_POLL_MS);
+    }
+    return 0;
+}
+
+/*
+ * Checks whether the frame push is over. The stream interruption signals the
+ * end of the last segment, from there only the last frames are left in the
+ * SPIx (a few SCK cycles) and they are waited for
+ *
+ * Params:
+ *    * pDisplay, a pointer to the EinkPaper_TypeDef of the display
+ * Returns:
+ *    * streamed, 1 once the frame is in the display RAM and CS is released
+ */
+static uint8_t eInkDisplay_Streamed(EinkPaper_TypeDef *pDisplay) {
+    SPI_DriverTypeDef *pSPIDriver = &pDisplay->SPIDriver;
+
+    // An aborted list (transfer error) ends at once, SPI_GetStatusDMA
+    // reports it
+    if ((DMA_GetEnabled(&pDisplay->DMADriver) == FLAG_HIGH) ||
+        ((pSPIDriver->pSegments != NULL) &&
+         (pSPIDriver->SegmentIndex + 1 < pSPIDriver->SegmentCount))) {
+        return 0;
+    }
+    while (SPI_GetStatusDMA(pSPIDriver, &pDisplay->DMADriver) == BUSY) {
         ;
     }
+    return 1;
 }
 
 /*
- * Sends a byte in data mode
+ * Checks whether a frame of several updates is still being sent
  *
  * Params:
- *    * data, a 8 bit-wide integer that will be sent in data mode 
+ *    * pUpdates, a pointer to the EinkPaper_UpdateTypeDef array
+ *    * Count, an 8 bit-wide integer with the amount of updates
+ * Returns:
+ *    * transferring, 1 while a display wakes up or receives its frame
+ */
+static uint8_t eInkDisplay_Transferring(EinkPaper_UpdateTypeDef *pUpdates,
+                                        uint8_t Count) {
+    for (uint8_t i = 0; i < Count; i++) {
+        if ((pUpdates[i].pDisplay->State == EinkPaper_State_Wake) ||
+            (pUpdates[i].pDisplay->State == EinkPaper_State_WriteRAM)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Signals the progress on the falling edge of the Busy pin. Registered on the
+ * Busy line, invoked by the GPIO API
+ *
+ * Params:
+ *    * PinNumber, an 8 bit-wide integer with the Busy pin number
+ *    * pContext, a pointer to the EinkPaper_TypeDef of the display
  * Returns:
  *    * None
  */
-static void eInkDisplay_SendData(uint8_t data) {
-    // Send Data, D/C should be HIGH
-    GPIO_Pin_Write(epaper_2_13.pGPIOx, epaper_2_13.DC_PinNumber, HIGH);
-    GPIO_Pin_Write(epaper_2_13.pGPIOx, epaper_2_13.CS_PinNumber, LOW);
-    SPI_SendData(&spi1, &data, 1);
-    GPIO_Pin_Write(epaper_2_13.pGPIOx, epaper_2_13.CS_PinNumber, HIGH);
+static void eInkDisplay_BusyIRQ(uint8_t PinNumber, void *pContext) {
+    (void)PinNumber;
+    eInkDisplay_CallbackProgress(pContext);
 }
 
 /*
- * Sends a byte in command mode
+ * Signals the progress once a deadline elapses or the Busy pin is to be
+ * polled. Invoked by the SWTimer API
  *
  * Params:
- *    * data, a 8 bit-wide integer that will be sent in command mode 
+ *    * pTimer, a pointer to the timer of the display
  * Returns:
  *    * None
  */
-static void eInkDisplay_SendCommand(uint8_t command) {
-    // Send Command, D/C should be LOW
-    GPIO_Pin_Write(epaper_2_13.pGPIOx, epaper_2_13.DC_PinNumber, LOW);
-    GPIO_Pin_Write(epaper_2_13.pGPIOx, epaper_2_13.CS_PinNumber, LOW);
-    SPI_SendData(&spi1, &command, 1);
-    GPIO_Pin_Write(epaper_2_13.pGPIOx, epaper_2_13.CS_PinNumber, HIGH);
+static void eInkDisplay_TimerExpired(SWTimer_TypeDef *pTimer) {
+    eInkDisplay_CallbackProgress(pTimer->pContext);
 }
 
 /*
- * Updates the image on the display after the RAM content is modified
+ * Indicates that the frames of an update are in the display RAM and only the
+ * refresh (Busy period) is left, the SPIx is idle until it ends. Weak
+ * implementation, overriden in the user layer
  *
  * Params:
  *    * None
  * Returns:
  *    * None
  */
-static void eInkDisplay_UpdateDisplay(void) {
+__weak void eInkDisplay_CallbackRefreshing(void) { ; }
 
-    // Command: Display update control (0x22)
-    eInkDisplay_SendCommand(0x22);
-    eInkDisplay_SendData(0xF7);
-
-    eInkDisplay_SendCommand(0x20); // update display control
-    
-    // Wait until busy
-    while (GPIO_Pin_Read(epaper_2_13.pGPIOx, epaper_2_13.Busy_PinNumber)) {
-        ;
-    }
+/*
+ * Indicates that an update waits no more (end of the frame push, falling edge
+ * of Busy, elapsed deadline): eInkDisplay_Process must be invoked again. Runs
+ * from the DMA stream and EXTI interruptions or the deferred work (PendSV),
+ * only lock-free APIs can be used (Defer_Signal). Weak implementation,
+ * overriden in the user layer
+ *
+ * Params:
+ *    * pDisplay, a pointer to the EinkPaper_TypeDef of the display
+ * Returns:
+ *    * None
+ */
+__weak void eInkDisplay_CallbackProgress(EinkPaper_TypeDef *pDisplay) {
+    (void)pDisplay;
 }
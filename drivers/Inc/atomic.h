@@ -0,0 +1,134 @@
+#ifndef __ATOMIC_H__
+#define __ATOMIC_H__
+
+#include "stm32f429zi.h"
+
+/*
+ * Concurrency primitives. The atomic operations are built on the exclusive access instructions (LDREX/STREX): the
+ * store fails if an interruption ran after the load (the exception entry/return clears the exclusive monitor) and
+ * the operation is retried, no interruption is ever masked. The critical sections raise BASEPRI instead of setting
+ * PRIMASK, only the interruptions of ATOMIC_CRITICAL_PRIORITY or lower priority are held back
+ */
+
+/* Exported macros */
+
+// Highest priority masked by the critical sections (SysTick, RTC wakeup, PendSV...). Interruptions that use the
+// locked APIs (Defer_Post, SWTimer, SysTick_GetMs) must have this priority or a lower one, the higher ones (button,
+// SPI, DMA) are never masked and only use the lock-free ones (Defer_Signal, Power_Lock, SysTick_GetMs32, rings)
+#define ATOMIC_CRITICAL_PRIORITY 10
+
+/* Exported functions */
+
+/*
+ * Adds a value to a variable (modulo 2^32, a negative value subtracts)
+ *
+ * Params:
+ *    * pValue, pointer to the 32 bit-wide variable
+ *    * Value, a 32 bit-wide integer to add
+ * Returns:
+ *    * value, the new value of the variable
+ */
+static inline uint32_t Atomic_Add(volatile uint32_t *pValue, uint32_t Value) {
+    uint32_t result;
+
+    do {
+        result = __LDREXW(pValue) + Value;
+    } while (__STREXW(result, pValue));
+
+    return result;
+}
+
+/*
+ * Sets the bits of a mask in a variable
+ *
+ * Params:
+ *    * pValue, pointer to the 32 bit-wide variable
+ *    * Mask, a 32 bit-wide integer with the bits to set
+ * Returns:
+ *    * value, the previous value of the variable
+ */
+static inline uint32_t Atomic_Or(volatile uint32_t *pValue, uint32_t Mask) {
+    uint32_t previous;
+
+    do {
+        previous = __LDREXW(pValue);
+    } while (__STREXW(previous | Mask, pValue));
+
+    return previous;
+}
+
+/*
+ * Writes a variable and returns its previous value
+ *
+ * Params:
+ *    * pValue, pointer to the 32 bit-wide variable
+ *    * Value, a 32 bit-wide integer to write
+ * Returns:
+ *    * value, the previous value of the variable
+ */
+static inline uint32_t Atomic_Exchange(volatile uint32_t *pValue,
+                                       uint32_t Value) {
+    uint32_t previous;
+
+    do {
+        previous = __LDREXW(pValue);
+    } while (__STREXW(Value, pValue));
+
+    return previous;
+}
+
+/*
+ * Writes a variable only if it holds the expected value (compare and swap)
+ *
+ * Params:
+ *    * pValue, pointer to the 32 bit-wide variable
+ *    * Expected, a 32 bit-wide integer with the value read before
+ *    * Desired, a 32 bit-wide integer to write
+ * Returns:
+ *    * swapped, 1 if the variable was written, 0 if it had changed
+ */
+static inline uint8_t Atomic_CompareExchange(volatile uint32_t *pValue,
+                                             uint32_t Expected,
+                                             uint32_t Desired) {
+    do {
+        if (__LDREXW(pValue) != Expected) {
+            // The reservation is released, no store follows
+            __CLREX();
+            return 0;
+        }
+    } while (__STREXW(Desired, pValue));
+
+    return 1;
+}
+
+/*
+ * Enters a critical section, the interruptions of ATOMIC_CRITICAL_PRIORITY or
+ * lower priority are masked until Atomic_ExitCritical. Sections can be nested,
+ * BASEPRI is only raised
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * state, a 32 bit-wide integer with the previous mask, passed to
+ * Atomic_ExitCritical
+ */
+static inline uint32_t Atomic_EnterCritical(void) {
+    uint32_t state = __get_BASEPRI();
+
+    // BASEPRI holds the priority in its upper bits, as the NVIC_IPRx registers
+    __set_BASEPRI_MAX(ATOMIC_CRITICAL_PRIORITY << (8 - __NVIC_PRIO_BITS));
+
+    return state;
+}
+
+/*
+ * Leaves a critical section, the previous mask is restored
+ *
+ * Params:
+ *    * State, the value returned by Atomic_EnterCritical
+ * Returns:
+ *    * None
+ */
+static inline void Atomic_ExitCritical(uint32_t State) { __set_BASEPRI(State); }
+
+#endif // !__ATOMIC_H__
@@ -0,0 +1,91 @@
+#ifndef __CLOCK_H__
+#define __CLOCK_H__
+
+#include "stm32f429zi.h"
+
+/* Exported macros */
+
+// Loops waited for the HSE to be ready before the switch is aborted
+#define CLOCK_HSE_TIMEOUT 100000
+
+// Highest SYSCLK without over-drive, above it (up to 180 MHz) over-drive is enabled
+#define CLOCK_OVERDRIVE_THRESHOLD 168000000
+
+/* Exported TypeDefs */
+
+/*
+ * Defines the source of the system clock (SYSCLK)
+ */
+typedef enum {
+ Clock_Source_HSI,                    // 16 MHz internal oscillator
+ Clock_Source_HSE,                    // 8 MHz external clock (MCO of the ST-LINK, bypass mode)
+ Clock_Source_PLL,                    // Main PLL fed by the HSE
+} Clock_Config_Source;
+
+/*
+ * Defines the AHB prescaler (SYSCLK / HCLK), values are the HPRE bits of RCC_CFGR
+ */
+typedef enum {
+ Clock_AHB_div1 = 0,                  // HCLK = SYSCLK
+ Clock_AHB_div2 = 8,                  // HCLK = SYSCLK / 2
+ Clock_AHB_div4 = 9,                  // HCLK = SYSCLK / 4
+ Clock_AHB_div8 = 10,                 // HCLK = SYSCLK / 8
+ Clock_AHB_div16 = 11,                // HCLK = SYSCLK / 16
+} Clock_Config_AHBPrescaler;
+
+/*
+ * Defines the APBx prescalers (HCLK / PCLKx), values are the PPREx bits of RCC_CFGR
+ */
+typedef enum {
+ Clock_APB_div1 = 0,                  // PCLKx = HCLK
+ Clock_APB_div2 = 4,                  // PCLKx = HCLK / 2
+ Clock_APB_div4 = 5,                  // PCLKx = HCLK / 4
+ Clock_APB_div8 = 6,                  // PCLKx = HCLK / 8
+ Clock_APB_div16 = 7,                 // PCLKx = HCLK / 16
+} Clock_Config_APBPrescaler;
+
+/*
+ * Named clock profiles, selected at runtime with Clock_SetProfile
+ */
+typedef enum {
+ Clock_Profile_Idle,                  // HSI / 4 (4 MHz), waiting for the timer or the display
+ Clock_Profile_Run,                   // HSI (16 MHz), reset configuration
+ Clock_Profile_Render,                // PLL (180 MHz), compositing and bus transfers
+ Clock_Profile_Count,                 // Amount of profiles
+} Clock_Profile;
+
+/*
+ * Clock tree of a profile. The PLL output is HSE / PLL_M * PLL_N / PLL_P, its input (HSE / PLL_M) must be within
+ * 1..2 MHz and its VCO (HSE / PLL_M * PLL_N) within 100..432 MHz. PCLK1 must not exceed 45 MHz and PCLK2 90 MHz
+ */
+typedef struct {
+  const char *pName;                  // Name of the profile
+  Clock_Config_Source Source;         // SYSCLK source, values can be of Clock_Config_Source
+  uint8_t PLL_M;                      // PLL input divider (2..63), only used with the PLL
+  uint16_t PLL_N;                     // PLL VCO multiplier (50..432), only used with the PLL
+  uint8_t PLL_P;                      // PLL main output divider (2, 4, 6 or 8), only used with the PLL
+  uint8_t PLL_Q;                      // PLL 48 MHz domain divider (2..15), only used with the PLL
+  Clock_Config_AHBPrescaler AHB_Prescaler; // AHB prescaler, values can be of Clock_Config_AHBPrescaler
+  Clock_Config_APBPrescaler APB1_Prescaler; // APB1 prescaler, values can be of Clock_Config_APBPrescaler
+  Clock_Config_APBPrescaler APB2_Prescaler; // APB2 prescaler, values can be of Clock_Config_APBPrescaler
+} Clock_ProfileTypeDef;
+
+/* Extern variables */
+
+// Clock tree of every profile, indexed by Clock_Profile
+extern const Clock_ProfileTypeDef Clock_Profiles[Clock_Profile_Count];
+
+/* Exported functions */
+
+// Profile functions
+DriverStatus Clock_SetProfile(Clock_Profile Profile);
+Clock_Profile Clock_GetProfile(void);
+
+// Frequencies of the current profile (Hz)
+uint32_t Clock_GetSYSCLK(void);
+uint32_t Clock_GetHCLK(void);
+uint32_t Clock_GetPCLK1(void);
+uint32_t Clock_GetPCLK2(void);
+uint32_t Clock_GetTimerClock1(void);
+
+#endif // !__CLOCK_H__
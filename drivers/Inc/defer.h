@@ -0,0 +1,57 @@
+#ifndef __DEFER_H__
+#define __DEFER_H__
+
+#include "stm32f429zi.h"
+
+/* Exported macros */
+
+// Amount of pending deferred calls (power of 2)
+#define DEFER_QUEUE_SIZE 8
+
+// Priority of the PendSV exception, the lowest one: every interruption preempts the deferred work
+#define DEFER_PRIORITY 15
+
+// Priority levels of the tasks, 0 is the highest. Deferred calls run before any task
+#define DEFER_TASK_PRIORITIES 4
+
+/* Exported TypeDefs */
+
+/*
+ * Work deferred from an interruption, run by the PendSV exception
+ */
+typedef void (*Defer_Callback)(void);
+
+/*
+ * Handler of a task, receives the events signaled since its last run
+ */
+typedef void (*Defer_TaskHandler)(uint32_t Events);
+
+/*
+ * Run-to-completion task, run by the PendSV exception whenever an event is signaled to it. Ready tasks run in
+ * priority order, tasks of the same priority in signaling order. pName, Handler and Priority are set by the user.
+ * Events and Queued are only updated with the atomic operations, signaling never masks the interruptions
+ */
+typedef struct Defer_TaskTypeDef {
+  const char *pName;                  // Name of the task
+  Defer_TaskHandler Handler;          // Invoked with the pending events, runs to completion
+  uint8_t Priority;                   // Priority of the task (0..DEFER_TASK_PRIORITIES - 1), 0 is the highest
+  volatile uint32_t Events;           // Events signaled and not handled yet, cleared when the task runs
+  volatile uint32_t Queued;           // Set from the first signal until the task is taken out of its ready queue
+  struct Defer_TaskTypeDef *pNext;    // Next task of the signaled stack or of the ready queue
+  uint32_t Runs;                      // Times the task has run
+  uint32_t RunTime;                   // Milliseconds spent running the task (SysTick)
+} Defer_TaskTypeDef;
+
+/* Exported functions */
+
+// Initialization function
+void Defer_Init(void);
+
+// Deferring functions
+DriverStatus Defer_Post(Defer_Callback Callback);
+DriverStatus Defer_Signal(Defer_TaskTypeDef *pTask, uint32_t Events);
+
+// Weak implementation of callback when every deferred call and task has run
+void Defer_CallbackQueueEmpty(void);
+
+#endif // !__DEFER_H__
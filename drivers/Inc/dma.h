@@ -0,0 +1,78 @@
+#ifndef __DMA_H__
+#define __DMA_H__
+
+#include "stm32f429zi.h"
+
+/* Exported macros */
+
+// CCM-RAM address range, only reachable by the data bus of the core (stack, __ccmram/__ccmbss data)
+#define DMA_CCMRAM_BASE 0x10000000U
+#define DMA_CCMRAM_SIZE 0x10000U
+
+/* Exported TypeDefs */
+
+/*
+ * Defines the direction of the transfer
+ */
+typedef enum {
+ DMA_Direction_PeriphToMem,           // Peripheral to memory
+ DMA_Direction_MemToPeriph,           // Memory to peripheral
+ DMA_Direction_MemToMem,              // Memory to memory (only DMA2)
+} DMA_Config_Direction;
+
+/*
+ * Defines the priority of the stream, used by the arbiter when several streams request at the same time
+ */
+typedef enum {
+ DMA_Priority_Low,                    // Low priority
+ DMA_Priority_Medium,                 // Medium priority
+ DMA_Priority_High,                   // High priority
+ DMA_Priority_VeryHigh,               // Very high priority
+} DMA_Config_Priority;
+
+/*
+ * Defines the size of every data item transferred
+ */
+typedef enum {
+ DMA_DataSize_8bit,                   // Byte
+ DMA_DataSize_16bit,                  // Half-word
+ DMA_DataSize_32bit,                  // Word
+} DMA_Config_DataSize;
+
+/*
+ * DMA stream configuration
+ */
+typedef struct {
+  uint8_t Channel;                    // Request channel of the stream (0..7), see the request mapping tables of the reference manual
+  DMA_Config_Direction Direction;     // Direction of the transfer, values can be of DMA_Config_Direction
+  DMA_Config_Priority Priority;       // Priority of the stream, values can be of DMA_Config_Priority
+  DMA_Config_DataSize DataSize;       // Size of the data items (memory and peripheral), values can be of DMA_Config_DataSize
+  EnableDisable TCInterrupt;          // Transfer complete (and transfer error) interruption of the stream, values can be of EnableDisable
+} DMA_ConfigTypeDef;
+
+/*
+ * DMA driver handle
+ */
+typedef struct {
+  DMA_Stream_TypeDef *pStream;        // Pointer to the DMAx_Streamy, where x(1..2) and y(0..7)
+  DMA_ConfigTypeDef Config;           // Structure that configures the stream
+} DMA_DriverTypeDef;
+
+/* Exported functions */
+
+// Initialization function
+DriverStatus DMA_Init(DMA_DriverTypeDef *pDMADriver);
+
+// Transfer functions
+DriverStatus DMA_Start(DMA_DriverTypeDef *pDMADriver, const void *pMemory, volatile void *pPeripheral, uint16_t Len);
+FlagStatus DMA_GetTransferComplete(DMA_DriverTypeDef *pDMADriver);
+void DMA_ClearTransferComplete(DMA_DriverTypeDef *pDMADriver);
+FlagStatus DMA_GetTransferError(DMA_DriverTypeDef *pDMADriver);
+void DMA_ClearTransferError(DMA_DriverTypeDef *pDMADriver);
+FlagStatus DMA_GetEnabled(DMA_DriverTypeDef *pDMADriver);
+void DMA_Stop(DMA_DriverTypeDef *pDMADriver);
+
+// Interruption configuring
+void DMA_IRQ_Control(IRQn_Type IRQNumber, EnableDisable EnOrDi);
+
+#endif // !__DMA_H__
@@ -0,0 +1,22 @@
+#ifndef __FLASH_H__
+#define __FLASH_H__
+
+#include "stm32f429zi.h"
+
+/* Exported macros */
+
+// HCLK covered by every wait state of the flash (2.7..3.6 V supply)
+#define FLASH_WS_FREQUENCY 30000000
+
+/* Exported functions */
+
+// Clock functions, invoked around every clock profile switch
+void Flash_PrepareClock(uint32_t HCLK);
+void Flash_UpdateClock(uint32_t HCLK);
+uint32_t Flash_GetLatency(void);
+
+// ART accelerator functions (prefetch, instruction and data caches)
+void Flash_ART_Control(EnableDisable EnOrDi);
+void Flash_ResetCaches(void);
+
+#endif // !__FLASH_H__
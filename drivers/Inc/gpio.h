@@ -3,8 +3,23 @@
 
 #include "stm32f429zi.h"
 
+/* Exported macros */
+
+// Amount of EXTI lines shared by the GPIO ports, line n serves the pin n of the port selected in SYSCFG_EXTICR
+#define GPIO_EXTI_LINES 16
+
+// Lines sharing the EXTI9_5 and EXTI15_10 interruptions
+#define GPIO_EXTI_9_5_LINES 0x03E0
+#define GPIO_EXTI_15_10_LINES 0xFC00
+
 /* Exported TypeDefs */
 
+/*
+ * Invoked from the shared EXTI handlers whenever the line of a registered pin is pending, with the context given to
+ * GPIO_IRQ_Register. Runs at the priority of the EXTI interruption of the line
+ */
+typedef void (*GPIO_IRQCallback)(uint8_t PinNumber, void *pContext);
+
 /*
  * Defines the different modes of the GPIO pin
  */
@@ -86,9 +101,58 @@ void GPIO_Pin_Write(GPIO_TypeDef *pGPIOx, uint8_t PinNumber, PinLogicalLevel Lor
 void GPIO_Pin_Toggle(GPIO_TypeDef *pGPIOx, uint8_t PinNumber);
 
 // IRQ Handling and Configuration functions
+DriverStatus GPIO_IRQ_Register(uint8_t PinNumber, GPIO_IRQCallback Callback,
+                               void *pContext);
+void GPIO_IRQ_Unregister(uint8_t PinNumber);
 void GPIO_IRQ_Handling(uint8_t PinNumber);
+void GPIO_IRQ_Dispatch(uint32_t Lines);
 void GPIO_Callback_IRQTrigger(uint8_t PinNumber);
 void GPIO_IRQ_Control(IRQn_Type IRQNumber, EnableDisable EnOrDi);
 void GPIO_IRQ_PriorityConfig(IRQn_Type IRQNumber, uint32_t IRQPriority);
+void GPIO_IRQ_LineControl(uint8_t PinNumber, EnableDisable EnOrDi);
+
+/* Exported inline functions */
+
+/*
+ * Sets and resets several pins of the pGPIOx port in a single store. BSRR[15:0]
+ * sets the pins and BSRR[31:16] resets them, a pin in both masks is set
+ *
+ * Params:
+ *    * pGPIOx, pointer to GPIO_TypeDef which is the desired GPIO port
+ *    * SetMask, 16 bit-wide integer with the pins to drive HIGH
+ *    * ResetMask, 16 bit-wide integer with the pins to drive LOW
+ * Returns:
+ *    * None
+ */
+static inline void GPIO_Port_Write(GPIO_TypeDef *pGPIOx, uint16_t SetMask,
+                                   uint16_t ResetMask) {
+    pGPIOx->BSRR = ((uint32_t)ResetMask << 16) | SetMask;
+}
+
+/*
+ * Drives a pin of the pGPIOx port HIGH in a single store
+ *
+ * Params:
+ *    * pGPIOx, pointer to GPIO_TypeDef which is the desired GPIO port
+ *    * PinNumber, 8 bit-wide integer with the pin to set
+ * Returns:
+ *    * None
+ */
+static inline void GPIO_Pin_Set(GPIO_TypeDef *pGPIOx, uint8_t PinNumber) {
+    pGPIOx->BSRR = (0x1UL << PinNumber);
+}
+
+/*
+ * Drives a pin of the pGPIOx port LOW in a single store
+ *
+ * Params:
+ *    * pGPIOx, pointer to GPIO_TypeDef which is the desired GPIO port
+ *    * PinNumber, 8 bit-wide integer with the pin to reset
+ * Returns:
+ *    * None
+ */
+static inline void GPIO_Pin_Reset(GPIO_TypeDef *pGPIOx, uint8_t PinNumber) {
+    pGPIOx->BSRR = (0x1UL << (PinNumber + 16));
+}
 
 #endif // !__GPIO_H__
@@ -0,0 +1,43 @@
+#ifndef __POWER_H__
+#define __POWER_H__
+
+#include "stm32f429zi.h"
+
+/* Exported macros */
+
+// Deadline of Power_Idle when no wakeup is programmed, only the button wakes the MCU
+#define POWER_NO_DEADLINE 0xFFFFFFFF
+
+/* Exported TypeDefs */
+
+/*
+ * Power modes, from the shallowest to the deepest
+ */
+typedef enum {
+ Power_Mode_Run,                      // CPU running, no low power mode
+ Power_Mode_Sleep,                    // CPU clock stopped (WFI), peripherals and DMA streams running, any interruption wakes the MCU
+ Power_Mode_Stop,                     // 1.2 V domain clocks stopped, SRAM kept. EXTI lines wake the MCU (RTC wakeup, button)
+ Power_Mode_Standby,                  // 1.2 V domain off, only the backup SRAM and the RTC are kept. The button (RTC tamper 1, PC13) wakes the MCU with a reset
+ Power_Mode_Count,                    // Amount of power modes
+} Power_Mode;
+
+/* Exported functions */
+
+// Initialization function
+void Power_Init(void);
+uint8_t Power_WokeFromStandby(void);
+uint32_t Power_GetResidency(Power_Mode Mode);
+
+// Mode selection functions
+void Power_Lock(Power_Mode Mode);
+void Power_Unlock(Power_Mode Mode);
+Power_Mode Power_Idle(uint32_t Deadline);
+Power_Mode Power_SleepOnExit(uint32_t Deadline);
+void Power_ClearDeepSleep(void);
+
+// Low power modes
+void Power_EnterSleep(void);
+void Power_EnterStop(void);
+void Power_EnterStandby(void);
+
+#endif // !__POWER_H__
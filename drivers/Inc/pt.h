@@ -0,0 +1,74 @@
+#ifndef __PT_H__
+#define __PT_H__
+
+#include "stm32f429zi.h"
+
+/*
+ * Protothreads: stackless coroutines. A protothread is a function returning DriverStatus, written as a linear
+ * sequence of steps between PT_BEGIN and PT_END, that returns BUSY at every wait and resumes at the same point on the
+ * next call. It returns OK once it ends. The resume point is the only state kept, local variables are lost at every
+ * wait and must be kept in the structure the protothread works on. Restrictions: no switch statement between
+ * PT_BEGIN and PT_END, at most one wait per source line
+ */
+
+/* Exported TypeDefs */
+
+/*
+ * State of a protothread, the source line it resumes at (0 before the first step)
+ */
+typedef struct {
+  uint16_t Line;                      // Resume point, set by the wait macros
+} PT_TypeDef;
+
+/* Exported macros */
+
+// Starts the protothread over from its first step
+#define PT_INIT(pPt) ((pPt)->Line = 0)
+
+// Opens the body of the protothread, the execution continues at the resume point
+#define PT_BEGIN(pPt)                                                          \
+    switch ((pPt)->Line) {                                                     \
+    case 0:
+
+// Closes the body of the protothread, it returns OK and starts over on the next call
+#define PT_END(pPt)                                                            \
+    }                                                                          \
+    PT_INIT(pPt);                                                              \
+    return OK
+
+// Returns BUSY until the condition is true, it is evaluated again on every call
+#define PT_WAIT_UNTIL(pPt, Condition)                                          \
+    do {                                                                       \
+        (pPt)->Line = __LINE__;                                                \
+    case __LINE__:                                                             \
+        if (!(Condition)) {                                                    \
+            return BUSY;                                                       \
+        }                                                                      \
+    } while (0)
+
+// Returns BUSY while the condition is true
+#define PT_WAIT_WHILE(pPt, Condition) PT_WAIT_UNTIL(pPt, !(Condition))
+
+// Returns BUSY once, the protothread goes on with the next call
+#define PT_YIELD(pPt)                                                          \
+    do {                                                                       \
+        (pPt)->Line = __LINE__;                                                \
+        return BUSY;                                                           \
+    case __LINE__:;                                                            \
+    } while (0)
+
+// Runs a child protothread (call expression with its own PT_TypeDef) from its first step until it ends
+#define PT_SPAWN(pPt, pChild, Thread)                                          \
+    do {                                                                       \
+        PT_INIT(pChild);                                                       \
+        PT_WAIT_UNTIL(pPt, (Thread) != BUSY);                                  \
+    } while (0)
+
+// Ends the protothread before PT_END, it returns OK
+#define PT_EXIT(pPt)                                                           \
+    do {                                                                       \
+        PT_INIT(pPt);                                                          \
+        return OK;                                                             \
+    } while (0)
+
+#endif // !__PT_H__
@@ -0,0 +1,75 @@
+#ifndef __RING_H__
+#define __RING_H__
+
+#include "stm32f429zi.h"
+
+/*
+ * Lock-free single producer, single consumer ring. The producer (e.g. an interruption) only writes Head and the
+ * consumer (e.g. a task) only writes Tail, both are 32 bit-wide free running indexes (single-copy atomic). Memory
+ * barriers order the item accesses against the index publications, no interruption is ever masked. A ring type is
+ * declared with RING_DEFINE, several producers or consumers of the same ring need their own locking
+ */
+
+/* Exported TypeDefs */
+
+/*
+ * Indexes of a ring, masked with the capacity on access. Head - Tail is the amount of items
+ */
+typedef struct {
+  volatile uint32_t Head;             // Items pushed, written by the producer only
+  volatile uint32_t Tail;             // Items popped, written by the consumer only
+} Ring_IndexTypeDef;
+
+/* Exported macros */
+
+// Declares the ring type Name_TypeDef holding Size items of Type (Size is a power of 2) and its functions:
+//    * DriverStatus Name_Push(Name_TypeDef *pRing, const Type *pItem), producer side, BUSY if the ring is full
+//    * DriverStatus Name_Pop(Name_TypeDef *pRing, Type *pItem), consumer side, ERROR if the ring is empty
+//    * uint32_t Name_Count(Name_TypeDef *pRing), items in the ring, from either side
+// A zeroed ring (static storage) is empty
+#define RING_DEFINE(Name, Type, Size)                                          \
+    _Static_assert(((Size) & ((Size) - 1)) == 0,                               \
+                   #Name " size must be a power of 2");                        \
+                                                                               \
+    typedef struct {                                                           \
+        Ring_IndexTypeDef Index;                                               \
+        Type Buffer[(Size)];                                                   \
+    } Name##_TypeDef;                                                          \
+                                                                               \
+    static inline DriverStatus Name##_Push(Name##_TypeDef *pRing,              \
+                                           const Type *pItem) {                \
+        uint32_t head = pRing->Index.Head;                                     \
+                                                                               \
+        if ((head - pRing->Index.Tail) >= (Size)) {                            \
+            return BUSY;                                                       \
+        }                                                                      \
+        pRing->Buffer[head & ((Size) - 1)] = *pItem;                           \
+        /* The item is written before it is published */                       \
+        __DMB();                                                               \
+        pRing->Index.Head = head + 1;                                          \
+        return OK;                                                             \
+    }                                                                          \
+                                                                               \
+    static inline DriverStatus Name##_Pop(Name##_TypeDef *pRing,               \
+                                          Type *pItem) {                       \
+        uint32_t tail = pRing->Index.Tail;                                     \
+                                                                               \
+        if (pRing->Index.Head == tail) {                                       \
+            return ERROR;                                                      \
+        }                                                                      \
+        /* The item is read after its publication is seen */                   \
+        __DMB();                                                               \
+        *pItem = pRing->Buffer[tail & ((Size) - 1)];                           \
+        /* The slot is read before it is released to the producer */           \
+        __DMB();                                                               \
+        pRing->Index.Tail = tail + 1;                                          \
+        return OK;                                                             \
+    }                                                                          \
+                                                                               \
+    static inline uint32_t Name##_Count(Name##_TypeDef *pRing) {               \
+        uint32_t tail = pRing->Index.Tail;                                     \
+                                                                               \
+        return pRing->Index.Head - tail;                                       \
+    }
+
+#endif // !__RING_H__
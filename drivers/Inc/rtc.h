@@ -0,0 +1,45 @@
+#ifndef __RTC_H__
+#define __RTC_H__
+
+#include "stm32f429zi.h"
+
+/* Exported macros */
+
+// Loops waited for the LSE to be ready before the LSI is selected instead
+#define RTC_LSE_TIMEOUT 2000000
+
+// Longest wakeup period (s), WUTR[15:0] counts the 1 Hz ck_spre clock
+#define RTC_WAKEUP_MAX 65536
+
+// Longest wakeup period (ms) counted with RTCCLK / 16 (~0.5 ms resolution), longer periods count ck_spre
+#define RTC_WAKEUP_FINE_MAX 30000
+
+/* Exported TypeDefs */
+
+/*
+ * Defines the clock of the RTC (RTCCLK)
+ */
+typedef enum {
+ RTC_Source_LSE,                      // 32.768 kHz external crystal (X2 of the Nucleo board)
+ RTC_Source_LSI,                      // ~32 kHz internal oscillator, used when the LSE does not start
+} RTC_Config_Source;
+
+/* Exported functions */
+
+// Initialization function
+DriverStatus RTC_Init(void);
+RTC_Config_Source RTC_GetSource(void);
+
+// Timebase functions, the RTC keeps counting in Stop mode
+uint32_t RTC_GetSeconds(void);
+uint32_t RTC_GetMilliseconds(void);
+
+// Wakeup timer functions
+void RTC_SetWakeup(uint32_t Seconds);
+void RTC_SetWakeupMs(uint32_t Milliseconds);
+void RTC_StopWakeup(void);
+
+// Weak implementation of callback when the wakeup timer elapses
+void RTC_CallbackWakeup(void);
+
+#endif // !__RTC_H__
@@ -3,6 +3,14 @@
 
 #include "stm32f429zi.h"
 
+/* Exported macros */
+
+// Descriptors held by the transaction queue of every SPI handle, must be a power of two
+#define SPI_QUEUE_SIZE 8
+
+// SPI handles whose baud rate follows the clock profile (one per SPIx)
+#define SPI_REGISTRY_SIZE 6
+
 /* Exported TypeDefs */
 
 /*
@@ -70,6 +78,14 @@ typedef enum {
  SPI_DataFormat_16bit,                // 2 byte data lenght
 } SPI_Config_DataFormat;
 
+/*
+ * Defines how the bytes of the buffer are packed in 16-bit frames
+ */
+typedef enum {
+ SPI_ByteOrder_HalfWord,              // Every frame is a 16-bit value of the buffer (little endian in memory)
+ SPI_ByteOrder_Stream,                // Bytes are sent in the order of the buffer, as in 8-bit data format
+} SPI_Config_ByteOrder;
+
 /*
  * Interruption configuration
  */
@@ -84,8 +100,38 @@ typedef enum {
 typedef enum {
  SPI_TxState_Ready,                   // Tx Wire is ready to send data
  SPI_TxState_Busy,                    // Tx wire is sending data
+ SPI_TxState_Error,                   // DMA transfer aborted by a transfer error, reported once by SPI_GetStatusDMA
 } SPI_IT_TxState;
 
+/*
+ * Chip selection policy of a queued descriptor
+ */
+typedef enum {
+ SPI_CS_Keep,                         // CS stays LOW after the descriptor, the next descriptor continues the transaction
+ SPI_CS_Release,                      // CS goes HIGH once the last byte of the descriptor is shifted out
+} SPI_Queue_CSPolicy;
+
+/*
+ * Transfer held by the transaction queue. The buffer must be kept unmodified until the descriptor is sent
+ */
+typedef struct {
+  const uint8_t *pTxBuffer;           // Pointer to the data to send
+  uint16_t Len;                       // Bytes to send, can't be 0
+  PinLogicalLevel DC;                 // Level of the D/C pin while the descriptor is sent
+  SPI_Queue_CSPolicy CS;              // Chip selection policy after the descriptor, values can be of SPI_Queue_CSPolicy
+  void (*Callback)(void *pContext);   // Optional function invoked from the interruption once the descriptor is sent, can be NULL
+  void *pContext;                     // Argument of the callback
+} SPI_DescriptorTypeDef;
+
+/*
+ * Segment of a scatter-gather transfer. The segments of a list are sent back to back within one chip selection
+ */
+typedef struct {
+  const uint8_t *pTxBuffer;           // Pointer to the data to send, must be kept unmodified until the transfer ends
+  uint16_t Len;                       // Bytes to send, can't be 0
+  PinLogicalLevel DC;                 // Level of the D/C pin while the segment is sent
+} SPI_SegmentTypeDef;
+
 /*
  * SPI periphal configuration
  */
@@ -97,6 +143,8 @@ typedef struct{
   SPI_Config_FrameFormat FrameFormat; // Defines if the MSB or the LSB will be transmitted first. Values can be of SPI_Config_FrameFormat
   SPI_Config_SSM SSM;                 // Selects wether the peripheral will manage the chip selection by software or hardware, values can be of SPI_Config_SSM
   SPI_Config_DataFormat DataFormat;   // Configures the lenght of the data transmitted, values can be of SPI_Config_DataFormat
+  SPI_Config_ByteOrder ByteOrder;     // Packing of the buffer bytes in 16-bit data format, values can be of SPI_Config_ByteOrder
+  uint32_t MaxClock;                  // Highest SCK frequency (Hz), BaudRate is recomputed from it on every clock profile switch. 0 keeps BaudRate
 }SPI_ConfigTypeDef;
 
 /*
@@ -109,6 +157,16 @@ typedef struct{
   uint32_t TxLen;                     // Integer variable that holds the amount of bytes to send, used in interruption mode
   uint8_t *pTxBuffer;                 // Pointer to the data buffer, used in interruption mode
   SPI_IT_TxState TxState;             // Variable that indicates when the SPI is busy transmittin data, used in interruption mode
+  uint8_t SessionOpen;                // Set by SPI_OpenSession, the SPIx stays enabled between transfers until SPI_CloseSession
+  SPI_DescriptorTypeDef Queue[SPI_QUEUE_SIZE]; // Transaction queue, single producer (thread mode) and single consumer (interruption)
+  volatile uint8_t QueueHead;         // Free running index of the next descriptor to push, only written by the producer
+  volatile uint8_t QueueTail;         // Free running index of the descriptor being sent, only written by the interruption
+  GPIO_TypeDef *pControlGPIOx;        // GPIOx of the D/C and CS pins driven by the queue and the segment transfers
+  uint16_t DC_Mask;                   // D/C pin mask
+  uint16_t CS_Mask;                   // CS pin mask, 0 when CS is driven by hardware (NSS)
+  const SPI_SegmentTypeDef *pSegments; // Segment list of the DMA transfer in progress, NULL for single buffer transfers
+  uint8_t SegmentCount;               // Amount of segments of the list
+  volatile uint8_t SegmentIndex;      // Segment being streamed, advanced by SPI_DMA_IRQHandling (or SPI_GetStatusDMA)
 }SPI_DriverTypeDef;
 
 /* Exported functions */
@@ -116,14 +174,37 @@ typedef struct{
 // Initialization function
 DriverStatus SPI_Init(SPI_DriverTypeDef *pSPIDriver);
 
+// Configuration functions
+DriverStatus SPI_SetDataFormat(SPI_DriverTypeDef *pSPIDriver, SPI_Config_DataFormat DataFormat);
+void SPI_UpdateClock(void);
+
+// Session functions, keep the SPIx enabled across several blocking transfers
+void SPI_OpenSession(SPI_DriverTypeDef *pSPIDriver);
+void SPI_Flush(SPI_DriverTypeDef *pSPIDriver);
+void SPI_CloseSession(SPI_DriverTypeDef *pSPIDriver);
+
 // Data transmission functions
-void SPI_SendData(SPI_DriverTypeDef *pSPIDriver, uint8_t *pTxBuffer, uint32_t Len);
+void SPI_SendData(SPI_DriverTypeDef *pSPIDriver, const uint8_t *pTxBuffer, uint32_t Len);
 DriverStatus SPI_SendDataIT(SPI_DriverTypeDef *pSPIDriver, uint8_t *pTxBuffer, uint32_t Len);
+DriverStatus SPI_SendDataDMA(SPI_DriverTypeDef *pSPIDriver, DMA_DriverTypeDef *pDMADriver, const uint8_t *pTxBuffer, uint16_t Len);
+DriverStatus SPI_GetStatusDMA(SPI_DriverTypeDef *pSPIDriver, DMA_DriverTypeDef *pDMADriver);
+
+// Scatter-gather functions, the segments are sent in 8-bit frames within one chip selection
+void SPI_ControlPins_Init(SPI_DriverTypeDef *pSPIDriver, GPIO_TypeDef *pGPIOx, uint16_t DC_Mask, uint16_t CS_Mask);
+void SPI_SendSegments(SPI_DriverTypeDef *pSPIDriver, const SPI_SegmentTypeDef *pSegments, uint8_t Count);
+DriverStatus SPI_SendSegmentsIT(SPI_DriverTypeDef *pSPIDriver, const SPI_SegmentTypeDef *pSegments, uint8_t Count);
+DriverStatus SPI_SendSegmentsDMA(SPI_DriverTypeDef *pSPIDriver, DMA_DriverTypeDef *pDMADriver, const SPI_SegmentTypeDef *pSegments, uint8_t Count);
+
+// Transaction queue functions (interruption mode)
+DriverStatus SPI_Queue_Push(SPI_DriverTypeDef *pSPIDriver, const SPI_DescriptorTypeDef *pDescriptor);
+uint8_t SPI_Queue_GetFree(SPI_DriverTypeDef *pSPIDriver);
+uint8_t SPI_Queue_IsEmpty(SPI_DriverTypeDef *pSPIDriver);
 
 // Interruption configuring and handling
 void SPI_IRQ_Handling(SPI_DriverTypeDef *pSPIDriver);
 void SPI_IRQ_Control(IRQn_Type IRQNumber, EnableDisable EnOrDi);
 void SPI_IRQ_PriorityConfig(IRQn_Type IRQNumber, uint32_t IRQPriority);
+void SPI_DMA_IRQHandling(SPI_DriverTypeDef *pSPIDriver, DMA_DriverTypeDef *pDMADriver);
 
 // Weak implementation of callback when data has transmitted completely
 void SPI_CallbackTxCompleted(SPI_DriverTypeDef *pSPIDriver);
@@ -14,6 +14,18 @@
 // Shortcut definitions
 #define __vo volatile
 #define __weak __attribute__((weak))
+// Functions executed from SRAM without flash wait states, copied by the startup (.ramfunc section). Calls between
+// flash and SRAM are out of the BL range, the linker inserts long branch veneers
+#define __ramfunc __attribute__((section(".ramfunc"), noinline))
+// CPU-only data placed in the CCM-RAM, free of DMA contention but unreachable by the DMA streams. Initialised
+// (.ccmram section) or zeroed (.ccmbss section) by the startup
+#define __ccmram __attribute__((section(".ccmram")))
+#define __ccmbss __attribute__((section(".ccmbss")))
+// Buffers read or written by a DMA stream, kept in the main SRAM (.dmabuf section). DMA_Start rejects the CCM-RAM
+#define __dmabuf __attribute__((section(".dmabuf"), aligned(4)))
+// Data kept in the 4 KB backup SRAM across Standby mode (.bkpsram section), never initialised by the startup.
+// Accessible once Power_Init is invoked
+#define __bkpsram __attribute__((section(".bkpsram")))
 
 /* Exported TypeDefs */
 
@@ -54,8 +66,18 @@ typedef enum {
 void System_Init(void);
 
 
+#include "clock.h"
+#include "flash.h"
 #include "gpio.h"
+#include "dma.h"
 #include "spi.h"
 #include "timers.h"
+#include "rtc.h"
+#include "power.h"
+#include "defer.h"
+#include "swtimer.h"
+#include "pt.h"
+#include "ring.h"
+#include "atomic.h"
 
 #endif // !__STM32F429ZI_H__
@@ -0,0 +1,53 @@
+#ifndef __SWTIMER_H__
+#define __SWTIMER_H__
+
+#include "stm32f429zi.h"
+
+/* Exported macros */
+
+// Levels of the timer wheel, the slots of level L span 64^L ms. The wheel spans 64^4 ms (~4.6 h), longer timers
+// are placed in the last level and cascaded again
+#define SWTIMER_LEVELS 4
+
+// Slots per level (2^SWTIMER_SLOT_BITS), the occupancy of a level is a 64 bit-wide mask
+#define SWTIMER_SLOT_BITS 6
+#define SWTIMER_SLOTS (1 << SWTIMER_SLOT_BITS)
+
+/* Exported TypeDefs */
+
+typedef struct SWTimer_TypeDef SWTimer_TypeDef;
+
+/*
+ * Invoked once a software timer expires, from the deferred work (PendSV)
+ */
+typedef void (*SWTimer_Callback)(SWTimer_TypeDef *pTimer);
+
+/*
+ * Software timer. Callback, Period and pContext are set by the user, the rest is managed by the wheel. The
+ * structure must stay allocated while the timer is active
+ */
+struct SWTimer_TypeDef {
+  SWTimer_Callback Callback;          // Invoked when the timer expires
+  uint32_t Period;                    // Period of a periodic timer (ms), 0 for a one-shot timer
+  void *pContext;                     // User data of the callback
+  uint32_t Expiry;                    // Expiry time (RTC milliseconds), set by SWTimer_Start
+  SWTimer_TypeDef *pNext;             // Next timer of the same slot
+  SWTimer_TypeDef **ppPrev;           // Link pointing to this timer (unlinked in O(1)), NULL while inactive
+  uint8_t Level;                      // Level of the slot holding the timer
+  uint8_t Slot;                       // Slot holding the timer
+};
+
+/* Exported functions */
+
+// Initialization function
+void SWTimer_Init(void);
+
+// Timer control
+void SWTimer_Start(SWTimer_TypeDef *pTimer, uint32_t Milliseconds);
+void SWTimer_Stop(SWTimer_TypeDef *pTimer);
+uint8_t SWTimer_IsActive(SWTimer_TypeDef *pTimer);
+
+// Expires the due timers, deferred by the RTC wakeup interruption
+void SWTimer_Process(void);
+
+#endif // !__SWTIMER_H__
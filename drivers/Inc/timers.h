@@ -3,30 +3,23 @@
 
 #include "stm32f429zi.h"
 
-/* Extern variables */
-
-// Global variables to keep track of the time elapsed
-
-// Global ticks, triggered by the SysTick Interruption and used for delay function
-extern volatile uint32_t global_ticks;
-// Global seconds, triggered by the Timer 6 and used for the scheduler
-extern volatile uint32_t global_seconds;
-
 /* Exported functions */
 
 // Initialization fucntions
 void SysTick_Init(void);
-void Timer_Init(void);
 
-// delay function (in milliseconds)
-void delay(uint32_t ms);
+// Clock functions, invoked on every clock profile switch
+void SysTick_UpdateClock(void);
 
-// Scheduler function, triggered by the timer
-void Scheduler(void);
+// Monotonic timebase (milliseconds), deadline and timeout helpers
+uint64_t SysTick_GetMs(void);
+uint32_t SysTick_GetMs32(void);
+uint64_t SysTick_Deadline(uint32_t ms);
+FlagStatus SysTick_Expired(uint64_t Deadline);
+FlagStatus SysTick_Timeout(uint64_t Start, uint32_t ms);
 
-// Timer control
-void Timer_Enable(void);
-void Timer_Disable(void);
-void Timer_Start(void);
+// Waiting functions (in milliseconds), the CPU sleeps until the deadline
+void sleep_until(uint64_t Deadline);
+void delay(uint32_t ms);
 
 #endif 
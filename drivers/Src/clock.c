@@ -0,0 +1,322 @@
+#include "stm32f429zi.h"
+
+/* Global variables */
+
+// Clock tree of every profile
+const Clock_ProfileTypeDef Clock_Profiles[Clock_Profile_Count] = {
+    [Clock_Profile_Idle] = {.pName = "idle",
+                            .Source = Clock_Source_HSI,
+                            .AHB_Prescaler = Clock_AHB_div4,
+                            .APB1_Prescaler = Clock_APB_div1,
+                            .APB2_Prescaler = Clock_APB_div1},
+    [Clock_Profile_Run] = {.pName = "run",
+                           .Source = Clock_Source_HSI,
+                           .AHB_Prescaler = Clock_AHB_div1,
+                           .APB1_Prescaler = Clock_APB_div1,
+                           .APB2_Prescaler = Clock_APB_div1},
+    // 8 MHz / 4 = 2 MHz PLL input, * 180 = 360 MHz VCO, / 2 = 180 MHz
+    [Clock_Profile_Render] = {.pName = "render",
+                              .Source = Clock_Source_PLL,
+                              .PLL_M = 4,
+                              .PLL_N = 180,
+                              .PLL_P = 2,
+                              .PLL_Q = 8,
+                              .AHB_Prescaler = Clock_AHB_div1,
+                              .APB1_Prescaler = Clock_APB_div4,
+                              .APB2_Prescaler = Clock_APB_div2},
+};
+
+// Profile in use, the MCU starts on the HSI without prescalers
+static Clock_Profile clock_profile = Clock_Profile_Run;
+
+// Frequencies of the profile in use (Hz)
+static uint32_t clock_sysclk = HSI_VALUE;
+static uint32_t clock_hclk = HSI_VALUE;
+static uint32_t clock_pclk1 = HSI_VALUE;
+static uint32_t clock_pclk2 = HSI_VALUE;
+
+/* Static functions */
+static uint32_t Clock_get_SYSCLK(const Clock_ProfileTypeDef *pProfile);
+static uint32_t Clock_get_AHB_Shift(Clock_Config_AHBPrescaler Prescaler);
+static uint32_t Clock_get_APB_Shift(Clock_Config_APBPrescaler Prescaler);
+static void Clock_SwitchSource(uint32_t Source);
+static DriverStatus Clock_HSE_Enable(void);
+static void Clock_PLL_Disable(void);
+
+/*
+ * Switches the clock tree to a profile. The flash wait states and the ART
+ * accelerator follow HCLK, the SysTick timebase and the SPIx baud rates are
+ * recomputed so they keep their period in every profile. Must not be invoked
+ * while a transfer is in progress
+ *
+ * Params:
+ *    * Profile, the profile to switch to, values can be of Clock_Profile
+ * Returns:
+ *    * DriverStatus, ERROR if the profile is unknown or the HSE is not ready
+ * (the Run profile is set instead)
+ */
+DriverStatus Clock_SetProfile(Clock_Profile Profile) {
+    const Clock_ProfileTypeDef *pProfile;
+    uint32_t sysclk;
+    uint32_t hclk;
+
+    if (Profile >= Clock_Profile_Count) {
+        return ERROR;
+    }
+    pProfile = &Clock_Profiles[Profile];
+    sysclk = Clock_get_SYSCLK(pProfile);
+    hclk = sysclk >> Clock_get_AHB_Shift(pProfile->AHB_Prescaler);
+
+    // PWR controls the voltage scaling and the over-drive
+    RCC->APB1ENR |= RCC_APB1ENR_PWREN;
+
+    // Wait states are raised before a faster clock is selected
+    Flash_PrepareClock(hclk);
+
+    // The HSI drives the system while the PLL and the prescalers change
+    RCC->CR |= RCC_CR_HSION;
+    while (!(RCC->CR & RCC_CR_HSIRDY)) {
+        ;
+    }
+    Clock_SwitchSource(RCC_CFGR_SW_HSI);
+    Clock_PLL_Disable();
+
+    // HPRE[3:0], PPRE1[2:0] and PPRE2[2:0] prescalers, any value is valid for
+    // the HSI
+    RCC->CFGR = (RCC->CFGR &
+                 ~(RCC_CFGR_HPRE | RCC_CFGR_PPRE1 | RCC_CFGR_PPRE2)) |
+                (pProfile->AHB_Prescaler << RCC_CFGR_HPRE_Pos) |
+                (pProfile->APB1_Prescaler << RCC_CFGR_PPRE1_Pos) |
+                (pProfile->APB2_Prescaler << RCC_CFGR_PPRE2_Pos);
+
+    if (pProfile->Source == Clock_Source_HSI) {
+        // HSEBYP can only be cleared once the HSE is off
+        RCC->CR &= ~(RCC_CR_HSEON);
+        RCC->CR &= ~(RCC_CR_HSEBYP);
+    } else if (Clock_HSE_Enable() != OK) {
+        Clock_SetProfile(Clock_Profile_Run);
+        return ERROR;
+    }
+
+    if (pProfile->Source == Clock_Source_PLL) {
+        // PLLCFGR: PLLM[5:0], PLLN[8:0], PLLP[1:0] (0: /2, 1: /4, 2: /6,
+        // 3: /8), PLLSRC[0] (1: HSE) and PLLQ[3:0]
+        RCC->PLLCFGR = (pProfile->PLL_M << RCC_PLLCFGR_PLLM_Pos) |
+                       (pProfile->PLL_N << RCC_PLLCFGR_PLLN_Pos) |
+                       (((pProfile->PLL_P >> 1) - 1) << RCC_PLLCFGR_PLLP_Pos) |
+                       (RCC_PLLCFGR_PLLSRC_HSE) |
+                       (pProfile->PLL_Q << RCC_PLLCFGR_PLLQ_Pos);
+
+        // VOS[1:0] = 11, scale 1. It is applied while the PLL is on, the
+        // regulator runs in scale 3 otherwise
+        PWR->CR |= PWR_CR_VOS;
+
+        RCC->CR |= RCC_CR_PLLON;
+        while (!(RCC->CR & RCC_CR_PLLRDY)) {
+            ;
+        }
+
+        // Over-drive is needed above 168 MHz, it is enabled once the PLL is
+        // locked and before the PLL drives the system
+        if (sysclk > CLOCK_OVERDRIVE_THRESHOLD) {
+            PWR->CR |= PWR_CR_ODEN;
+            while (!(PWR->CSR & PWR_CSR_ODRDY)) {
+                ;
+            }
+            PWR->CR |= PWR_CR_ODSWEN;
+            while (!(PWR->CSR & PWR_CSR_ODSWRDY)) {
+                ;
+            }
+        }
+
+        Clock_SwitchSource(RCC_CFGR_SW_PLL);
+    } else if (pProfile->Source == Clock_Source_HSE) {
+        Clock_SwitchSource(RCC_CFGR_SW_HSE);
+    }
+
+    // Wait states are lowered once a slower clock is selected, the ART
+    // accelerator runs while there are wait states
+    Flash_UpdateClock(hclk);
+
+    clock_profile = Profile;
+    clock_sysclk = sysclk;
+    clock_hclk = hclk;
+    clock_pclk1 = hclk >> Clock_get_APB_Shift(pProfile->APB1_Prescaler);
+    clock_pclk2 = hclk >> Clock_get_APB_Shift(pProfile->APB2_Prescaler);
+
+    // Timebases and baud rates derived from the new frequencies
+    SysTick_UpdateClock();
+    SPI_UpdateClock();
+
+    return OK;
+}
+
+/*
+ * Returns the profile in use
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * Clock_Profile, the current profile
+ */
+Clock_Profile Clock_GetProfile(void) { return clock_profile; }
+
+/*
+ * Returns the frequency of the system clock
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * frequency, a 32 bit-wide integer with SYSCLK (Hz)
+ */
+uint32_t Clock_GetSYSCLK(void) { return clock_sysclk; }
+
+/*
+ * Returns the frequency of the AHB bus, the core and the SysTick
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * frequency, a 32 bit-wide integer with HCLK (Hz)
+ */
+uint32_t Clock_GetHCLK(void) { return clock_hclk; }
+
+/*
+ * Returns the frequency of the APB1 peripherals (SPI2, SPI3...)
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * frequency, a 32 bit-wide integer with PCLK1 (Hz)
+ */
+uint32_t Clock_GetPCLK1(void) { return clock_pclk1; }
+
+/*
+ * Returns the frequency of the APB2 peripherals (SPI1, SPI4...)
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * frequency, a 32 bit-wide integer with PCLK2 (Hz)
+ */
+uint32_t Clock_GetPCLK2(void) { return clock_pclk2; }
+
+/*
+ * Returns the frequency of the APB1 timers (TIM2..7, TIM12..14). Timers run at
+ * twice PCLK1 when the APB1 prescaler divides
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * frequency, a 32 bit-wide integer with the APB1 timers clock (Hz)
+ */
+uint32_t Clock_GetTimerClock1(void) {
+    return (clock_pclk1 == clock_hclk) ? clock_pclk1 : (clock_pclk1 << 1);
+}
+
+/*
+ * Returns the system clock frequency of a profile
+ *
+ * Params:
+ *    * pProfile, a pointer to the Clock_ProfileTypeDef
+ * Returns:
+ *    * frequency, a 32 bit-wide integer with SYSCLK (Hz)
+ */
+static uint32_t Clock_get_SYSCLK(const Clock_ProfileTypeDef *pProfile) {
+    switch (pProfile->Source) {
+    case Clock_Source_HSE:
+        return HSE_VALUE;
+    case Clock_Source_PLL:
+        return HSE_VALUE / pProfile->PLL_M * pProfile->PLL_N /
+               pProfile->PLL_P;
+    default:
+        return HSI_VALUE;
+    }
+}
+
+/*
+ * Returns the division of the AHB prescaler as a shift
+ *
+ * Params:
+ *    * Prescaler, values can be of Clock_Config_AHBPrescaler
+ * Returns:
+ *    * shift, log2 of the division
+ */
+static uint32_t Clock_get_AHB_Shift(Clock_Config_AHBPrescaler Prescaler) {
+    // HPRE values 8..15 divide by 2, 4, 8, 16, 64, 128, 256 and 512
+    static const uint8_t shifts[] = {1, 2, 3, 4, 6, 7, 8, 9};
+    return (Prescaler & 0x8) ? shifts[Prescaler & 0x7] : 0;
+}
+
+/*
+ * Returns the division of an APBx prescaler as a shift
+ *
+ * Params:
+ *    * Prescaler, values can be of Clock_Config_APBPrescaler
+ * Returns:
+ *    * shift, log2 of the division
+ */
+static uint32_t Clock_get_APB_Shift(Clock_Config_APBPrescaler Prescaler) {
+    // PPREx values 4..7 divide by 2, 4, 8 and 16
+    return (Prescaler & 0x4) ? (Prescaler & 0x3) + 1 : 0;
+}
+
+/*
+ * Selects the system clock source, waiting until the switch is done
+ *
+ * Params:
+ *    * Source, a 32 bit-wide integer with the SW bits of RCC_CFGR
+ * Returns:
+ *    * None
+ */
+static void Clock_SwitchSource(uint32_t Source) {
+    RCC->CFGR = (RCC->CFGR & ~(RCC_CFGR_SW)) | Source;
+
+    // SWS[1:0] reports the source in use, two bits above SW[1:0]
+    while ((RCC->CFGR & RCC_CFGR_SWS) != (Source << RCC_CFGR_SWS_Pos)) {
+        ;
+    }
+}
+
+/*
+ * Enables the HSE in bypass mode (the ST-LINK drives an 8 MHz clock)
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * DriverStatus, ERROR if the HSE is not ready within CLOCK_HSE_TIMEOUT
+ */
+static DriverStatus Clock_HSE_Enable(void) {
+    if (RCC->CR & RCC_CR_HSERDY) {
+        return OK;
+    }
+
+    RCC->CR |= RCC_CR_HSEBYP;
+    RCC->CR |= RCC_CR_HSEON;
+    for (uint32_t i = 0; !(RCC->CR & RCC_CR_HSERDY); i++) {
+        if (i == CLOCK_HSE_TIMEOUT) {
+            RCC->CR &= ~(RCC_CR_HSEON);
+            RCC->CR &= ~(RCC_CR_HSEBYP);
+            return ERROR;
+        }
+    }
+
+    return OK;
+}
+
+/*
+ * Disables the over-drive and the PLL, the system must run from another source
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+static void Clock_PLL_Disable(void) {
+    PWR->CR &= ~(PWR_CR_ODSWEN | PWR_CR_ODEN);
+
+    RCC->CR &= ~(RCC_CR_PLLON);
+    while (RCC->CR & RCC_CR_PLLRDY) {
+        ;
+    }
+}
@@ -0,0 +1,260 @@
+#include "stm32f429zi.h"
+
+/* Global variables */
+
+// Deferred calls, posted by the interruptions (head) and run by the PendSV
+// exception (tail). Indexes are free running, masked on access
+static Defer_Callback defer_queue[DEFER_QUEUE_SIZE];
+static volatile uint8_t defer_head;
+static volatile uint8_t defer_tail;
+
+// Tasks signaled since the last PendSV run (address of the latest one), a
+// lock-free stack pushed by the interruptions and emptied at once by the
+// PendSV exception
+static volatile uint32_t defer_signaled;
+
+// Ready queues of the tasks, one per priority. Bit p of defer_ready is set
+// while the queue of priority p holds a task. Only accessed by the PendSV
+// exception
+static Defer_TaskTypeDef *defer_ready_head[DEFER_TASK_PRIORITIES];
+static Defer_TaskTypeDef *defer_ready_tail[DEFER_TASK_PRIORITIES];
+static uint32_t defer_ready;
+
+/* Static functions */
+static void Defer_RunCalls(void);
+static void Defer_ReadySignaled(void);
+static Defer_TaskTypeDef *Defer_get_Ready(uint32_t *pEvents);
+
+/*
+ * Initializes the PendSV exception as the runner of the deferred work. With
+ * the lowest priority it runs once every other interruption has returned, just
+ * before the core goes back to thread mode (or back to sleep on exit)
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+void Defer_Init(void) {
+    defer_head = 0;
+    defer_tail = 0;
+    for (uint8_t priority = 0; priority < DEFER_TASK_PRIORITIES; priority++) {
+        defer_ready_head[priority] = NULL;
+        defer_ready_tail[priority] = NULL;
+    }
+    defer_ready = 0;
+    defer_signaled = 0;
+    NVIC_SetPriority(PendSV_IRQn, DEFER_PRIORITY);
+}
+
+/*
+ * Defers a call to the PendSV exception, interruptions post the long work
+ * (display updates...) and return at once. Can be invoked from thread mode or
+ * from the interruptions of ATOMIC_CRITICAL_PRIORITY or lower priority
+ *
+ * Params:
+ *    * Callback, the function to run
+ * Returns:
+ *    * DriverStatus, BUSY if the queue is full
+ */
+DriverStatus Defer_Post(Defer_Callback Callback) {
+    uint32_t state;
+
+    // Interruptions of several priorities post to the same queue
+    state = Atomic_EnterCritical();
+    if ((uint8_t)(defer_head - defer_tail) >= DEFER_QUEUE_SIZE) {
+        Atomic_ExitCritical(state);
+        return BUSY;
+    }
+    defer_queue[defer_head & (DEFER_QUEUE_SIZE - 1)] = Callback;
+    defer_head++;
+    Atomic_ExitCritical(state);
+
+    // PENDSVSET[0] pends the exception, it runs once the posting interruption
+    // (and any other active one) returns
+    SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+
+    return OK;
+}
+
+/*
+ * Signals events to a task, it is queued to run once if it was not ready.
+ * Events signaled again before the task runs are merged. Lock-free, can be
+ * invoked from any interruption or from thread mode
+ *
+ * Params:
+ *    * pTask, pointer to the Defer_TaskTypeDef
+ *    * Events, a 32 bit-wide integer with the events (bit mask, not 0)
+ * Returns:
+ *    * DriverStatus, ERROR if the priority of the task is out of range or no
+ * event is given
+ */
+DriverStatus Defer_Signal(Defer_TaskTypeDef *pTask, uint32_t Events) {
+    uint32_t head;
+
+    if ((pTask->Priority >= DEFER_TASK_PRIORITIES) || !Events) {
+        return ERROR;
+    }
+
+    // The events are merged first, a task taken out of its queue meanwhile is
+    // queued again and finds them
+    Atomic_Or(&pTask->Events, Events);
+
+    // Only the first signal pushes the task, an interruption that pushes in
+    // between makes the swap fail and it is tried again
+    if (!Atomic_Exchange(&pTask->Queued, 1)) {
+        do {
+            head = defer_signaled;
+            pTask->pNext = (Defer_TaskTypeDef *)head;
+        } while (!Atomic_CompareExchange(&defer_signaled, head,
+                                         (uint32_t)pTask));
+    }
+
+    SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+
+    return OK;
+}
+
+/*
+ * Handles the PendSV exception. Entry of the NVIC vector table. Runs every
+ * deferred call in posting order, then the ready task of highest priority,
+ * until nothing is left. The deferred calls posted by a task run before the
+ * next task
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+void PendSV_Handler(void) {
+    Defer_TaskTypeDef *pTask;
+    uint32_t events;
+    uint64_t start;
+
+    // The core may have been set to deep sleep on exit, the tasks sleep (WFI)
+    // in Sleep mode only
+    Power_ClearDeepSleep();
+
+    do {
+        Defer_RunCalls();
+
+        pTask = Defer_get_Ready(&events);
+        if (pTask != NULL) {
+            start = SysTick_GetMs();
+            pTask->Handler(events);
+            pTask->RunTime += (uint32_t)(SysTick_GetMs() - start);
+            pTask->Runs++;
+        }
+    } while (pTask != NULL);
+
+    Defer_CallbackQueueEmpty();
+}
+
+/*
+ * Weak implementation of the queue empty callback, overriden in user layer
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+__weak void Defer_CallbackQueueEmpty(void) { ; }
+
+/*
+ * Runs every deferred call in posting order, calls posted meanwhile are run
+ * too
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+static void Defer_RunCalls(void) {
+    Defer_Callback callback;
+
+    // Only this exception consumes the queue, the tail needs no lock
+    while (defer_tail != defer_head) {
+        callback = defer_queue[defer_tail & (DEFER_QUEUE_SIZE - 1)];
+        defer_tail++;
+        callback();
+    }
+}
+
+/*
+ * Moves the signaled tasks to their ready queues. The stack holds the latest
+ * signal first, it is reversed to keep the signaling order
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+static void Defer_ReadySignaled(void) {
+    Defer_TaskTypeDef *pTask;
+    Defer_TaskTypeDef *pOrdered = NULL;
+    Defer_TaskTypeDef *pNext;
+    uint8_t priority;
+
+    pTask = (Defer_TaskTypeDef *)Atomic_Exchange(&defer_signaled, 0);
+    while (pTask != NULL) {
+        pNext = pTask->pNext;
+        pTask->pNext = pOrdered;
+        pOrdered = pTask;
+        pTask = pNext;
+    }
+
+    while (pOrdered != NULL) {
+        pTask = pOrdered;
+        pOrdered = pTask->pNext;
+
+        priority = pTask->Priority;
+        pTask->pNext = NULL;
+        if (defer_ready_tail[priority] != NULL) {
+            defer_ready_tail[priority]->pNext = pTask;
+        } else {
+            defer_ready_head[priority] = pTask;
+        }
+        defer_ready_tail[priority] = pTask;
+        defer_ready |= (1UL << priority);
+    }
+}
+
+/*
+ * Takes the ready task of highest priority out of its queue, along with its
+ * pending events. A task queued again after its events were taken by its last
+ * run is skipped
+ *
+ * Params:
+ *    * pEvents, a pointer to a 32 bit-wide integer to store the events
+ * Returns:
+ *    * pTask, pointer to the Defer_TaskTypeDef to run, NULL if none is ready
+ */
+static Defer_TaskTypeDef *Defer_get_Ready(uint32_t *pEvents) {
+    Defer_TaskTypeDef *pTask;
+    uint8_t priority;
+
+    Defer_ReadySignaled();
+
+    while (defer_ready) {
+        // The lowest set bit is the highest priority
+        priority = __builtin_ctz(defer_ready);
+        pTask = defer_ready_head[priority];
+
+        defer_ready_head[priority] = pTask->pNext;
+        if (defer_ready_head[priority] == NULL) {
+            defer_ready_tail[priority] = NULL;
+            defer_ready &= ~(1UL << priority);
+        }
+        pTask->pNext = NULL;
+
+        // From here on a signal pushes the task again, the events are taken
+        // after the release so none is lost
+        Atomic_Exchange(&pTask->Queued, 0);
+        *pEvents = Atomic_Exchange(&pTask->Events, 0);
+        if (*pEvents) {
+            return pTask;
+        }
+    }
+
+    return NULL;
+}
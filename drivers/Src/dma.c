@@ -0,0 +1,294 @@
+#include "stm32f429zi.h"
+
+/* Static functions */
+static DMA_TypeDef *DMA_get_DMAx(DMA_Stream_TypeDef *pStream);
+static uint8_t DMA_get_Stream_number(DMA_Stream_TypeDef *pStream);
+static uint32_t DMA_get_Flag_offset(uint8_t Stream);
+static void DMA_ClearFlags(DMA_Stream_TypeDef *pStream);
+
+/*
+ * DMA initialization function. Used to configure the DMA stream
+ *
+ * Params:
+ *    * pDMADriver, pointer to a DMA_DriverTypeDef structure with the stream
+ * configurations
+ * Returns:
+ *    * DriverStatus, a flag that returns the succesfulness of the DMA
+ * initialization
+ */
+DriverStatus DMA_Init(DMA_DriverTypeDef *pDMADriver) {
+    DMA_Stream_TypeDef *pStream = pDMADriver->pStream;
+
+    if (pDMADriver->Config.Channel > 7) {
+        return ERROR;
+    }
+
+    // DMA controllers are on the AHB1 bus
+    if (DMA_get_DMAx(pStream) == DMA1) {
+        RCC->AHB1ENR |= RCC_AHB1ENR_DMA1EN;
+    } else {
+        RCC->AHB1ENR |= RCC_AHB1ENR_DMA2EN;
+    }
+
+    // The stream can only be configured while it is disabled
+    DMA_Stop(pDMADriver);
+
+    // SxCR configures the stream:
+    //    CHSEL[2:0]: request channel
+    //    PL[1:0]: priority level
+    //    MSIZE[1:0]/PSIZE[1:0]: memory/peripheral data size
+    //    MINC[0]: memory address incremented after every data item
+    //    DIR[1:0]: 00 peripheral to memory, 01 memory to peripheral, 10 memory
+    //    to memory
+    //    TCIE[0]: transfer complete interruption enable
+    //    TEIE[0]: transfer error interruption enable
+    // Peripheral address is fixed (data register), direct mode (no FIFO)
+    pStream->CR = (pDMADriver->Config.Channel << DMA_SxCR_CHSEL_Pos) |
+                  (pDMADriver->Config.Priority << DMA_SxCR_PL_Pos) |
+                  (pDMADriver->Config.DataSize << DMA_SxCR_MSIZE_Pos) |
+                  (pDMADriver->Config.DataSize << DMA_SxCR_PSIZE_Pos) |
+                  (DMA_SxCR_MINC) |
+                  (pDMADriver->Config.Direction << DMA_SxCR_DIR_Pos);
+    if (pDMADriver->Config.TCInterrupt == ENABLE) {
+        pStream->CR |= DMA_SxCR_TCIE | DMA_SxCR_TEIE;
+    }
+
+    return OK;
+}
+
+/*
+ * Starts a transfer between a memory buffer and a peripheral register
+ *
+ * Params:
+ *    * pDMADriver, pointer to a DMA_DriverTypeDef with the stream
+ *    * pMemory, pointer to the memory buffer, in the main SRAM or the flash.
+ * The CCM-RAM (stack, __ccmram/__ccmbss data) is not reachable by the streams
+ *    * pPeripheral, pointer to the peripheral register (usually its data
+ * register)
+ *    * Len, a 16 bit-wide integer with the amount of data items to transfer
+ * Returns:
+ *    * DriverStatus, BUSY if the stream is already transferring data, ERROR
+ * for a buffer in the CCM-RAM
+ */
+DriverStatus DMA_Start(DMA_DriverTypeDef *pDMADriver, const void *pMemory,
+                       volatile void *pPeripheral, uint16_t Len) {
+    DMA_Stream_TypeDef *pStream = pDMADriver->pStream;
+
+    // The stream would raise a transfer error on its first data item
+    if ((uint32_t)pMemory - DMA_CCMRAM_BASE < DMA_CCMRAM_SIZE) {
+        return ERROR;
+    }
+
+    if (pStream->CR & DMA_SxCR_EN) {
+        return BUSY;
+    }
+
+    // Flags of a previous transfer must be cleared before enabling the stream
+    DMA_ClearFlags(pStream);
+
+    // NDTR holds the amount of data items, M0AR/PAR the addresses
+    pStream->NDTR = Len;
+    pStream->M0AR = (uint32_t)pMemory;
+    pStream->PAR = (uint32_t)pPeripheral;
+
+    // Enable the stream, it starts serving the peripheral requests
+    pStream->CR |= DMA_SxCR_EN;
+
+    return OK;
+}
+
+/*
+ * Returns whether the stream has transferred all of its data items
+ *
+ * Params:
+ *    * pDMADriver, pointer to a DMA_DriverTypeDef with the stream
+ * Returns:
+ *    * FlagStatus, FLAG_HIGH when the transfer is complete
+ */
+FlagStatus DMA_GetTransferComplete(DMA_DriverTypeDef *pDMADriver) {
+    DMA_TypeDef *pDMAx = DMA_get_DMAx(pDMADriver->pStream);
+    uint8_t stream = DMA_get_Stream_number(pDMADriver->pStream);
+
+    // Streams 0..3 flags are in LISR, streams 4..7 flags in HISR. TCIF is the
+    // 6th bit of every stream flag group
+    uint32_t isr = (stream < 4) ? pDMAx->LISR : pDMAx->HISR;
+    if (isr & (DMA_LISR_TCIF0 << DMA_get_Flag_offset(stream))) {
+        return FLAG_HIGH;
+    }
+    return FLAG_LOW;
+}
+
+/*
+ * Clears the transfer complete flag of the stream, invoked by its interruption
+ * handler
+ *
+ * Params:
+ *    * pDMADriver, pointer to a DMA_DriverTypeDef with the stream
+ * Returns:
+ *    * None
+ */
+void DMA_ClearTransferComplete(DMA_DriverTypeDef *pDMADriver) {
+    DMA_TypeDef *pDMAx = DMA_get_DMAx(pDMADriver->pStream);
+    uint8_t stream = DMA_get_Stream_number(pDMADriver->pStream);
+
+    if (stream < 4) {
+        pDMAx->LIFCR = (DMA_LIFCR_CTCIF0 << DMA_get_Flag_offset(stream));
+    } else {
+        pDMAx->HIFCR = (DMA_LIFCR_CTCIF0 << DMA_get_Flag_offset(stream));
+    }
+}
+
+/*
+ * Returns whether the stream aborted its transfer on a bus error, the hardware
+ * disables the stream
+ *
+ * Params:
+ *    * pDMADriver, pointer to a DMA_DriverTypeDef with the stream
+ * Returns:
+ *    * FlagStatus, FLAG_HIGH when the transfer failed
+ */
+FlagStatus DMA_GetTransferError(DMA_DriverTypeDef *pDMADriver) {
+    DMA_TypeDef *pDMAx = DMA_get_DMAx(pDMADriver->pStream);
+    uint8_t stream = DMA_get_Stream_number(pDMADriver->pStream);
+
+    // TEIF is the 4th bit of every stream flag group
+    uint32_t isr = (stream < 4) ? pDMAx->LISR : pDMAx->HISR;
+    if (isr & (DMA_LISR_TEIF0 << DMA_get_Flag_offset(stream))) {
+        return FLAG_HIGH;
+    }
+    return FLAG_LOW;
+}
+
+/*
+ * Clears the transfer error flag of the stream, invoked by its interruption
+ * handler
+ *
+ * Params:
+ *    * pDMADriver, pointer to a DMA_DriverTypeDef with the stream
+ * Returns:
+ *    * None
+ */
+void DMA_ClearTransferError(DMA_DriverTypeDef *pDMADriver) {
+    DMA_TypeDef *pDMAx = DMA_get_DMAx(pDMADriver->pStream);
+    uint8_t stream = DMA_get_Stream_number(pDMADriver->pStream);
+
+    if (stream < 4) {
+        pDMAx->LIFCR = (DMA_LIFCR_CTEIF0 << DMA_get_Flag_offset(stream));
+    } else {
+        pDMAx->HIFCR = (DMA_LIFCR_CTEIF0 << DMA_get_Flag_offset(stream));
+    }
+}
+
+/*
+ * Returns whether the stream is enabled. The hardware disables the stream once
+ * the transfer is complete
+ *
+ * Params:
+ *    * pDMADriver, pointer to a DMA_DriverTypeDef with the stream
+ * Returns:
+ *    * FlagStatus, FLAG_HIGH while the stream is transferring data
+ */
+FlagStatus DMA_GetEnabled(DMA_DriverTypeDef *pDMADriver) {
+    if (pDMADriver->pStream->CR & DMA_SxCR_EN) {
+        return FLAG_HIGH;
+    }
+    return FLAG_LOW;
+}
+
+/*
+ * Disables the stream, aborting any transfer in progress
+ *
+ * Params:
+ *    * pDMADriver, pointer to a DMA_DriverTypeDef with the stream
+ * Returns:
+ *    * None
+ */
+void DMA_Stop(DMA_DriverTypeDef *pDMADriver) {
+    pDMADriver->pStream->CR &= ~(DMA_SxCR_EN);
+
+    // EN reads as 1 until the current data item is transferred
+    while (pDMADriver->pStream->CR & DMA_SxCR_EN) {
+        ;
+    }
+}
+
+/*
+ * Enables/Disables the IRQ of a DMA stream
+ *
+ * Params:
+ *    * IRQNumber, an integer defined in the CMSIS device file with the
+ * corresponding DMA stream IRQ number
+ *    * EnOrDi, an EnableDisable variable to decide whether the stream
+ * interruption will be enabled or disabled
+ * Returns:
+ *    * None
+ */
+void DMA_IRQ_Control(IRQn_Type IRQNumber, EnableDisable EnOrDi) {
+    if (EnOrDi == ENABLE) {
+        __NVIC_EnableIRQ(IRQNumber);
+    } else {
+        __NVIC_DisableIRQ(IRQNumber);
+    }
+}
+
+/*
+ * Returns the DMA controller of a stream
+ *
+ * Params:
+ *    * pStream, pointer to the DMA_Stream_TypeDef
+ * Returns:
+ *    * DMA_TypeDef, pointer to DMA1 or DMA2
+ */
+static DMA_TypeDef *DMA_get_DMAx(DMA_Stream_TypeDef *pStream) {
+    // Streams registers are placed after the 0x10 bytes of the interrupt
+    // registers of their controller, within the first 0x100 bytes
+    return (DMA_TypeDef *)((uint32_t)pStream & ~(uint32_t)0xFF);
+}
+
+/*
+ * Returns the number of the stream (0..7)
+ *
+ * Params:
+ *    * pStream, pointer to the DMA_Stream_TypeDef
+ * Returns:
+ *    * number, an 8 bit-wide integer with the stream number
+ */
+static uint8_t DMA_get_Stream_number(DMA_Stream_TypeDef *pStream) {
+    // Every stream takes 0x18 bytes, starting at offset 0x10
+    return (((uint32_t)pStream & 0xFF) - 0x10) / 0x18;
+}
+
+/*
+ * Returns the bit offset of the flags of a stream in its LISR/HISR register
+ *
+ * Params:
+ *    * Stream, an 8 bit-wide integer with the stream number
+ * Returns:
+ *    * offset, position of the first flag of the stream
+ */
+static uint32_t DMA_get_Flag_offset(uint8_t Stream) {
+    // Flag groups of streams 0/4, 1/5, 2/6 and 3/7 start at bits 0, 6, 16, 22
+    static const uint8_t offsets[] = {0, 6, 16, 22};
+    return offsets[Stream % 4];
+}
+
+/*
+ * Clears every interruption flag of the stream
+ *
+ * Params:
+ *    * pStream, pointer to the DMA_Stream_TypeDef
+ * Returns:
+ *    * None
+ */
+static void DMA_ClearFlags(DMA_Stream_TypeDef *pStream) {
+    DMA_TypeDef *pDMAx = DMA_get_DMAx(pStream);
+    uint8_t stream = DMA_get_Stream_number(pStream);
+
+    // LIFCR/HIFCR clear the flags writing '1' (6 flags per stream, one
+    // reserved)
+    if (stream < 4) {
+        pDMAx->LIFCR = (0x3D << DMA_get_Flag_offset(stream));
+    } else {
+        pDMAx->HIFCR = (0x3D << DMA_get_Flag_offset(stream));
+    }
+}
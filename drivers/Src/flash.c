@@ -0,0 +1,147 @@
+#include "stm32f429zi.h"
+
+/* Global variables */
+
+// ART accelerator requested, it only runs while the flash has wait states
+static EnableDisable flash_art = ENABLE;
+
+/* Static functions */
+static uint32_t Flash_get_Latency(uint32_t HCLK);
+static void Flash_SetLatency(uint32_t Latency);
+static void Flash_ApplyART(void);
+
+/*
+ * Raises the flash wait states before HCLK is increased, the flash must keep
+ * up with the new clock from its first cycle
+ *
+ * Params:
+ *    * HCLK, a 32 bit-wide integer with the upcoming HCLK (Hz)
+ * Returns:
+ *    * None
+ */
+void Flash_PrepareClock(uint32_t HCLK) {
+    uint32_t latency = Flash_get_Latency(HCLK);
+
+    if (latency > Flash_GetLatency()) {
+        Flash_SetLatency(latency);
+    }
+}
+
+/*
+ * Lowers the flash wait states once HCLK has decreased, and sets the ART
+ * accelerator for the new latency
+ *
+ * Params:
+ *    * HCLK, a 32 bit-wide integer with the HCLK in use (Hz)
+ * Returns:
+ *    * None
+ */
+void Flash_UpdateClock(uint32_t HCLK) {
+    uint32_t latency = Flash_get_Latency(HCLK);
+
+    if (latency < Flash_GetLatency()) {
+        Flash_SetLatency(latency);
+    }
+    Flash_ApplyART();
+}
+
+/*
+ * Returns the wait states of the flash
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * latency, a 32 bit-wide integer with the wait states (0..7)
+ */
+uint32_t Flash_GetLatency(void) { return FLASH->ACR & FLASH_ACR_LATENCY; }
+
+/*
+ * Enables/Disables the ART accelerator. While enabled it runs whenever the
+ * flash has wait states, without wait states every access takes one cycle and
+ * it is kept off
+ *
+ * Params:
+ *    * EnOrDi, an EnableDisable variable to decide whether the prefetch and the
+ * caches will be enabled or disabled
+ * Returns:
+ *    * None
+ */
+void Flash_ART_Control(EnableDisable EnOrDi) {
+    flash_art = EnOrDi;
+    Flash_ApplyART();
+}
+
+/*
+ * Invalidates the instruction and data caches, i.e. after the flash is
+ * programmed. The caches can only be reset while they are disabled
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+void Flash_ResetCaches(void) {
+    uint32_t enabled = FLASH->ACR & (FLASH_ACR_ICEN | FLASH_ACR_DCEN);
+
+    FLASH->ACR &= ~(FLASH_ACR_ICEN | FLASH_ACR_DCEN);
+
+    // ICRST[0]/DCRST[0] clear every line while set
+    FLASH->ACR |= (FLASH_ACR_ICRST | FLASH_ACR_DCRST);
+    FLASH->ACR &= ~(FLASH_ACR_ICRST | FLASH_ACR_DCRST);
+
+    FLASH->ACR |= enabled;
+}
+
+/*
+ * Returns the wait states needed for an HCLK
+ *
+ * Params:
+ *    * HCLK, a 32 bit-wide integer with the HCLK (Hz)
+ * Returns:
+ *    * latency, a 32 bit-wide integer with the wait states
+ */
+static uint32_t Flash_get_Latency(uint32_t HCLK) {
+    // One wait state per FLASH_WS_FREQUENCY: 0 up to 30 MHz, 5 up to 180 MHz
+    return (HCLK - 1) / FLASH_WS_FREQUENCY;
+}
+
+/*
+ * Sets the flash wait states, waiting until they are applied
+ *
+ * Params:
+ *    * Latency, a 32 bit-wide integer with the wait states (0..7)
+ * Returns:
+ *    * None
+ */
+static void Flash_SetLatency(uint32_t Latency) {
+    FLASH->ACR = (FLASH->ACR & ~(FLASH_ACR_LATENCY)) | Latency;
+
+    // The new latency must be read back before the clock changes
+    while (Flash_GetLatency() != Latency) {
+        ;
+    }
+}
+
+/*
+ * Enables the prefetch and the caches when they are requested and the flash
+ * has wait states, disables them otherwise. The caches are reset when they
+ * are turned on, lines of a previous period may be stale
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+static void Flash_ApplyART(void) {
+    const uint32_t art = FLASH_ACR_PRFTEN | FLASH_ACR_ICEN | FLASH_ACR_DCEN;
+
+    if ((flash_art == ENABLE) && Flash_GetLatency()) {
+        if ((FLASH->ACR & art) != art) {
+            FLASH->ACR &= ~(art);
+            Flash_ResetCaches();
+            FLASH->ACR |= art;
+        }
+    } else {
+        FLASH->ACR &= ~(art);
+    }
+}
@@ -1,5 +1,12 @@
 #include "gpio.h"
 
+/* Global variables */
+
+// Callback registered on every EXTI line and its context, indexed by the line
+// (pin) number. A line without callback falls back to GPIO_Callback_IRQTrigger
+static GPIO_IRQCallback gpio_irq_callbacks[GPIO_EXTI_LINES];
+static void *gpio_irq_contexts[GPIO_EXTI_LINES];
+
 /* Static functions */
 
 static void GPIO_PeripheralClockControl(GPIO_TypeDef *pGPIOx,
@@ -185,12 +192,13 @@ uint8_t GPIO_Pin_Read(GPIO_TypeDef *pGPIOx, uint8_t PinNumber) {
  */
 void GPIO_Pin_Write(GPIO_TypeDef *pGPIOx, uint8_t PinNumber,
                     PinLogicalLevel LorH) {
-    /* Writing to single pin in Output Data Register */
-    // ODRy writes to the y(0..15) pin.
+    /* Writing to single pin through the Bit Set/Reset Register */
+    // A single store to BSRR changes the pin without a read-modify-write on
+    // ODR, so an interruption writing other pins of the port is never undone
     if (LorH == HIGH) {
-        pGPIOx->ODR |= (uint16_t)(0x1 << PinNumber);
+        GPIO_Pin_Set(pGPIOx, PinNumber);
     } else {
-        pGPIOx->ODR &= (uint16_t) ~(0x1 << PinNumber);
+        GPIO_Pin_Reset(pGPIOx, PinNumber);
     }
 }
 
@@ -206,7 +214,12 @@ void GPIO_Pin_Write(GPIO_TypeDef *pGPIOx, uint8_t PinNumber,
  *    * None
  */
 void GPIO_Pin_Toggle(GPIO_TypeDef *pGPIOx, uint8_t PinNumber) {
-    pGPIOx->ODR ^= (uint16_t)(0x1 << PinNumber);
+    uint16_t mask = (uint16_t)(0x1 << PinNumber);
+    uint16_t odr = pGPIOx->ODR;
+
+    // Resets the pin if it is HIGH and sets it otherwise, the store only
+    // changes the desired pin
+    GPIO_Port_Write(pGPIOx, ~odr & mask, odr & mask);
 }
 
 /*
@@ -259,7 +272,77 @@ void GPIO_IRQ_PriorityConfig(IRQn_Type IRQNumber, uint32_t IRQPriority) {
 }
 
 /*
- * Handles the GPIO interruption. Invoked by the EXTI handler
+ * Masks/Unmasks the EXTI line of a pin, i.e. while a button bounces. The edges
+ * raised while the line is masked are discarded when it is unmasked
+ *
+ * Params:
+ *    * PinNumber, an 8 bit-wide integer with the pin (EXTI line) number
+ *    * EnOrDi, an EnableDisable variable, DISABLE masks the line
+ * Returns:
+ *    * None
+ */
+void GPIO_IRQ_LineControl(uint8_t PinNumber, EnableDisable EnOrDi) {
+    // EXTI_IMR masks the interruption requests of every line, EXTI_PR is
+    // cleared writing '1' to the line bit only
+    if (EnOrDi == ENABLE) {
+        EXTI->PR = (1 << PinNumber);
+        EXTI->IMR |= (1 << PinNumber);
+    } else {
+        EXTI->IMR &= ~(1 << PinNumber);
+    }
+}
+
+/*
+ * Registers the callback of a pin, invoked by the shared EXTI handlers
+ * whenever its line is pending. The pin must be configured with GPIO_Init (in
+ * interruption mode) and the EXTI interruption of its line enabled with
+ * GPIO_IRQ_Control
+ *
+ * Params:
+ *    * PinNumber, an 8 bit-wide integer with the pin (EXTI line) number
+ *    * Callback, the function to invoke, a GPIO_IRQCallback
+ *    * pContext, a pointer passed to the callback (i.e. the driver of the
+ * device wired to the pin)
+ * Returns:
+ *    * DriverStatus, ERROR if the pin is out of range, BUSY if another
+ * callback is registered on the line
+ */
+DriverStatus GPIO_IRQ_Register(uint8_t PinNumber, GPIO_IRQCallback Callback,
+                               void *pContext) {
+    if ((PinNumber >= GPIO_EXTI_LINES) || (Callback == NULL)) {
+        return ERROR;
+    }
+    if ((gpio_irq_callbacks[PinNumber] != NULL) &&
+        (gpio_irq_callbacks[PinNumber] != Callback)) {
+        return BUSY;
+    }
+
+    // The context is written before the callback is published to the handler
+    gpio_irq_contexts[PinNumber] = pContext;
+    __DMB();
+    gpio_irq_callbacks[PinNumber] = Callback;
+
+    return OK;
+}
+
+/*
+ * Removes the callback of a pin, its line falls back to
+ * GPIO_Callback_IRQTrigger
+ *
+ * Params:
+ *    * PinNumber, an 8 bit-wide integer with the pin (EXTI line) number
+ * Returns:
+ *    * None
+ */
+void GPIO_IRQ_Unregister(uint8_t PinNumber) {
+    if (PinNumber < GPIO_EXTI_LINES) {
+        gpio_irq_callbacks[PinNumber] = NULL;
+    }
+}
+
+/*
+ * Handles the GPIO interruption of a single line. Invoked by a user EXTI
+ * handler, the shared ones use GPIO_IRQ_Dispatch
  *
  * Params:
  *    * PinNumber: PinNumber, an 8 bit-wide integer that corresponds to the
@@ -268,19 +351,113 @@ void GPIO_IRQ_PriorityConfig(IRQn_Type IRQNumber, uint32_t IRQPriority) {
  *    * None
  */
 void GPIO_IRQ_Handling(uint8_t PinNumber) {
-    /* Handling GPIO IRQ interruptions */
+    GPIO_IRQ_Dispatch(1UL << PinNumber);
+}
+
+/*
+ * Serves every pending line of a group in a single entry of its EXTI handler.
+ * The lines are found with CLZ, highest line first, instead of testing them
+ * one by one
+ *
+ * Params:
+ *    * Lines, a 32 bit-wide mask with the lines served by the handler
+ * Returns:
+ *    * None
+ */
+void GPIO_IRQ_Dispatch(uint32_t Lines) {
+    uint32_t pending;
+    uint8_t line;
 
     // Whenever an interruption arises, the EXTI_PRx register sets a bit to
     // indicate there is a pending request on the EXTIx line. In order to clean
     // this (and avoid the NVIC continously triggering the EXTIx line), a '1'
-    // must be written
-
-    if (EXTI->PR & (1 << PinNumber)) {
-        EXTI->PR |= (1 << PinNumber);
-        GPIO_Callback_IRQTrigger(PinNumber);
+    // must be written. Only the lines taken are cleared (a read-modify-write
+    // would clear the other groups), masked lines are left pending
+    pending = EXTI->PR & EXTI->IMR & Lines;
+    EXTI->PR = pending;
+
+    while (pending) {
+        line = 31 - __CLZ(pending);
+        pending &= ~(1UL << line);
+
+        if (gpio_irq_callbacks[line] != NULL) {
+            gpio_irq_callbacks[line](line, gpio_irq_contexts[line]);
+        } else {
+            GPIO_Callback_IRQTrigger(line);
+        }
     }
 }
 
+/*
+ * Handles the EXTI line 0 interruption. Entry of the NVIC vector table
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+void EXTI0_IRQHandler(void) { GPIO_IRQ_Dispatch(EXTI_PR_PR0); }
+
+/*
+ * Handles the EXTI line 1 interruption. Entry of the NVIC vector table
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+void EXTI1_IRQHandler(void) { GPIO_IRQ_Dispatch(EXTI_PR_PR1); }
+
+/*
+ * Handles the EXTI line 2 interruption. Entry of the NVIC vector table
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+void EXTI2_IRQHandler(void) { GPIO_IRQ_Dispatch(EXTI_PR_PR2); }
+
+/*
+ * Handles the EXTI line 3 interruption. Entry of the NVIC vector table
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+void EXTI3_IRQHandler(void) { GPIO_IRQ_Dispatch(EXTI_PR_PR3); }
+
+/*
+ * Handles the EXTI line 4 interruption. Entry of the NVIC vector table
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+void EXTI4_IRQHandler(void) { GPIO_IRQ_Dispatch(EXTI_PR_PR4); }
+
+/*
+ * Handles the EXTI lines 5..9 interruption. Entry of the NVIC vector table
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+void EXTI9_5_IRQHandler(void) { GPIO_IRQ_Dispatch(GPIO_EXTI_9_5_LINES); }
+
+/*
+ * Handles the EXTI lines 10..15 interruption. Entry of the NVIC vector table
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+void EXTI15_10_IRQHandler(void) { GPIO_IRQ_Dispatch(GPIO_EXTI_15_10_LINES); }
+
 /*
  * Enables pGPIOx port clock
  *
@@ -348,7 +525,8 @@ static uint8_t GPIO_get_GPIOx_number(GPIO_TypeDef *pGPIOx) {
 }
 
 /*
- * Weak callback implementation of the GPIO interruption trigger
+ * Weak callback implementation of the GPIO interruption trigger, invoked for
+ * the lines without a registered callback
  *
  * Params:
  *    * PinNumber, 8 bit-wide integer that triggered the intertuption
@@ -0,0 +1,436 @@
+#include "stm32f429zi.h"
+
+/* Global variables */
+
+// Locks taken on every power mode, a locked mode and the deeper ones are not
+// entered by Power_Idle
+static volatile uint32_t power_locks[Power_Mode_Count];
+
+// Set when the MCU was reset by a Standby mode wakeup
+static uint8_t power_standby_wakeup;
+
+// Residency: milliseconds spent in every power mode, the mode the core is in
+// (or sleeps in on exit) and the start of its interval
+static uint32_t power_residency[Power_Mode_Count];
+static Power_Mode power_mode;
+static uint32_t power_since;
+
+/* Static functions */
+static Power_Mode Power_get_Deepest(void);
+static Power_Mode Power_get_Mode(uint32_t Deadline);
+static void Power_ConfigureStop(void);
+static DriverStatus Power_ConfigureStandby(void);
+static void Power_Account(Power_Mode Mode);
+
+/*
+ * Initializes the power manager. The backup SRAM (.bkpsram section) is clocked
+ * and kept by the backup regulator in Standby mode. Records and clears the
+ * Standby wakeup flags, the button (PC13) is given back to the GPIO. The
+ * residency is counted from here, must be invoked after RTC_Init
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+void Power_Init(void) {
+    RCC->APB1ENR |= RCC_APB1ENR_PWREN;
+    PWR->CR |= PWR_CR_DBP;
+
+    // Backup regulator, the backup SRAM is lost in Standby mode without it
+    RCC->AHB1ENR |= RCC_AHB1ENR_BKPSRAMEN;
+    PWR->CSR |= PWR_CSR_BRE;
+    while (!(PWR->CSR & PWR_CSR_BRR)) {
+        ;
+    }
+
+    // SBF[0] is set by a Standby mode wakeup, cleared with CSBF[0]
+    power_standby_wakeup = (PWR->CSR & PWR_CSR_SBF) ? 1 : 0;
+    PWR->CR |= (PWR_CR_CSBF | PWR_CR_CWUF);
+
+    // The tamper detection woke the MCU, PC13 is a GPIO input again. The RTC
+    // registers are write protected except TAFCR and the ISR flags
+    RTC->TAFCR &= ~(RTC_TAFCR_TAMP1E | RTC_TAFCR_TAMPIE);
+    RTC->ISR = ~(RTC_ISR_TAMP1F | RTC_ISR_INIT) | (RTC->ISR & RTC_ISR_INIT);
+
+    for (uint8_t mode = 0; mode < Power_Mode_Count; mode++) {
+        power_residency[mode] = 0;
+    }
+    power_mode = Power_Mode_Run;
+    power_since = RTC_GetMilliseconds();
+}
+
+/*
+ * Returns whether the MCU was reset by a Standby mode wakeup
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * wakeup, 1 after a Standby mode wakeup, 0 after any other reset
+ */
+uint8_t Power_WokeFromStandby(void) { return power_standby_wakeup; }
+
+/*
+ * Returns the time spent in a power mode since Power_Init, with the resolution
+ * of the RTC (~4 ms). A sleep lasts from its entry to the deferred work that
+ * follows it, the interruptions served in between (SysTick in Sleep mode) are
+ * accounted to it. Standby mode is lost with the reset it ends with
+ *
+ * Params:
+ *    * Mode, values can be of Power_Mode
+ * Returns:
+ *    * time, a 32 bit-wide integer with the milliseconds spent in the mode
+ */
+uint32_t Power_GetResidency(Power_Mode Mode) {
+    uint32_t state = Atomic_EnterCritical();
+    uint32_t ms = power_residency[Mode];
+
+    // The current mode is accounted up to now
+    if (Mode == power_mode) {
+        ms += RTC_GetMilliseconds() - power_since;
+    }
+    Atomic_ExitCritical(state);
+
+    return ms;
+}
+
+/*
+ * Forbids a power mode and the deeper ones until Power_Unlock is invoked, i.e.
+ * Stop mode while a DMA stream transfers a frame. Locks are counted with the
+ * atomic operations, can be invoked from any interruption
+ *
+ * Params:
+ *    * Mode, the shallowest forbidden mode, values can be of Power_Mode
+ * Returns:
+ *    * None
+ */
+void Power_Lock(Power_Mode Mode) { Atomic_Add(&power_locks[Mode], 1); }
+
+/*
+ * Releases a lock taken with Power_Lock
+ *
+ * Params:
+ *    * Mode, the mode passed to Power_Lock, values can be of Power_Mode
+ * Returns:
+ *    * None
+ */
+void Power_Unlock(Power_Mode Mode) {
+    uint32_t locks;
+
+    // The count is only decreased while a lock is held
+    do {
+        locks = power_locks[Mode];
+        if (!locks) {
+            return;
+        }
+    } while (!Atomic_CompareExchange(&power_locks[Mode], locks, locks - 1));
+}
+
+/*
+ * Enters the deepest power mode allowed by the locks and the next deadline:
+ *    * No deadline (POWER_NO_DEADLINE): Standby mode, the button wakes the MCU.
+ *    * A deadline of 1 s or more: Stop mode, the RTC wakeup timer wakes the
+ * MCU.
+ *    * Otherwise Sleep mode.
+ * The decision and the entry are done with the interruptions masked, an
+ * interruption raised meanwhile ends the low power mode at once. It is served
+ * once the clocks are restored
+ *
+ * Params:
+ *    * Deadline, a 32 bit-wide integer with the seconds until the next
+ * programmed wakeup, POWER_NO_DEADLINE when there is none
+ * Returns:
+ *    * Power_Mode, the mode that was entered
+ */
+Power_Mode Power_Idle(uint32_t Deadline) {
+    Power_Mode mode;
+
+    __disable_irq();
+
+    mode = Power_get_Mode(Deadline);
+    Power_Account(mode);
+
+    // WFI wakes up on a pending interruption even if PRIMASK masks it
+    switch (mode) {
+    case Power_Mode_Standby:
+        // Only returns when Standby mode is refused, the pending interruption
+        // is served once PRIMASK is cleared
+        Power_EnterStandby();
+        mode = Power_Mode_Sleep;
+        break;
+    case Power_Mode_Stop:
+        Power_EnterStop();
+        break;
+    case Power_Mode_Sleep:
+        Power_EnterSleep();
+        break;
+    default:
+        break;
+    }
+
+    Power_Account(Power_Mode_Run);
+    __enable_irq();
+
+    return mode;
+}
+
+/*
+ * Interruption driven execution: sets the power mode the core enters whenever
+ * it returns from the last active interruption (SLEEPONEXIT), thread mode is
+ * not resumed. The mode is chosen as in Power_Idle and must be set again
+ * whenever the locks or the deadline change, i.e. once the deferred work has
+ * run. With every mode locked the core returns to thread mode. The deep sleep
+ * is kept until Power_ClearDeepSleep, the residency of the mode is counted
+ * from here
+ *
+ * Params:
+ *    * Deadline, a 32 bit-wide integer with the seconds until the next
+ * programmed wakeup, POWER_NO_DEADLINE when there is none
+ * Returns:
+ *    * Power_Mode, the mode entered on exit
+ */
+Power_Mode Power_SleepOnExit(uint32_t Deadline) {
+    Power_Mode mode = Power_get_Mode(Deadline);
+
+    // Thread mode is not resumed to restore the HSE or the PLL after a Stop
+    // mode wakeup, Stop mode is only entered while the MCU runs on the HSI
+    if ((mode == Power_Mode_Stop) &&
+        (Clock_Profiles[Clock_GetProfile()].Source != Clock_Source_HSI)) {
+        mode = Power_Mode_Sleep;
+    }
+
+    switch (mode) {
+    case Power_Mode_Standby:
+        if (Power_ConfigureStandby() == OK) {
+            break;
+        }
+        // An edge is pending or the button is held, Sleep mode instead
+        mode = Power_Mode_Sleep;
+        SCB->SCR &= ~(SCB_SCR_SLEEPDEEP_Msk);
+        break;
+    case Power_Mode_Stop:
+        Power_ConfigureStop();
+        break;
+    case Power_Mode_Sleep:
+        SCB->SCR &= ~(SCB_SCR_SLEEPDEEP_Msk);
+        break;
+    default:
+        SCB->SCR &= ~(SCB_SCR_SLEEPONEXIT_Msk);
+        Power_Account(mode);
+        return mode;
+    }
+    Power_Account(mode);
+
+    // SLEEPONEXIT[0]: the core sleeps again right after the interruptions
+    SCB->SCR |= SCB_SCR_SLEEPONEXIT_Msk;
+
+    return mode;
+}
+
+/*
+ * Restores Sleep mode as the sleep of the core, undoing the deep sleep set by
+ * Power_SleepOnExit. Invoked when the deferred work starts: the waits on WFI
+ * (queue, wake-up) must not enter Stop mode while a transfer is in progress.
+ * The button is given back to the GPIO if Standby mode was configured. The
+ * sleep on exit ends its residency
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+void Power_ClearDeepSleep(void) {
+    SCB->SCR &= ~(SCB_SCR_SLEEPDEEP_Msk);
+    PWR->CR &= ~(PWR_CR_PDDS);
+    RTC->TAFCR &= ~(RTC_TAFCR_TAMP1E | RTC_TAFCR_TAMPIE);
+    Power_Account(Power_Mode_Run);
+}
+
+/*
+ * Enters Sleep mode until any interruption is raised. The CPU clock is stopped,
+ * the peripherals and DMA streams keep running
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+void Power_EnterSleep(void) {
+    SCB->SCR &= ~(SCB_SCR_SLEEPDEEP_Msk);
+    __WFI();
+}
+
+/*
+ * Enters Stop mode until an EXTI line interruption (RTC wakeup timer, button)
+ * wakes the MCU. Every clock of the 1.2 V domain is stopped, SRAM and
+ * registers are kept. The MCU wakes up on the HSI, the clock profile in use is
+ * restored when it runs from the HSE or the PLL. Must not be invoked while a
+ * transfer is in progress
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+void Power_EnterStop(void) {
+    Clock_Profile profile = Clock_GetProfile();
+
+    // SLEEPDEEP[0] is cleared after the wakeup so the other sleeps keep being
+    // Sleep mode
+    Power_ConfigureStop();
+    __WFI();
+    SCB->SCR &= ~(SCB_SCR_SLEEPDEEP_Msk);
+
+    // The HSE and the PLL are off after the wakeup
+    if (Clock_Profiles[profile].Source != Clock_Source_HSI) {
+        Clock_SetProfile(profile);
+    }
+}
+
+/*
+ * Enters Standby mode, the MCU is reset when the button is pressed. The button
+ * (PC13) is the tamper 1 input of the RTC, its rising edge wakes the MCU. Only
+ * the RTC and the backup SRAM are kept, the tamper event clears the RTC backup
+ * registers. Does not return, unless an EXTI line is pending or the button is
+ * held: Sleep mode is entered instead
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+void Power_EnterStandby(void) {
+    if (Power_ConfigureStandby() != OK) {
+        Power_EnterSleep();
+        return;
+    }
+
+    while (1) {
+        __WFI();
+    }
+}
+
+/*
+ * Returns the deepest power mode allowed by the locks
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * Power_Mode, the deepest mode that is not locked
+ */
+static Power_Mode Power_get_Deepest(void) {
+    Power_Mode mode = Power_Mode_Sleep;
+
+    while ((mode < Power_Mode_Count) && !power_locks[mode]) {
+        mode++;
+    }
+    return mode - 1;
+}
+
+/*
+ * Returns the power mode for a deadline, limited by the locks
+ *
+ * Params:
+ *    * Deadline, a 32 bit-wide integer with the seconds until the next
+ * programmed wakeup, POWER_NO_DEADLINE when there is none
+ * Returns:
+ *    * Power_Mode, the mode to enter
+ */
+static Power_Mode Power_get_Mode(uint32_t Deadline) {
+    Power_Mode mode;
+
+    if (Deadline == POWER_NO_DEADLINE) {
+        mode = Power_Mode_Standby;
+    } else if (Deadline > 0) {
+        mode = Power_Mode_Stop;
+    } else {
+        mode = Power_Mode_Sleep;
+    }
+    if (mode > Power_get_Deepest()) {
+        mode = Power_get_Deepest();
+    }
+    return mode;
+}
+
+/*
+ * Selects Stop mode as the deep sleep of the core
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+static void Power_ConfigureStop(void) {
+    RCC->APB1ENR |= RCC_APB1ENR_PWREN;
+
+    // PDDS[0] = 0: Stop mode (not Standby). LPDS[0]: low-power regulator,
+    // FPDS[0]: flash powered down
+    PWR->CR &= ~(PWR_CR_PDDS);
+    PWR->CR |= (PWR_CR_LPDS | PWR_CR_FPDS);
+
+    // SLEEPDEEP[0] selects Stop mode on WFI
+    SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+}
+
+/*
+ * Selects Standby mode as the deep sleep of the core, the button is set as the
+ * wakeup source. Standby mode is refused while an edge waits to be served or
+ * the button is held: the press would be lost, the tamper only wakes the MCU
+ * on a rising edge
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * DriverStatus, OK when Standby mode is selected, BUSY when an EXTI line
+ * is pending or the button is held (the deep sleep is not set)
+ */
+static DriverStatus Power_ConfigureStandby(void) {
+    RCC->APB1ENR |= RCC_APB1ENR_PWREN;
+    PWR->CR |= PWR_CR_DBP;
+
+    // TAMP1E[0]: PC13 as tamper input (TAMP1INSEL = 0), TAMP1TRG[0] = 0:
+    // rising edge (button pressed). TAMPIE[0] is needed to wake the MCU. A
+    // stale tamper flag would wake it at once
+    RTC->TAFCR &= ~(RTC_TAFCR_TAMP1E | RTC_TAFCR_TAMP1TRG);
+    RTC->ISR = ~(RTC_ISR_TAMP1F | RTC_ISR_INIT) | (RTC->ISR & RTC_ISR_INIT);
+    RTC->TAFCR |= (RTC_TAFCR_TAMP1E | RTC_TAFCR_TAMPIE);
+
+    // From here on a press is caught by the tamper. An unmasked pending line
+    // (a press raised before, the RTC wakeup) is still to be served: it can't
+    // be cleared. The interruption runs on return (Power_SleepOnExit) or once
+    // PRIMASK is cleared (Power_Idle)
+    if ((EXTI->PR & EXTI->IMR) || (GPIO_Pin_Read(GPIOC, 13) == HIGH)) {
+        RTC->TAFCR &= ~(RTC_TAFCR_TAMP1E | RTC_TAFCR_TAMPIE);
+        return BUSY;
+    }
+
+    // The masked lines would keep WFI from entering Standby mode, they are
+    // never served (no wakeup source)
+    EXTI->PR = EXTI->PR & ~(EXTI->IMR);
+
+    // PDDS[0]: Standby mode on deep sleep, WUF[0] must be cleared
+    PWR->CR |= (PWR_CR_PDDS | PWR_CR_CWUF);
+    SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+
+    return OK;
+}
+
+/*
+ * Ends the interval of the current power mode and starts one in the next mode.
+ * Thread mode and the deferred work both switch modes, the accounting is a
+ * critical section
+ *
+ * Params:
+ *    * Mode, the mode entered from now on, values can be of Power_Mode
+ * Returns:
+ *    * None
+ */
+static void Power_Account(Power_Mode Mode) {
+    uint32_t state = Atomic_EnterCritical();
+    uint32_t now = RTC_GetMilliseconds();
+
+    power_residency[power_mode] += now - power_since;
+    power_mode = Mode;
+    power_since = now;
+    Atomic_ExitCritical(state);
+}
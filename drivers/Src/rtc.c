@@ -0,0 +1,376 @@
+#include "stm32f429zi.h"
+
+/* Global variables */
+
+// Clock of the RTC and synchronous prescaler, ck_spre = RTCCLK /
+// (PREDIV_A + 1) / (PREDIV_S + 1) = 1 Hz
+static RTC_Config_Source rtc_source;
+static uint32_t rtc_prediv_s;
+
+// Frequency of the RTCCLK (Hz), the LSI is taken as its nominal 32 kHz
+static uint32_t rtc_clock;
+
+// Days elapsed since the first read and time of day of the last read (s), the
+// time of day rolls over at midnight. Updated within a critical section
+static uint32_t rtc_days;
+static uint32_t rtc_last_second;
+
+/* Static functions */
+static void RTC_WriteProtection(EnableDisable EnOrDi);
+static void RTC_ReadTime(uint32_t *pSeconds, uint32_t *pSubSeconds);
+static void RTC_ProgramWakeup(uint32_t Reload, uint32_t ClockSelection);
+
+/*
+ * Initializes the RTC as the timebase of the scheduler. The RTC runs from the
+ * LSE (or the LSI when the LSE does not start) and keeps counting in Stop mode.
+ * Its wakeup timer, routed to EXTI line 22, wakes the MCU from Stop mode.
+ * The calendar is kept if it was already running (backup domain powered)
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * DriverStatus, ERROR if the LSE did not start (the LSI is used instead)
+ */
+DriverStatus RTC_Init(void) {
+    DriverStatus status = OK;
+    uint32_t timeout = RTC_LSE_TIMEOUT;
+
+    // The backup domain (RCC_BDCR and RTC registers) is write protected by
+    // DBP[0]
+    RCC->APB1ENR |= RCC_APB1ENR_PWREN;
+    PWR->CR |= PWR_CR_DBP;
+
+    // RTCSEL[1:0] can only be written once after a backup domain reset
+    if (!(RCC->BDCR & RCC_BDCR_RTCEN)) {
+        RCC->BDCR |= RCC_BDCR_LSEON;
+        while (!(RCC->BDCR & RCC_BDCR_LSERDY) && timeout) {
+            timeout--;
+        }
+
+        if (RCC->BDCR & RCC_BDCR_LSERDY) {
+            RCC->BDCR |= RCC_BDCR_RTCSEL_0;
+        } else {
+            RCC->BDCR &= ~(RCC_BDCR_LSEON);
+            RCC->CSR |= RCC_CSR_LSION;
+            while (!(RCC->CSR & RCC_CSR_LSIRDY)) {
+                ;
+            }
+            RCC->BDCR |= RCC_BDCR_RTCSEL_1;
+            status = ERROR;
+        }
+        RCC->BDCR |= RCC_BDCR_RTCEN;
+    } else if ((RCC->BDCR & RCC_BDCR_RTCSEL) == RCC_BDCR_RTCSEL_1) {
+        // The LSI is not part of the backup domain, it is off after a reset
+        RCC->CSR |= RCC_CSR_LSION;
+        while (!(RCC->CSR & RCC_CSR_LSIRDY)) {
+            ;
+        }
+    }
+
+    // PREDIV_A = 127, PREDIV_S = 255 (LSE) or 249 (LSI, 32 kHz)
+    if ((RCC->BDCR & RCC_BDCR_RTCSEL) == RCC_BDCR_RTCSEL_0) {
+        rtc_source = RTC_Source_LSE;
+        rtc_prediv_s = 255;
+        rtc_clock = 32768;
+    } else {
+        rtc_source = RTC_Source_LSI;
+        rtc_prediv_s = 249;
+        rtc_clock = 32000;
+    }
+
+    RTC_WriteProtection(DISABLE);
+
+    // The calendar is set once, INITS[0] is kept while the backup domain is
+    // powered
+    if (!(RTC->ISR & RTC_ISR_INITS) ||
+        ((RTC->PRER & RTC_PRER_PREDIV_S) != rtc_prediv_s)) {
+        RTC->ISR |= RTC_ISR_INIT;
+        while (!(RTC->ISR & RTC_ISR_INITF)) {
+            ;
+        }
+
+        // Both prescalers are written in two separate accesses, PREDIV_S
+        // first
+        RTC->PRER = rtc_prediv_s;
+        RTC->PRER |= (127 << RTC_PRER_PREDIV_A_Pos);
+
+        // 00:00:00 (24 hour format) of Monday 01/01/2001, any year other than
+        // 2000 sets INITS[0]
+        RTC->TR = 0;
+        RTC->DR = (1 << 16) | (1 << 13) | (1 << 8) | 1;
+        RTC->CR &= ~(RTC_CR_FMT);
+
+        RTC->ISR &= ~(RTC_ISR_INIT);
+    }
+
+    // BYPSHAD[0] reads the counters directly, they are valid right after a
+    // Stop mode wakeup (the shadow registers are not synchronized in Stop)
+    RTC->CR |= RTC_CR_BYPSHAD;
+
+    RTC_WriteProtection(ENABLE);
+
+    // The wakeup event reaches the EXTI line 22 (rising edge), its interruption
+    // wakes the MCU from Stop mode
+    EXTI->IMR |= EXTI_IMR_MR22;
+    EXTI->RTSR |= EXTI_RTSR_TR22;
+    NVIC_SetPriority(RTC_WKUP_IRQn, 15);
+    NVIC_EnableIRQ(RTC_WKUP_IRQn);
+
+    rtc_last_second = 0;
+    rtc_days = 0;
+
+    return status;
+}
+
+/*
+ * Returns the clock of the RTC
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * RTC_Config_Source, the LSE or the LSI
+ */
+RTC_Config_Source RTC_GetSource(void) { return rtc_source; }
+
+/*
+ * Returns the seconds elapsed since midnight of the first day counted by the
+ * RTC. Must be invoked at least once a day to count the day rollover, the
+ * wakeup timer of the scheduler elapses every minute. Can be invoked from the
+ * interruptions of ATOMIC_CRITICAL_PRIORITY or lower priority
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * seconds, a 32 bit-wide integer with the elapsed seconds
+ */
+uint32_t RTC_GetSeconds(void) {
+    uint32_t seconds;
+    uint32_t sub_seconds;
+
+    RTC_ReadTime(&seconds, &sub_seconds);
+
+    return seconds;
+}
+
+/*
+ * Returns the milliseconds elapsed since midnight of the first day counted by
+ * the RTC, with the resolution of the synchronous prescaler (~4 ms). Wraps
+ * around after 49 days, differences of two readings stay valid. Can be invoked
+ * from the interruptions of ATOMIC_CRITICAL_PRIORITY or lower priority
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * milliseconds, a 32 bit-wide integer with the elapsed milliseconds
+ */
+uint32_t RTC_GetMilliseconds(void) {
+    uint32_t seconds;
+    uint32_t sub_seconds;
+
+    RTC_ReadTime(&seconds, &sub_seconds);
+
+    // SS[15:0] counts down from PREDIV_S every second
+    return (seconds * 1000) +
+           (((rtc_prediv_s - sub_seconds) * 1000) / (rtc_prediv_s + 1));
+}
+
+/*
+ * Programs the wakeup timer to elapse once after a period, its interruption
+ * invokes RTC_CallbackWakeup. It elapses on a second boundary of the calendar,
+ * the first one comes within a second. Any previous period is cancelled
+ *
+ * Params:
+ *    * Seconds, a 32 bit-wide integer with the period (1..RTC_WAKEUP_MAX)
+ * Returns:
+ *    * None
+ */
+void RTC_SetWakeup(uint32_t Seconds) {
+    if (Seconds == 0) {
+        Seconds = 1;
+    } else if (Seconds > RTC_WAKEUP_MAX) {
+        Seconds = RTC_WAKEUP_MAX;
+    }
+
+    // WUCKSEL[2:0] = 10x, ck_spre (1 Hz)
+    RTC_ProgramWakeup(Seconds - 1, RTC_CR_WUCKSEL_2);
+}
+
+/*
+ * Programs the wakeup timer to elapse once after a period in milliseconds, its
+ * interruption invokes RTC_CallbackWakeup. Up to RTC_WAKEUP_FINE_MAX the
+ * period is rounded up to the RTCCLK / 16 resolution (~0.5 ms), longer periods
+ * are rounded up to the second boundaries of the calendar. The wakeup never
+ * elapses early. Any previous period is cancelled
+ *
+ * Params:
+ *    * Milliseconds, a 32 bit-wide integer with the period
+ * Returns:
+ *    * None
+ */
+void RTC_SetWakeupMs(uint32_t Milliseconds) {
+    uint32_t ticks;
+    uint32_t seconds;
+    uint32_t sub_seconds;
+    uint32_t to_second;
+
+    if (Milliseconds > RTC_WAKEUP_FINE_MAX) {
+        // ck_spre ticks on the second boundaries, the first one within a
+        // second (SS[15:0] reaches 0)
+        RTC_ReadTime(&seconds, &sub_seconds);
+        to_second = ((sub_seconds + 1) * 1000) / (rtc_prediv_s + 1);
+        RTC_SetWakeup((((Milliseconds - to_second) + 999) / 1000) + 1);
+        return;
+    }
+
+    ticks = ((Milliseconds * (rtc_clock / 16)) + 999) / 1000;
+    if (ticks == 0) {
+        ticks = 1;
+    }
+
+    // WUCKSEL[2:0] = 000, RTCCLK / 16
+    RTC_ProgramWakeup(ticks - 1, 0);
+}
+
+/*
+ * Disables the wakeup timer, no further wakeup interruptions are raised
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+void RTC_StopWakeup(void) {
+    RTC_WriteProtection(DISABLE);
+    RTC->CR &= ~(RTC_CR_WUTE | RTC_CR_WUTIE);
+    RTC_WriteProtection(ENABLE);
+
+    RTC->ISR = ~(RTC_ISR_WUTF | RTC_ISR_INIT) | (RTC->ISR & RTC_ISR_INIT);
+    EXTI->PR = EXTI_PR_PR22;
+}
+
+/*
+ * Handles the RTC wakeup interruption. Entry of the NVIC vector table
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+void RTC_WKUP_IRQHandler(void) {
+    // WUTF[0] is cleared writing '0', the other flags are kept writing '1'.
+    // The EXTI line flag is cleared writing '1'
+    RTC->ISR = ~(RTC_ISR_WUTF | RTC_ISR_INIT) | (RTC->ISR & RTC_ISR_INIT);
+    EXTI->PR = EXTI_PR_PR22;
+
+    // A single period is programmed at a time, the timer is stopped until the
+    // next one is set
+    RTC_WriteProtection(DISABLE);
+    RTC->CR &= ~(RTC_CR_WUTE | RTC_CR_WUTIE);
+    RTC_WriteProtection(ENABLE);
+
+    RTC_CallbackWakeup();
+}
+
+/*
+ * Weak implementation of the wakeup callback, overriden in user layer
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+__weak void RTC_CallbackWakeup(void) { ; }
+
+/*
+ * Enables/Disables the write protection of the RTC registers
+ *
+ * Params:
+ *    * EnOrDi, an EnableDisable variable, DISABLE unlocks the registers
+ * Returns:
+ *    * None
+ */
+static void RTC_WriteProtection(EnableDisable EnOrDi) {
+    if (EnOrDi == ENABLE) {
+        // Any wrong key locks the registers again
+        RTC->WPR = 0xFF;
+    } else {
+        RTC->WPR = 0xCA;
+        RTC->WPR = 0x53;
+    }
+}
+
+/*
+ * Programs and enables the wakeup timer, any previous period is cancelled
+ *
+ * Params:
+ *    * Reload, a 32 bit-wide integer with the WUTR value, the wakeup flag
+ * rises after Reload + 1 periods of the clock
+ *    * ClockSelection, a 32 bit-wide integer with the WUCKSEL[2:0] bits
+ * Returns:
+ *    * None
+ */
+static void RTC_ProgramWakeup(uint32_t Reload, uint32_t ClockSelection) {
+    RTC_WriteProtection(DISABLE);
+
+    // WUTR can only be written while the timer is disabled and WUTWF[0] is set
+    RTC->CR &= ~(RTC_CR_WUTE | RTC_CR_WUTIE);
+    while (!(RTC->ISR & RTC_ISR_WUTWF)) {
+        ;
+    }
+    RTC->ISR = ~(RTC_ISR_WUTF | RTC_ISR_INIT) | (RTC->ISR & RTC_ISR_INIT);
+    EXTI->PR = EXTI_PR_PR22;
+
+    RTC->WUTR = Reload;
+    RTC->CR = (RTC->CR & ~(RTC_CR_WUCKSEL)) | ClockSelection;
+    RTC->CR |= (RTC_CR_WUTE | RTC_CR_WUTIE);
+
+    RTC_WriteProtection(ENABLE);
+}
+
+/*
+ * Reads the time of the calendar, counting the day rollovers. The reading and
+ * the rollover update are a critical section: a reader preempted in between
+ * would count a rollover twice or compare against a newer reading
+ *
+ * Params:
+ *    * pSeconds, a pointer to a 32 bit-wide integer to store the elapsed
+ * seconds
+ *    * pSubSeconds, a pointer to a 32 bit-wide integer to store SS[15:0]
+ * Returns:
+ *    * None
+ */
+static void RTC_ReadTime(uint32_t *pSeconds, uint32_t *pSubSeconds) {
+    uint32_t tr;
+    uint32_t ssr;
+    uint32_t second;
+    uint32_t state;
+
+    state = Atomic_EnterCritical();
+
+    // With BYPSHAD[0] the counters are read directly, the reading is repeated
+    // if a second elapsed in between
+    do {
+        ssr = RTC->SSR & RTC_SSR_SS;
+        tr = RTC->TR;
+    } while ((ssr != (RTC->SSR & RTC_SSR_SS)) || (tr != RTC->TR));
+
+    // TR holds the time of day in BCD
+    second = ((((tr & RTC_TR_HT) >> RTC_TR_HT_Pos) * 10) +
+              ((tr & RTC_TR_HU) >> RTC_TR_HU_Pos)) *
+                 3600 +
+             ((((tr & RTC_TR_MNT) >> RTC_TR_MNT_Pos) * 10) +
+              ((tr & RTC_TR_MNU) >> RTC_TR_MNU_Pos)) *
+                 60 +
+             (((tr & RTC_TR_ST) >> RTC_TR_ST_Pos) * 10) +
+             ((tr & RTC_TR_SU) >> RTC_TR_SU_Pos);
+
+    if (second < rtc_last_second) {
+        rtc_days++;
+    }
+    rtc_last_second = second;
+
+    *pSeconds = (rtc_days * 86400) + second;
+    *pSubSeconds = ssr;
+
+    Atomic_ExitCritical(state);
+}
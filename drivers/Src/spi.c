@@ -1,11 +1,29 @@
 #include "spi.h"
 
+/* Global variables */
+
+// Handles whose baud rate follows the clock profile, filled by SPI_Init
+static __ccmbss SPI_DriverTypeDef *spi_registry[SPI_REGISTRY_SIZE];
+
 /* Static functions */
 static void SPI_PeripheralClockControl(SPI_TypeDef *pSPIx,
                                        EnableDisable EnorDi);
-static FlagStatus SPI_GetFlag(SPI_TypeDef *pSPIx, uint32_t flag);
-static void SPI_IRQHandleTXe(SPI_DriverTypeDef *pSPIDriver);
-static void SPI_CloseTransmission(SPI_DriverTypeDef *pSPIDriver);
+static inline FlagStatus SPI_GetFlag(SPI_TypeDef *pSPIx, uint32_t flag);
+static __ramfunc void SPI_IRQHandleTXe(SPI_DriverTypeDef *pSPIDriver);
+static __ramfunc void SPI_CloseTransmission(SPI_DriverTypeDef *pSPIDriver);
+static void SPI_AbortDMA(SPI_DriverTypeDef *pSPIDriver,
+                         DMA_DriverTypeDef *pDMADriver);
+static __ramfunc void SPI_WaitIdle(SPI_TypeDef *pSPIx);
+static __ramfunc void SPI_Queue_HandleTXe(SPI_DriverTypeDef *pSPIDriver);
+static __ramfunc uint8_t SPI_Queue_Next(SPI_DriverTypeDef *pSPIDriver);
+static __ramfunc void SPI_WriteDC(SPI_DriverTypeDef *pSPIDriver,
+                                  PinLogicalLevel DC, uint16_t CS_Mask);
+static uint8_t SPI_Segments_Next(SPI_DriverTypeDef *pSPIDriver,
+                                 DMA_DriverTypeDef *pDMADriver);
+static SPI_Config_BaudRate SPI_get_BaudRate(SPI_DriverTypeDef *pSPIDriver);
+static void SPI_Register(SPI_DriverTypeDef *pSPIDriver);
+static inline uint16_t SPI_get_HalfWord(SPI_DriverTypeDef *pSPIDriver,
+                                        const uint8_t *pTxBuffer);
 
 /*
  * SPI initilaization function. Used to configure the SPI port
@@ -83,6 +101,13 @@ DriverStatus SPI_Init(SPI_DriverTypeDef *pSPIDriver) {
 
     /* Select Baud Rate divider */
 
+    // With MaxClock the divider is derived from the bus clock, and recomputed
+    // on every clock profile switch
+    if (pSPIDriver->Config.MaxClock) {
+        pSPIDriver->Config.BaudRate = SPI_get_BaudRate(pSPIDriver);
+        SPI_Register(pSPIDriver);
+    }
+
     // BR[2:0] selects the BaudRate divider
     pSPIDriver->pSPIx->CR1 |= (pSPIDriver->Config.BaudRate << SPI_CR1_BR_Pos);
 
@@ -122,7 +147,135 @@ DriverStatus SPI_Init(SPI_DriverTypeDef *pSPIDriver) {
 }
 
 /*
- * Sending data via SPIx in blocking mode
+ * Changes the data frame format of the SPIx at runtime, i.e. 8-bit frames for
+ * commands and 16-bit frames for bulk payloads. DFF can only be written while
+ * the SPIx is disabled
+ *
+ * Params:
+ *    * pSPIDriver, a pointer to SPI_DriverTypeDef that contains the SPIx
+ *    * DataFormat, the new data format, values can be of SPI_Config_DataFormat
+ * Returns:
+ *    * DriverStatus, BUSY if the SPIx is enabled (transfer in progress)
+ */
+DriverStatus SPI_SetDataFormat(SPI_DriverTypeDef *pSPIDriver,
+                               SPI_Config_DataFormat DataFormat) {
+    SPI_TypeDef *pSPIx = pSPIDriver->pSPIx;
+
+    if (pSPIDriver->Config.DataFormat == DataFormat) {
+        return OK;
+    }
+
+    // Within a session the SPIx is flushed and disabled for the change, out
+    // of a session it is only enabled by a transfer in progress
+    if (pSPIDriver->SessionOpen) {
+        SPI_WaitIdle(pSPIx);
+        pSPIx->CR1 &= ~(SPI_CR1_SPE);
+    } else if (pSPIx->CR1 & SPI_CR1_SPE) {
+        return BUSY;
+    }
+
+    // DFF[0]
+    //  0: 8-bit data frame format
+    //  1: 16-bit data frame format
+    if (DataFormat == SPI_DataFormat_16bit) {
+        pSPIx->CR1 |= (SPI_CR1_DFF);
+    } else {
+        pSPIx->CR1 &= ~(SPI_CR1_DFF);
+    }
+    pSPIDriver->Config.DataFormat = DataFormat;
+
+    if (pSPIDriver->SessionOpen) {
+        pSPIx->CR1 |= (SPI_CR1_SPE);
+    }
+
+    return OK;
+}
+
+/*
+ * Recomputes the baud rate divider of every SPIx with a MaxClock, invoked on
+ * every clock profile switch. Transfers in progress end before the divider
+ * changes
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+void SPI_UpdateClock(void) {
+    SPI_DriverTypeDef *pSPIDriver;
+    uint32_t enabled;
+
+    for (uint8_t i = 0; i < SPI_REGISTRY_SIZE; i++) {
+        pSPIDriver = spi_registry[i];
+        if (pSPIDriver == NULL) {
+            continue;
+        }
+
+        // BR can only be written while the SPIx is disabled
+        enabled = pSPIDriver->pSPIx->CR1 & SPI_CR1_SPE;
+        if (enabled) {
+            SPI_WaitIdle(pSPIDriver->pSPIx);
+            pSPIDriver->pSPIx->CR1 &= ~(SPI_CR1_SPE);
+        }
+
+        pSPIDriver->Config.BaudRate = SPI_get_BaudRate(pSPIDriver);
+        pSPIDriver->pSPIx->CR1 =
+            (pSPIDriver->pSPIx->CR1 & ~(SPI_CR1_BR)) |
+            (pSPIDriver->Config.BaudRate << SPI_CR1_BR_Pos);
+
+        pSPIDriver->pSPIx->CR1 |= enabled;
+    }
+}
+
+/*
+ * Opens a session: the SPIx stays enabled across the following blocking
+ * transfers, which return as soon as their last frame is written. The bus is
+ * only drained by SPI_Flush (before D/C or CS change) and SPI_CloseSession.
+ * With hardware NSS the chip selection stays LOW for the whole session
+ *
+ * Params:
+ *    * pSPIDriver, a pointer to SPI_DriverTypeDef that contains the SPIx
+ * Returns:
+ *    * None
+ */
+void SPI_OpenSession(SPI_DriverTypeDef *pSPIDriver) {
+    pSPIDriver->SessionOpen = 1;
+    pSPIDriver->pSPIx->CR1 |= (SPI_CR1_SPE);
+}
+
+/*
+ * Waits until every written frame is shifted out, the D/C and CS pins can be
+ * changed afterwards. Returns at once when the SPIx is idle
+ *
+ * Params:
+ *    * pSPIDriver, a pointer to SPI_DriverTypeDef that contains the SPIx
+ * Returns:
+ *    * None
+ */
+void SPI_Flush(SPI_DriverTypeDef *pSPIDriver) {
+    if (pSPIDriver->pSPIx->CR1 & SPI_CR1_SPE) {
+        SPI_WaitIdle(pSPIDriver->pSPIx);
+    }
+}
+
+/*
+ * Closes a session, flushing the bus and disabling the SPIx
+ *
+ * Params:
+ *    * pSPIDriver, a pointer to SPI_DriverTypeDef that contains the SPIx
+ * Returns:
+ *    * None
+ */
+void SPI_CloseSession(SPI_DriverTypeDef *pSPIDriver) {
+    SPI_Flush(pSPIDriver);
+    pSPIDriver->pSPIx->CR1 &= ~(SPI_CR1_SPE);
+    pSPIDriver->SessionOpen = 0;
+}
+
+/*
+ * Sending data via SPIx in blocking mode. In 16-bit data format Len is still
+ * counted in bytes, an odd trailing byte is sent in an 8-bit frame. Within a
+ * session it returns once the last frame is written, SPI_Flush drains it
  *
  * Params:
  *    * pSPIDriver, a pointer to SPI_DriverTypeDef that contains the SPIx that
@@ -132,46 +285,74 @@ DriverStatus SPI_Init(SPI_DriverTypeDef *pSPIDriver) {
  * Returns:
  *    * None
  */
-void SPI_SendData(SPI_DriverTypeDef *pSPIDriver, uint8_t *pTxBuffer,
+void SPI_SendData(SPI_DriverTypeDef *pSPIDriver, const uint8_t *pTxBuffer,
                   uint32_t Len) {
     /* Send Data over SPIx, blocking mode */
+    SPI_TypeDef *pSPIx = pSPIDriver->pSPIx;
+    uint8_t tail = 0;
 
-    // Enable SPI peripheral
-    pSPIDriver->pSPIx->CR1 |= (SPI_CR1_SPE);
+    // Enable SPI peripheral, already enabled within a session
+    pSPIx->CR1 |= (SPI_CR1_SPE);
 
-    // Block until Len = 0
+    if (pSPIDriver->Config.DataFormat == SPI_DataFormat_16bit) {
+        // Block until less than a frame is left
+        while (Len > 1) {
+            // Wait until TXe flags is HIGH
+            while (SPI_GetFlag(pSPIx, SPI_SR_TXE) != FLAG_HIGH) {
+                ;
+            }
 
+            // Save 2 bytes into Data Register
+            pSPIx->DR = SPI_get_HalfWord(pSPIDriver, pTxBuffer);
+            // Decrease Lenght by 2
+            Len -= 2;
+            pTxBuffer += 2;
+        }
+
+        if (Len) {
+            // Odd trailing byte, the frame format is switched to 8-bit once
+            // the last 16-bit frame is shifted out
+            SPI_WaitIdle(pSPIx);
+            pSPIx->CR1 &= ~(SPI_CR1_SPE);
+            pSPIx->CR1 &= ~(SPI_CR1_DFF);
+            pSPIx->CR1 |= (SPI_CR1_SPE);
+            tail = 1;
+        }
+    }
+
+    // Block until Len = 0
     while (Len) {
         // Wait until TXe flags is HIGH
-        while (SPI_GetFlag(pSPIDriver->pSPIx, SPI_SR_TXE) != FLAG_HIGH) {
+        while (SPI_GetFlag(pSPIx, SPI_SR_TXE) != FLAG_HIGH) {
             ;
         }
 
-        if (pSPIDriver->Config.DataFormat == SPI_DataFormat_16bit) {
-
-            // Save 2 bytes into Data Register
-            pSPIDriver->pSPIx->DR = *((uint16_t *)pTxBuffer);
-            // Decrease Lenght by 2
-            Len--;
-            Len--;
-            (uint16_t *)pTxBuffer++;
-
-        } else {
+        // Save 1 byte into Data Register
+        pSPIx->DR = *(pTxBuffer);
+        // Decrease Lenght by 1
+        Len--;
+        pTxBuffer++;
+    }
 
-            // Save 1 byte into Data Register
-            pSPIDriver->pSPIx->DR = *(pTxBuffer);
-            // Decrease Lenght by 1
-            Len--;
-            pTxBuffer++;
-        }
+    // Within a session the last frame is left shifting out, unless the
+    // format has to be restored
+    if (pSPIDriver->SessionOpen && !tail) {
+        return;
     }
 
-    // Wait until Busy Flag is LOW
-    while (SPI_GetFlag(pSPIDriver->pSPIx, SPI_SR_BSY) != FLAG_LOW)
-        ;
+    // Wait until the last frame is shifted out
+    SPI_WaitIdle(pSPIx);
 
     // Disable SPI
-    pSPIDriver->pSPIx->CR1 &= ~(SPI_CR1_SPE);
+    pSPIx->CR1 &= ~(SPI_CR1_SPE);
+
+    // Restore the 16-bit format after an odd trailing byte
+    if (tail) {
+        pSPIx->CR1 |= (SPI_CR1_DFF);
+        if (pSPIDriver->SessionOpen) {
+            pSPIx->CR1 |= (SPI_CR1_SPE);
+        }
+    }
 }
 
 /*
@@ -194,6 +375,12 @@ DriverStatus SPI_SendDataIT(SPI_DriverTypeDef *pSPIDriver, uint8_t *pTxBuffer,
         return BUSY;
     }
 
+    // The frame format can't be changed from the interruption, in 16-bit data
+    // format only whole frames are sent
+    if ((pSPIDriver->Config.DataFormat == SPI_DataFormat_16bit) && (Len & 1)) {
+        return ERROR;
+    }
+
     // Save Len and pointer variables inside the SPI Driver Struct
     pSPIDriver->TxState = SPI_TxState_Busy;
     pSPIDriver->TxLen = Len;
@@ -212,9 +399,360 @@ DriverStatus SPI_SendDataIT(SPI_DriverTypeDef *pSPIDriver, uint8_t *pTxBuffer,
     return OK;
 }
 
+/*
+ * Sending data via SPIx using a DMA stream (non blocking mode). The stream
+ * must be mapped to the Tx request of the SPIx and configured as memory to
+ * peripheral
+ *
+ * Params:
+ *    * pSPIDriver, a pointer to SPI_DriverTypeDef that contains the SPIx that
+ * will send data and its configuration
+ *    * pDMADriver, a pointer to DMA_DriverTypeDef with the DMA stream
+ *    * pTxBuffer, a pointer to a 8 bit-wide integer that holds the data to send
+ *    * Len, a 16 bit-wide integer with the Len of the data to send
+ * Returns:
+ *    * DriverStatus, BUSY if there is a transfer in progress, ERROR for a
+ * buffer in the CCM-RAM
+ */
+DriverStatus SPI_SendDataDMA(SPI_DriverTypeDef *pSPIDriver,
+                             DMA_DriverTypeDef *pDMADriver,
+                             const uint8_t *pTxBuffer, uint16_t Len) {
+    /* Send Data over SPIx, DMA mode */
+    DriverStatus status;
+
+    // Verify Tx is not busy already
+    if (pSPIDriver->TxState == SPI_TxState_Busy) {
+        return BUSY;
+    }
+
+    status = DMA_Start(pDMADriver, pTxBuffer, &pSPIDriver->pSPIx->DR, Len);
+    if (status != OK) {
+        return status;
+    }
+    pSPIDriver->pSegments = NULL;
+    pSPIDriver->TxState = SPI_TxState_Busy;
+
+    // TXDMAEN[0] Tx buffer DMA enable, a DMA request is generated whenever
+    // TXE is set
+    pSPIDriver->pSPIx->CR2 |= SPI_CR2_TXDMAEN;
+
+    // Enable SPI peripheral
+    pSPIDriver->pSPIx->CR1 |= (SPI_CR1_SPE);
+
+    return OK;
+}
+
+/*
+ * Checks the status of a DMA transmission, closing it when every byte has left
+ * the SPIx. Without the transfer complete interruption of the stream, the
+ * segments of a scatter-gather transfer are chained here
+ *
+ * Params:
+ *    * pSPIDriver, a pointer to SPI_DriverTypeDef that contains the SPIx
+ *    * pDMADriver, a pointer to DMA_DriverTypeDef with the DMA stream
+ * Returns:
+ *    * DriverStatus, BUSY while the transmission is in progress, OK when it
+ * ended, ERROR once when it was aborted by a transfer error of the stream
+ */
+DriverStatus SPI_GetStatusDMA(SPI_DriverTypeDef *pSPIDriver,
+                              DMA_DriverTypeDef *pDMADriver) {
+    if (pSPIDriver->TxState == SPI_TxState_Ready) {
+        return OK;
+    }
+
+    // Without the stream interruption the error is only seen here
+    if (DMA_GetTransferError(pDMADriver) == FLAG_HIGH) {
+        SPI_AbortDMA(pSPIDriver, pDMADriver);
+    }
+    if (pSPIDriver->TxState == SPI_TxState_Error) {
+        pSPIDriver->TxState = SPI_TxState_Ready;
+        return ERROR;
+    }
+
+    // The hardware disables the stream once its last byte is written in the
+    // data register
+    if (DMA_GetEnabled(pDMADriver) == FLAG_HIGH) {
+        return BUSY;
+    }
+
+    // Segments left, chained by the stream interruption when it is enabled
+    if ((pSPIDriver->pSegments != NULL) &&
+        (pSPIDriver->SegmentIndex + 1 < pSPIDriver->SegmentCount)) {
+        if (pDMADriver->Config.TCInterrupt != ENABLE) {
+            SPI_Segments_Next(pSPIDriver, pDMADriver);
+        }
+        return BUSY;
+    }
+
+    // The SPIx still needs to shift the last byte out (TXE HIGH and BSY LOW)
+    if ((SPI_GetFlag(pSPIDriver->pSPIx, SPI_SR_TXE) != FLAG_HIGH) ||
+        (SPI_GetFlag(pSPIDriver->pSPIx, SPI_SR_BSY) != FLAG_LOW)) {
+        return BUSY;
+    }
+
+    // A segment list holds the chip selection until its last byte
+    if (pSPIDriver->pSegments != NULL) {
+        GPIO_Port_Write(pSPIDriver->pControlGPIOx, pSPIDriver->CS_Mask, 0);
+        pSPIDriver->pSegments = NULL;
+    }
+
+    // Disable the DMA request and the SPI (kept enabled within a session)
+    pSPIDriver->pSPIx->CR2 &= ~(SPI_CR2_TXDMAEN);
+    if (!pSPIDriver->SessionOpen) {
+        pSPIDriver->pSPIx->CR1 &= ~(SPI_CR1_SPE);
+    }
+    pSPIDriver->TxState = SPI_TxState_Ready;
+
+    return OK;
+}
+
+/*
+ * Configures the D/C and CS pins driven by the transaction queue and the
+ * segment transfers. For the queue, the SPIx interruption must be enabled in
+ * the NVIC and routed to SPI_IRQ_Handling
+ *
+ * Params:
+ *    * pSPIDriver, a pointer to SPI_DriverTypeDef that contains the SPIx
+ *    * pGPIOx, pointer to GPIO_TypeDef with the D/C and CS pins
+ *    * DC_Mask, 16 bit-wide integer with the D/C pin mask
+ *    * CS_Mask, 16 bit-wide integer with the CS pin mask, 0 when CS is driven
+ * by hardware
+ * Returns:
+ *    * None
+ */
+void SPI_ControlPins_Init(SPI_DriverTypeDef *pSPIDriver, GPIO_TypeDef *pGPIOx,
+                          uint16_t DC_Mask, uint16_t CS_Mask) {
+    pSPIDriver->QueueHead = 0;
+    pSPIDriver->QueueTail = 0;
+    pSPIDriver->pSegments = NULL;
+    pSPIDriver->pControlGPIOx = pGPIOx;
+    pSPIDriver->DC_Mask = DC_Mask;
+    pSPIDriver->CS_Mask = CS_Mask;
+}
+
+/*
+ * Sends a list of segments by polling, in 8-bit frames. The segments are sent
+ * back to back within one chip selection, the bus is only drained when D/C
+ * changes between two segments
+ *
+ * Params:
+ *    * pSPIDriver, a pointer to SPI_DriverTypeDef that contains the SPIx, with
+ * 8-bit data format
+ *    * pSegments, a pointer to the SPI_SegmentTypeDef list
+ *    * Count, an 8 bit-wide integer with the amount of segments
+ * Returns:
+ *    * None
+ */
+void SPI_SendSegments(SPI_DriverTypeDef *pSPIDriver,
+                      const SPI_SegmentTypeDef *pSegments, uint8_t Count) {
+    SPI_TypeDef *pSPIx = pSPIDriver->pSPIx;
+    const uint8_t *pTxBuffer;
+    uint16_t len;
+
+    if (Count == 0) {
+        return;
+    }
+
+    // D/C of the first segment and CS LOW in one write, once the frames of
+    // the session are shifted out
+    SPI_Flush(pSPIDriver);
+    SPI_WriteDC(pSPIDriver, pSegments[0].DC, pSPIDriver->CS_Mask);
+    pSPIx->CR1 |= (SPI_CR1_SPE);
+
+    for (uint8_t i = 0; i < Count; i++) {
+        // D/C can only change once the previous segment is shifted out
+        if ((i > 0) && (pSegments[i].DC != pSegments[i - 1].DC)) {
+            SPI_WaitIdle(pSPIx);
+            SPI_WriteDC(pSPIDriver, pSegments[i].DC, 0);
+        }
+
+        pTxBuffer = pSegments[i].pTxBuffer;
+        len = pSegments[i].Len;
+        while (len) {
+            // Wait until TXe flags is HIGH
+            while (SPI_GetFlag(pSPIx, SPI_SR_TXE) != FLAG_HIGH) {
+                ;
+            }
+            pSPIx->DR = *(pTxBuffer);
+            len--;
+            pTxBuffer++;
+        }
+    }
+
+    // Wait until the last frame is shifted out
+    SPI_WaitIdle(pSPIx);
+
+    // Disable SPI (kept enabled within a session) and release the chip
+    // selection
+    if (!pSPIDriver->SessionOpen) {
+        pSPIx->CR1 &= ~(SPI_CR1_SPE);
+    }
+    GPIO_Port_Write(pSPIDriver->pControlGPIOx, pSPIDriver->CS_Mask, 0);
+}
+
+/*
+ * Sends a list of segments through the transaction queue (interruption mode),
+ * never blocks. The chip selection is held until the last segment
+ *
+ * Params:
+ *    * pSPIDriver, a pointer to SPI_DriverTypeDef that contains the SPIx
+ *    * pSegments, a pointer to the SPI_SegmentTypeDef list, the buffers must be
+ * kept unmodified until they are sent
+ *    * Count, an 8 bit-wide integer with the amount of segments
+ * Returns:
+ *    * DriverStatus, BUSY if the queue can't hold every segment, ERROR for an
+ * empty list or segment
+ */
+DriverStatus SPI_SendSegmentsIT(SPI_DriverTypeDef *pSPIDriver,
+                                const SPI_SegmentTypeDef *pSegments,
+                                uint8_t Count) {
+    SPI_DescriptorTypeDef descriptor = {0};
+
+    if (Count == 0) {
+        return ERROR;
+    }
+    for (uint8_t i = 0; i < Count; i++) {
+        if (pSegments[i].Len == 0) {
+            return ERROR;
+        }
+    }
+
+    // The list is pushed as a whole, a partial list would hold CS forever
+    if (SPI_Queue_GetFree(pSPIDriver) < Count) {
+        return BUSY;
+    }
+
+    for (uint8_t i = 0; i < Count; i++) {
+        descriptor.pTxBuffer = pSegments[i].pTxBuffer;
+        descriptor.Len = pSegments[i].Len;
+        descriptor.DC = pSegments[i].DC;
+        descriptor.CS = (i == Count - 1) ? SPI_CS_Release : SPI_CS_Keep;
+        SPI_Queue_Push(pSPIDriver, &descriptor);
+    }
+
+    return OK;
+}
+
+/*
+ * Streams a list of segments with a DMA stream, never blocks. Every segment is
+ * a transfer of the stream, the next one is started as soon as the stream ends
+ * (SPI_DMA_IRQHandling, or SPI_GetStatusDMA without the transfer complete
+ * interruption). SPI_GetStatusDMA must be invoked until it returns OK
+ *
+ * Params:
+ *    * pSPIDriver, a pointer to SPI_DriverTypeDef that contains the SPIx, with
+ * 8-bit data format
+ *    * pDMADriver, a pointer to DMA_DriverTypeDef with the DMA stream
+ *    * pSegments, a pointer to the SPI_SegmentTypeDef list, it must be kept
+ * unmodified until the transfer ends
+ *    * Count, an 8 bit-wide integer with the amount of segments
+ * Returns:
+ *    * DriverStatus, BUSY if there is a transfer in progress, ERROR for an
+ * empty list or a first segment in the CCM-RAM
+ */
+DriverStatus SPI_SendSegmentsDMA(SPI_DriverTypeDef *pSPIDriver,
+                                 DMA_DriverTypeDef *pDMADriver,
+                                 const SPI_SegmentTypeDef *pSegments,
+                                 uint8_t Count) {
+    if (Count == 0) {
+        return ERROR;
+    }
+    if ((pSPIDriver->TxState == SPI_TxState_Busy) ||
+        (DMA_GetEnabled(pDMADriver) == FLAG_HIGH)) {
+        return BUSY;
+    }
+
+    pSPIDriver->pSegments = pSegments;
+    pSPIDriver->SegmentCount = Count;
+    pSPIDriver->SegmentIndex = 0;
+    pSPIDriver->TxState = SPI_TxState_Busy;
+
+    // D/C of the first segment and CS LOW in one write
+    SPI_WriteDC(pSPIDriver, pSegments[0].DC, pSPIDriver->CS_Mask);
+
+    if (DMA_Start(pDMADriver, pSegments[0].pTxBuffer, &pSPIDriver->pSPIx->DR,
+                  pSegments[0].Len) != OK) {
+        GPIO_Port_Write(pSPIDriver->pControlGPIOx, pSPIDriver->CS_Mask, 0);
+        pSPIDriver->pSegments = NULL;
+        pSPIDriver->TxState = SPI_TxState_Ready;
+        return ERROR;
+    }
+
+    // TXDMAEN[0] Tx buffer DMA enable, a DMA request is generated whenever
+    // TXE is set
+    pSPIDriver->pSPIx->CR2 |= SPI_CR2_TXDMAEN;
+
+    // Enable SPI peripheral
+    pSPIDriver->pSPIx->CR1 |= (SPI_CR1_SPE);
+
+    return OK;
+}
+
+/*
+ * Pushes a descriptor into the transaction queue, never blocks. The
+ * interruption sends the queued descriptors back to back in 8-bit frames
+ *
+ * Params:
+ *    * pSPIDriver, a pointer to SPI_DriverTypeDef that contains the SPIx
+ *    * pDescriptor, a pointer to the SPI_DescriptorTypeDef to push (copied)
+ * Returns:
+ *    * DriverStatus, BUSY if the queue is full, ERROR for an empty descriptor
+ */
+DriverStatus SPI_Queue_Push(SPI_DriverTypeDef *pSPIDriver,
+                            const SPI_DescriptorTypeDef *pDescriptor) {
+    uint8_t head = pSPIDriver->QueueHead;
+
+    if (pDescriptor->Len == 0) {
+        return ERROR;
+    }
+    if ((uint8_t)(head - pSPIDriver->QueueTail) == SPI_QUEUE_SIZE) {
+        return BUSY;
+    }
+
+    pSPIDriver->Queue[head & (SPI_QUEUE_SIZE - 1)] = *pDescriptor;
+
+    // The descriptor must be written before it is published to the
+    // interruption
+    __DMB();
+    pSPIDriver->QueueHead = head + 1;
+
+    // TXE is HIGH while the SPIx is idle, unmasking it hands the queue to the
+    // interruption. If the queue is being sent already the interruption picks
+    // the descriptor up after the current one
+    pSPIDriver->pSPIx->CR1 |= (SPI_CR1_SPE);
+    pSPIDriver->pSPIx->CR2 |= SPI_CR2_TXEIE;
+
+    return OK;
+}
+
+/*
+ * Returns the amount of descriptors that can be pushed
+ *
+ * Params:
+ *    * pSPIDriver, a pointer to SPI_DriverTypeDef that contains the SPIx
+ * Returns:
+ *    * free, an 8 bit-wide integer with the free descriptors
+ */
+uint8_t SPI_Queue_GetFree(SPI_DriverTypeDef *pSPIDriver) {
+    return SPI_QUEUE_SIZE -
+           (uint8_t)(pSPIDriver->QueueHead - pSPIDriver->QueueTail);
+}
+
+/*
+ * Returns whether every queued descriptor has been sent
+ *
+ * Params:
+ *    * pSPIDriver, a pointer to SPI_DriverTypeDef that contains the SPIx
+ * Returns:
+ *    * empty, 1 when the queue is empty and the SPIx is idle
+ */
+uint8_t SPI_Queue_IsEmpty(SPI_DriverTypeDef *pSPIDriver) {
+    return pSPIDriver->QueueHead == pSPIDriver->QueueTail;
+}
+
 /*
  * Handles the SPI interruption, invokes a handler function that correspond to
- * the type of interruption
+ * the type of interruption. The TXE path runs from SRAM (__ramfunc)
  *
  * Params:
  *    * pSPIDriver, a pointer to the SPI_DriverTypeDef which contains the SPI
@@ -222,15 +760,24 @@ DriverStatus SPI_SendDataIT(SPI_DriverTypeDef *pSPIDriver, uint8_t *pTxBuffer,
  *    * None
  *
  */
-void SPI_IRQ_Handling(SPI_DriverTypeDef *pSPIDriver) {
+__ramfunc void SPI_IRQ_Handling(SPI_DriverTypeDef *pSPIDriver) {
     /* Handling any SPI interruption arised */
 
     // Check if the interruption is due to TXE by checking
     // if Tx Empty is enabled in CR2 and if TX Empty flag is set in SR
-    if ((pSPIDriver->pSPIx->CR2 >> SPI_CR2_TXEIE_Pos) &&
-        (pSPIDriver->pSPIx->SR >> SPI_SR_TXE_Pos)) {
-        // TX buffer ready to sent new data, invoke the callback
-        SPI_IRQHandleTXe(pSPIDriver);
+    if ((pSPIDriver->pSPIx->CR2 & SPI_CR2_TXEIE) &&
+        (pSPIDriver->pSPIx->SR & SPI_SR_TXE)) {
+        // TX buffer ready to sent new data, invoke the callback. Queued
+        // descriptors are served before single transfers
+        if (pSPIDriver->QueueHead != pSPIDriver->QueueTail) {
+            SPI_Queue_HandleTXe(pSPIDriver);
+        } else if (pSPIDriver->TxLen) {
+            SPI_IRQHandleTXe(pSPIDriver);
+        } else {
+            // Nothing left to send. A push preempted by the close of the
+            // queue restores TXEIE (read-modify-write of CR2)
+            pSPIDriver->pSPIx->CR2 &= ~(SPI_CR2_TXEIE);
+        }
     }
 }
 
@@ -279,6 +826,35 @@ void SPI_IRQ_PriorityConfig(IRQn_Type IRQNumber, uint32_t IRQPriority) {
     __NVIC_SetPriority(IRQNumber, IRQPriority);
 }
 
+/*
+ * Handles the transfer complete interruption of the DMA stream that serves the
+ * SPIx, chaining the next segment of a scatter-gather transfer. A transfer
+ * error aborts the transmission, reported by SPI_GetStatusDMA
+ *
+ * Params:
+ *    * pSPIDriver, a pointer to the SPI_DriverTypeDef which contains the SPIx
+ *    * pDMADriver, a pointer to DMA_DriverTypeDef with the DMA stream
+ * Returns:
+ *    * None
+ */
+void SPI_DMA_IRQHandling(SPI_DriverTypeDef *pSPIDriver,
+                         DMA_DriverTypeDef *pDMADriver) {
+    if (DMA_GetTransferError(pDMADriver) == FLAG_HIGH) {
+        SPI_AbortDMA(pSPIDriver, pDMADriver);
+        return;
+    }
+    if (DMA_GetTransferComplete(pDMADriver) != FLAG_HIGH) {
+        return;
+    }
+    DMA_ClearTransferComplete(pDMADriver);
+
+    // The last segment (or a single buffer transfer) is closed by
+    // SPI_GetStatusDMA once the SPIx is idle
+    if (pSPIDriver->pSegments != NULL) {
+        SPI_Segments_Next(pSPIDriver, pDMADriver);
+    }
+}
+
 /*
  * Enables/disables the clock of the SPIx
  *
@@ -326,6 +902,52 @@ static void SPI_PeripheralClockControl(SPI_TypeDef *pSPIx,
     }
 }
 
+/*
+ * Returns the smallest baud rate divider that keeps SCK within MaxClock at the
+ * current clock of the bus of the SPIx
+ *
+ * Params:
+ *    * pSPIDriver, a pointer to a SPI_DriverTypeDef with the SPIx and MaxClock
+ * Returns:
+ *    * SPI_Config_BaudRate, the divider (div256 if MaxClock can't be met)
+ */
+static SPI_Config_BaudRate SPI_get_BaudRate(SPI_DriverTypeDef *pSPIDriver) {
+    uint32_t pclk;
+    uint8_t br = SPI_BaudRate_div2;
+
+    // SPI2 and SPI3 are on APB1, the rest on APB2
+    if ((pSPIDriver->pSPIx == SPI2) || (pSPIDriver->pSPIx == SPI3)) {
+        pclk = Clock_GetPCLK1();
+    } else {
+        pclk = Clock_GetPCLK2();
+    }
+
+    // SCK = PCLK / 2^(BR + 1)
+    while ((br < SPI_BaudRate_div256) &&
+           ((pclk >> (br + 1)) > pSPIDriver->Config.MaxClock)) {
+        br++;
+    }
+
+    return (SPI_Config_BaudRate)br;
+}
+
+/*
+ * Adds a handle to the registry of SPI_UpdateClock, once
+ *
+ * Params:
+ *    * pSPIDriver, a pointer to a SPI_DriverTypeDef
+ * Returns:
+ *    * None
+ */
+static void SPI_Register(SPI_DriverTypeDef *pSPIDriver) {
+    for (uint8_t i = 0; i < SPI_REGISTRY_SIZE; i++) {
+        if ((spi_registry[i] == pSPIDriver) || (spi_registry[i] == NULL)) {
+            spi_registry[i] = pSPIDriver;
+            return;
+        }
+    }
+}
+
 /*
  * Returns the status of a desired flag of the SPIx
  *
@@ -335,7 +957,7 @@ static void SPI_PeripheralClockControl(SPI_TypeDef *pSPIx,
  * flag Returns:
  *    * FlagStatus, the status of the desired flag on the SPIx
  */
-static FlagStatus SPI_GetFlag(SPI_TypeDef *pSPIx, uint32_t flag) {
+static inline FlagStatus SPI_GetFlag(SPI_TypeDef *pSPIx, uint32_t flag) {
     // The SPI_SR contains the arised flags of the SPIx peripheral
     if (pSPIx->SR & flag) {
         return FLAG_HIGH;
@@ -352,17 +974,17 @@ static FlagStatus SPI_GetFlag(SPI_TypeDef *pSPIx, uint32_t flag) {
  * Returns:
  *    * None
  */
-static void SPI_IRQHandleTXe(SPI_DriverTypeDef *pSPIDriver) {
+static __ramfunc void SPI_IRQHandleTXe(SPI_DriverTypeDef *pSPIDriver) {
     /* Send data withouth blocking */
 
     if (pSPIDriver->Config.DataFormat == SPI_DataFormat_16bit) {
 
         // Save 2 bytes into Data Register
-        pSPIDriver->pSPIx->DR = *((uint16_t *)pSPIDriver->pTxBuffer);
+        pSPIDriver->pSPIx->DR =
+            SPI_get_HalfWord(pSPIDriver, pSPIDriver->pTxBuffer);
         // Decrease Lenght by 2
-        pSPIDriver->TxLen--;
-        pSPIDriver->TxLen--;
-        (uint16_t *)pSPIDriver->pTxBuffer++;
+        pSPIDriver->TxLen -= 2;
+        pSPIDriver->pTxBuffer += 2;
 
     } else {
 
@@ -380,7 +1002,177 @@ static void SPI_IRQHandleTXe(SPI_DriverTypeDef *pSPIDriver) {
 }
 
 /*
- * Ends the transmission on the SPIx driver when there is no more data to send
+ * Handles the TXE interruption while the transaction queue is being sent. Once
+ * a descriptor ends, the next one is started within the same interruption
+ *
+ * Params:
+ *    * pSPIDriver, a pointer to a SPI_DriverTypeDef which contains the SPIx
+ * Returns:
+ *    * None
+ */
+static __ramfunc void SPI_Queue_HandleTXe(SPI_DriverTypeDef *pSPIDriver) {
+    SPI_DescriptorTypeDef *pDescriptor;
+    uint8_t tail;
+
+    // First byte of the queue, select the display and load the descriptor
+    if (pSPIDriver->TxLen == 0) {
+        SPI_Queue_Next(pSPIDriver);
+    }
+
+    // Save 1 byte into Data Register
+    pSPIDriver->pSPIx->DR = *(pSPIDriver->pTxBuffer);
+    pSPIDriver->TxLen--;
+    pSPIDriver->pTxBuffer++;
+
+    if (pSPIDriver->TxLen) {
+        return;
+    }
+
+    // Last byte of the descriptor, D/C and CS can only change once it is
+    // shifted out (one frame). A following descriptor with the same D/C level
+    // continues the transaction without draining the SPIx
+    tail = pSPIDriver->QueueTail;
+    pDescriptor = &pSPIDriver->Queue[tail & (SPI_QUEUE_SIZE - 1)];
+    tail++;
+    if ((pDescriptor->CS == SPI_CS_Release) ||
+        (tail == pSPIDriver->QueueHead) ||
+        (pSPIDriver->Queue[tail & (SPI_QUEUE_SIZE - 1)].DC !=
+         pDescriptor->DC)) {
+        SPI_WaitIdle(pSPIDriver->pSPIx);
+    }
+    if (pDescriptor->CS == SPI_CS_Release) {
+        GPIO_Port_Write(pSPIDriver->pControlGPIOx, pSPIDriver->CS_Mask, 0);
+    }
+    if (pDescriptor->Callback != NULL) {
+        pDescriptor->Callback(pDescriptor->pContext);
+    }
+
+    // Release the descriptor to the producer
+    pSPIDriver->QueueTail++;
+
+    // Chain the next descriptor, the following TXE interruption sends its
+    // first byte. Otherwise the queue is closed
+    if (!SPI_Queue_Next(pSPIDriver)) {
+        SPI_CloseTransmission(pSPIDriver);
+    }
+}
+
+/*
+ * Loads the descriptor at the tail of the queue, driving its D/C level and
+ * selecting the display
+ *
+ * Params:
+ *    * pSPIDriver, a pointer to a SPI_DriverTypeDef which contains the SPIx
+ * Returns:
+ *    * loaded, 0 when the queue is empty
+ */
+static __ramfunc uint8_t SPI_Queue_Next(SPI_DriverTypeDef *pSPIDriver) {
+    uint8_t tail = pSPIDriver->QueueTail;
+    SPI_DescriptorTypeDef *pDescriptor;
+
+    if (tail == pSPIDriver->QueueHead) {
+        return 0;
+    }
+    pDescriptor = &pSPIDriver->Queue[tail & (SPI_QUEUE_SIZE - 1)];
+
+    // D/C level and CS LOW in one write
+    SPI_WriteDC(pSPIDriver, pDescriptor->DC, pSPIDriver->CS_Mask);
+
+    pSPIDriver->TxState = SPI_TxState_Busy;
+    pSPIDriver->pTxBuffer = (uint8_t *)pDescriptor->pTxBuffer;
+    pSPIDriver->TxLen = pDescriptor->Len;
+
+    return 1;
+}
+
+/*
+ * Drives the D/C pin, selecting the device in the same write
+ *
+ * Params:
+ *    * pSPIDriver, a pointer to a SPI_DriverTypeDef with the control pins
+ *    * DC, a PinLogicalLevel with the D/C level
+ *    * CS_Mask, 16 bit-wide integer with the CS pin mask to drive LOW, 0 to
+ * leave the chip selection untouched
+ * Returns:
+ *    * None
+ */
+static __ramfunc void SPI_WriteDC(SPI_DriverTypeDef *pSPIDriver,
+                                  PinLogicalLevel DC, uint16_t CS_Mask) {
+    if (DC == HIGH) {
+        GPIO_Port_Write(pSPIDriver->pControlGPIOx, pSPIDriver->DC_Mask,
+                        CS_Mask);
+    } else {
+        GPIO_Port_Write(pSPIDriver->pControlGPIOx, 0,
+                        pSPIDriver->DC_Mask | CS_Mask);
+    }
+}
+
+/*
+ * Starts the next segment of a scatter-gather DMA transfer. Segments with the
+ * same D/C level follow each other without draining the SPIx
+ *
+ * Params:
+ *    * pSPIDriver, a pointer to a SPI_DriverTypeDef with the segment list
+ *    * pDMADriver, a pointer to DMA_DriverTypeDef with the DMA stream
+ * Returns:
+ *    * started, 0 when every segment has been streamed
+ */
+static uint8_t SPI_Segments_Next(SPI_DriverTypeDef *pSPIDriver,
+                                 DMA_DriverTypeDef *pDMADriver) {
+    uint8_t index = pSPIDriver->SegmentIndex + 1;
+    const SPI_SegmentTypeDef *pSegment;
+
+    if (index >= pSPIDriver->SegmentCount) {
+        return 0;
+    }
+    pSegment = &pSPIDriver->pSegments[index];
+
+    // D/C can only change once the previous segment is shifted out
+    if (pSegment->DC != pSPIDriver->pSegments[index - 1].DC) {
+        SPI_WaitIdle(pSPIDriver->pSPIx);
+        SPI_WriteDC(pSPIDriver, pSegment->DC, 0);
+    }
+
+    pSPIDriver->SegmentIndex = index;
+    if (DMA_Start(pDMADriver, pSegment->pTxBuffer, &pSPIDriver->pSPIx->DR,
+                  pSegment->Len) != OK) {
+        SPI_AbortDMA(pSPIDriver, pDMADriver);
+        return 0;
+    }
+
+    return 1;
+}
+
+/*
+ * Aborts a DMA transmission after an error of the stream, the chip selection
+ * of a segment list is released. SPI_GetStatusDMA reports the error
+ *
+ * Params:
+ *    * pSPIDriver, a pointer to a SPI_DriverTypeDef with the transmission
+ *    * pDMADriver, a pointer to DMA_DriverTypeDef with the DMA stream
+ * Returns:
+ *    * None
+ */
+static void SPI_AbortDMA(SPI_DriverTypeDef *pSPIDriver,
+                         DMA_DriverTypeDef *pDMADriver) {
+    DMA_Stop(pDMADriver);
+    DMA_ClearTransferError(pDMADriver);
+
+    if (pSPIDriver->pSegments != NULL) {
+        GPIO_Port_Write(pSPIDriver->pControlGPIOx, pSPIDriver->CS_Mask, 0);
+        pSPIDriver->pSegments = NULL;
+    }
+
+    pSPIDriver->pSPIx->CR2 &= ~(SPI_CR2_TXDMAEN);
+    if (!pSPIDriver->SessionOpen) {
+        pSPIDriver->pSPIx->CR1 &= ~(SPI_CR1_SPE);
+    }
+    pSPIDriver->TxState = SPI_TxState_Error;
+}
+
+/*
+ * Ends the transmission on the SPIx driver when there is no more data to send.
+ * Runs from SRAM, invoked by the TXE path
  *
  * Params:
  *    * pSPIDriver, a pointer to a SPI_DriverTypeDef which contains the SPIx
@@ -388,7 +1180,7 @@ static void SPI_IRQHandleTXe(SPI_DriverTypeDef *pSPIDriver) {
  * Returns:
  *    * None
  */
-static void SPI_CloseTransmission(SPI_DriverTypeDef *pSPIDriver) {
+static __ramfunc void SPI_CloseTransmission(SPI_DriverTypeDef *pSPIDriver) {
     // Disabling the interruption
 
     pSPIDriver->pSPIx->CR2 &= ~(SPI_CR2_TXEIE);
@@ -400,8 +1192,10 @@ static void SPI_CloseTransmission(SPI_DriverTypeDef *pSPIDriver) {
     // Setting state as ready to be available again
     pSPIDriver->TxState = SPI_TxState_Ready;
 
-    // Disable SPI
-    pSPIDriver->pSPIx->CR1 &= ~(SPI_CR1_SPE);
+    // Disable SPI, kept enabled within a session
+    if (!pSPIDriver->SessionOpen) {
+        pSPIDriver->pSPIx->CR1 &= ~(SPI_CR1_SPE);
+    }
 }
 
 /*
@@ -418,3 +1212,45 @@ __weak void SPI_CallbackTxCompleted(SPI_DriverTypeDef *pSPIDriver) {
     // nullify the unused variable
     (void)pSPIDriver;
 }
+
+/*
+ * Halts the CPU until the SPIx has shifted out every frame (TXE HIGH and BSY
+ * LOW). Runs from SRAM, invoked by the TXE path
+ *
+ * Params:
+ *    * pSPIx, a pointer to the SPI_TypeDef which corresponds to the SPIx
+ * Returns:
+ *    * None
+ */
+static __ramfunc void SPI_WaitIdle(SPI_TypeDef *pSPIx) {
+    while (SPI_GetFlag(pSPIx, SPI_SR_TXE) != FLAG_HIGH) {
+        ;
+    }
+    while (SPI_GetFlag(pSPIx, SPI_SR_BSY) != FLAG_LOW) {
+        ;
+    }
+}
+
+/*
+ * Packs the next two bytes of the buffer in a 16-bit frame
+ *
+ * Params:
+ *    * pSPIDriver, a pointer to SPI_DriverTypeDef with the SPIx configuration
+ *    * pTxBuffer, a pointer to a 8 bit-wide integer with the next two bytes
+ * Returns:
+ *    * frame, a 16 bit-wide integer to write in the data register
+ */
+static inline uint16_t SPI_get_HalfWord(SPI_DriverTypeDef *pSPIDriver,
+                                        const uint8_t *pTxBuffer) {
+    // Buffers may not be aligned to 2 bytes, the value is read byte by byte
+    // (little endian, as the Cortex-M4 stores a half-word)
+    uint16_t frame = pTxBuffer[0] | (pTxBuffer[1] << 8);
+
+    // With MSB first the high byte is shifted out first, both bytes are swapped
+    // to keep the buffer order on the wire (REV16)
+    if ((pSPIDriver->Config.ByteOrder == SPI_ByteOrder_Stream) &&
+        (pSPIDriver->Config.FrameFormat == SPI_FrameFormat_MSBFirst)) {
+        frame = (uint16_t)((frame >> 8) | (frame << 8));
+    }
+    return frame;
+}
@@ -1,7 +1,10 @@
 #include "stm32f429zi.h"
 
 /*
- * Initialazes the Timer 6 and SysTick interruption
+ * Initialazes the SysTick interruption, the RTC (timebase of the software
+ * timers, kept in Stop mode), the power manager, the deferred work queue and
+ * the timer wheel. The MCU starts on the Run clock profile (HSI, 16 MHz), the
+ * timebases follow every profile switch
  *
  * Params:
  *    * None
@@ -9,6 +12,11 @@
  *    * None
  */
 void System_Init(void) {
+    // Wait states and ART accelerator of the reset clock
+    Flash_UpdateClock(Clock_GetHCLK());
     SysTick_Init();
-    Timer_Init();
+    RTC_Init();
+    Power_Init();
+    Defer_Init();
+    SWTimer_Init();
 }
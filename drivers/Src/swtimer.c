@@ -0,0 +1,405 @@
+#include "stm32f429zi.h"
+
+/* Global variables */
+
+// Slots of every level (lists of timers) and their occupancy, bit n is set
+// while slot n holds a timer. Only accessed by the CPU
+static __ccmbss SWTimer_TypeDef *swtimer_wheel[SWTIMER_LEVELS][SWTIMER_SLOTS];
+static __ccmbss uint64_t swtimer_occupancy[SWTIMER_LEVELS];
+
+// Next millisecond (RTC) to be served by the wheel, every timer that expires
+// before it has been expired
+static uint32_t swtimer_now;
+
+/* Static functions */
+static void SWTimer_Insert(SWTimer_TypeDef *pTimer);
+static void SWTimer_Unlink(SWTimer_TypeDef *pTimer);
+static void SWTimer_Cascade(uint8_t Level, uint8_t Slot);
+static void SWTimer_Expire(uint8_t Slot);
+static uint8_t SWTimer_get_Due(uint8_t Level, uint32_t *pDue);
+static uint8_t SWTimer_get_Next(uint32_t *pNext);
+static uint8_t SWTimer_get_Expiry(uint32_t *pExpiry);
+static void SWTimer_Program(void);
+
+/*
+ * Initializes the timer wheel, driven by the RTC wakeup timer: it is
+ * programmed to the nearest expiry and keeps counting in Stop mode, the
+ * higher levels are cascaded on the way. Must be invoked after RTC_Init
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+void SWTimer_Init(void) {
+    for (uint8_t level = 0; level < SWTIMER_LEVELS; level++) {
+        for (uint8_t slot = 0; slot < SWTIMER_SLOTS; slot++) {
+            swtimer_wheel[level][slot] = NULL;
+        }
+        swtimer_occupancy[level] = 0;
+    }
+    swtimer_now = RTC_GetMilliseconds();
+}
+
+/*
+ * Starts a timer, it expires once after some milliseconds (then every Period
+ * if it is periodic). A timer already active is restarted. O(1), can be
+ * invoked from the interruptions of ATOMIC_CRITICAL_PRIORITY or lower priority
+ *
+ * Params:
+ *    * pTimer, pointer to the SWTimer_TypeDef with the callback set
+ *    * Milliseconds, a 32 bit-wide integer with the time to the expiry
+ * Returns:
+ *    * None
+ */
+void SWTimer_Start(SWTimer_TypeDef *pTimer, uint32_t Milliseconds) {
+    uint32_t state;
+    uint32_t now;
+    uint32_t next;
+
+    state = Atomic_EnterCritical();
+    now = RTC_GetMilliseconds();
+    if (pTimer->ppPrev != NULL) {
+        SWTimer_Unlink(pTimer);
+    }
+    // An empty wheel is not processed (no wakeup), it restarts from now
+    // instead of catching up with the time elapsed since
+    if (!SWTimer_get_Next(&next)) {
+        swtimer_now = now;
+    }
+    pTimer->Expiry = now + Milliseconds;
+    SWTimer_Insert(pTimer);
+    SWTimer_Program();
+    Atomic_ExitCritical(state);
+}
+
+/*
+ * Stops a timer, its callback is not invoked. O(1), can be invoked from the
+ * interruptions of ATOMIC_CRITICAL_PRIORITY or lower priority
+ *
+ * Params:
+ *    * pTimer, pointer to the SWTimer_TypeDef
+ * Returns:
+ *    * None
+ */
+void SWTimer_Stop(SWTimer_TypeDef *pTimer) {
+    uint32_t state;
+
+    state = Atomic_EnterCritical();
+    if (pTimer->ppPrev != NULL) {
+        SWTimer_Unlink(pTimer);
+        SWTimer_Program();
+    }
+    Atomic_ExitCritical(state);
+}
+
+/*
+ * Returns whether a timer is waiting to expire
+ *
+ * Params:
+ *    * pTimer, pointer to the SWTimer_TypeDef
+ * Returns:
+ *    * active, 1 while the timer is started
+ */
+uint8_t SWTimer_IsActive(SWTimer_TypeDef *pTimer) {
+    return pTimer->ppPrev != NULL;
+}
+
+/*
+ * Advances the wheel up to the current time, cascading the due slots of the
+ * higher levels and expiring the due timers, and programs the RTC wakeup timer
+ * to the next expiry. The empty slots are skipped, a long sleep costs a few
+ * steps per level
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+void SWTimer_Process(void) {
+    uint32_t now = RTC_GetMilliseconds();
+    uint32_t state;
+    uint32_t next;
+
+    state = Atomic_EnterCritical();
+    while ((int32_t)(now - swtimer_now) >= 0) {
+        // Nothing is due up to now, the wheel jumps ahead
+        if (!SWTimer_get_Next(&next) || ((int32_t)(next - now) > 0)) {
+            swtimer_now = now + 1;
+            break;
+        }
+        swtimer_now = next;
+
+        // A slot of level L is due whenever the lower indexes wrap to 0, the
+        // higher levels are cascaded first
+        for (uint8_t level = SWTIMER_LEVELS - 1; level > 0; level--) {
+            if ((next & ((1UL << (level * SWTIMER_SLOT_BITS)) - 1)) == 0) {
+                SWTimer_Cascade(level, (next >> (level * SWTIMER_SLOT_BITS)) &
+                                           (SWTIMER_SLOTS - 1));
+            }
+        }
+
+        // Callbacks run outside of the critical section
+        Atomic_ExitCritical(state);
+        SWTimer_Expire(next & (SWTIMER_SLOTS - 1));
+        Atomic_EnterCritical();
+
+        swtimer_now = next + 1;
+    }
+    SWTimer_Program();
+    Atomic_ExitCritical(state);
+}
+
+/*
+ * Defers the wheel processing whenever the RTC wakeup timer elapses. Invoked
+ * by the RTC API
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+void RTC_CallbackWakeup(void) {
+    // With the deferred queue full the wakeup is tried again shortly
+    if (Defer_Post(SWTimer_Process) != OK) {
+        RTC_SetWakeupMs(1);
+    }
+}
+
+/*
+ * Places a timer in the slot of its expiry. Timers due within 64^(L + 1) ms
+ * are placed in level L, indexed by their expiry bits of that level
+ *
+ * Params:
+ *    * pTimer, pointer to the inactive SWTimer_TypeDef
+ * Returns:
+ *    * None
+ */
+static void SWTimer_Insert(SWTimer_TypeDef *pTimer) {
+    int32_t delta = (int32_t)(pTimer->Expiry - swtimer_now);
+    uint32_t key = pTimer->Expiry;
+    uint8_t level = 0;
+
+    if (delta < 0) {
+        // Already expired, served on the next processing
+        key = swtimer_now;
+    } else {
+        while ((level < SWTIMER_LEVELS) &&
+               ((uint32_t)delta >> ((level + 1) * SWTIMER_SLOT_BITS))) {
+            level++;
+        }
+        if (level == SWTIMER_LEVELS) {
+            // Beyond the wheel, the last slot in reach is used and the timer
+            // is placed again once cascaded
+            level = SWTIMER_LEVELS - 1;
+            key = swtimer_now +
+                  (1UL << (SWTIMER_LEVELS * SWTIMER_SLOT_BITS)) - 1;
+        }
+    }
+
+    pTimer->Level = level;
+    pTimer->Slot = (key >> (level * SWTIMER_SLOT_BITS)) & (SWTIMER_SLOTS - 1);
+
+    // Pushed at the head of the slot list
+    SWTimer_TypeDef **ppHead = &swtimer_wheel[level][pTimer->Slot];
+    pTimer->pNext = *ppHead;
+    if (pTimer->pNext != NULL) {
+        pTimer->pNext->ppPrev = &pTimer->pNext;
+    }
+    pTimer->ppPrev = ppHead;
+    *ppHead = pTimer;
+    swtimer_occupancy[level] |= (1ULL << pTimer->Slot);
+}
+
+/*
+ * Removes a timer from its slot
+ *
+ * Params:
+ *    * pTimer, pointer to the active SWTimer_TypeDef
+ * Returns:
+ *    * None
+ */
+static void SWTimer_Unlink(SWTimer_TypeDef *pTimer) {
+    *pTimer->ppPrev = pTimer->pNext;
+    if (pTimer->pNext != NULL) {
+        pTimer->pNext->ppPrev = pTimer->ppPrev;
+    }
+    pTimer->ppPrev = NULL;
+    pTimer->pNext = NULL;
+
+    if (swtimer_wheel[pTimer->Level][pTimer->Slot] == NULL) {
+        swtimer_occupancy[pTimer->Level] &= ~(1ULL << pTimer->Slot);
+    }
+}
+
+/*
+ * Places again every timer of a slot, they move to the lower levels
+ *
+ * Params:
+ *    * Level, an 8 bit-wide integer with the level (1..SWTIMER_LEVELS - 1)
+ *    * Slot, an 8 bit-wide integer with the due slot
+ * Returns:
+ *    * None
+ */
+static void SWTimer_Cascade(uint8_t Level, uint8_t Slot) {
+    SWTimer_TypeDef *pTimer;
+
+    while ((pTimer = swtimer_wheel[Level][Slot]) != NULL) {
+        SWTimer_Unlink(pTimer);
+        SWTimer_Insert(pTimer);
+    }
+}
+
+/*
+ * Expires every timer of a level 0 slot, periodic timers are started again.
+ * Invoked outside of the critical section, timers are taken one at a time so
+ * the callbacks can start or stop any timer
+ *
+ * Params:
+ *    * Slot, an 8 bit-wide integer with the due slot
+ * Returns:
+ *    * None
+ */
+static void SWTimer_Expire(uint8_t Slot) {
+    SWTimer_TypeDef *pTimer;
+    uint32_t state;
+
+    state = Atomic_EnterCritical();
+    while ((pTimer = swtimer_wheel[0][Slot]) != NULL) {
+        SWTimer_Unlink(pTimer);
+        if (pTimer->Period) {
+            pTimer->Expiry += pTimer->Period;
+            SWTimer_Insert(pTimer);
+        }
+        Atomic_ExitCritical(state);
+
+        pTimer->Callback(pTimer);
+
+        Atomic_EnterCritical();
+    }
+    Atomic_ExitCritical(state);
+}
+
+/*
+ * Returns the next millisecond at which an occupied slot of a level is due, a
+ * slot of level L is due on the multiples of 64^L whose level L index is the
+ * slot
+ *
+ * Params:
+ *    * Level, an 8 bit-wide integer with the level
+ *    * pDue, a pointer to a 32 bit-wide integer to store the due millisecond
+ * Returns:
+ *    * found, 0 if the level is empty
+ */
+static uint8_t SWTimer_get_Due(uint8_t Level, uint32_t *pDue) {
+    uint8_t shift = Level * SWTIMER_SLOT_BITS;
+    uint64_t occupancy = swtimer_occupancy[Level];
+    uint32_t first;
+    uint8_t index;
+
+    if (!occupancy) {
+        return 0;
+    }
+
+    // First multiple of 64^L not served yet, the occupancy is rotated to
+    // start at its index
+    first = (swtimer_now + (1UL << shift) - 1) >> shift;
+    index = first & (SWTIMER_SLOTS - 1);
+    if (index) {
+        occupancy =
+            (occupancy >> index) | (occupancy << (SWTIMER_SLOTS - index));
+    }
+    *pDue = (first + __builtin_ctzll(occupancy)) << shift;
+
+    return 1;
+}
+
+/*
+ * Returns the next millisecond at which a slot is due, the wheel is processed
+ * up to it
+ *
+ * Params:
+ *    * pNext, a pointer to a 32 bit-wide integer to store the due millisecond
+ * Returns:
+ *    * found, 0 if the wheel is empty
+ */
+static uint8_t SWTimer_get_Next(uint32_t *pNext) {
+    uint8_t found = 0;
+    uint32_t nearest = 0;
+    uint32_t due;
+
+    for (uint8_t level = 0; level < SWTIMER_LEVELS; level++) {
+        if (!SWTimer_get_Due(level, &due)) {
+            continue;
+        }
+        if (!found || ((due - swtimer_now) < (nearest - swtimer_now))) {
+            nearest = due;
+            found = 1;
+        }
+    }
+
+    *pNext = nearest;
+    return found;
+}
+
+/*
+ * Returns the earliest expiry of the timers. The slots of a level span
+ * consecutive ranges of expiries, only the timers of the first due slot of
+ * every level are compared
+ *
+ * Params:
+ *    * pExpiry, a pointer to a 32 bit-wide integer to store the expiry
+ * Returns:
+ *    * found, 0 if the wheel is empty
+ */
+static uint8_t SWTimer_get_Expiry(uint32_t *pExpiry) {
+    uint8_t found = 0;
+    uint32_t nearest = 0;
+    uint32_t due;
+
+    for (uint8_t level = 0; level < SWTIMER_LEVELS; level++) {
+        SWTimer_TypeDef *pTimer;
+
+        if (!SWTimer_get_Due(level, &due)) {
+            continue;
+        }
+
+        pTimer = swtimer_wheel[level][(due >> (level * SWTIMER_SLOT_BITS)) &
+                                      (SWTIMER_SLOTS - 1)];
+        for (; pTimer != NULL; pTimer = pTimer->pNext) {
+            if (!found || ((int32_t)(pTimer->Expiry - nearest) < 0)) {
+                nearest = pTimer->Expiry;
+                found = 1;
+            }
+        }
+    }
+
+    *pExpiry = nearest;
+    return found;
+}
+
+/*
+ * Programs the RTC wakeup timer to the earliest expiry, the slots of the
+ * higher levels due before it are cascaded by that processing. It is stopped
+ * while the wheel is empty. Invoked within a critical section
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+static void SWTimer_Program(void) {
+    uint32_t expiry;
+    int32_t delta;
+
+    if (!SWTimer_get_Expiry(&expiry)) {
+        RTC_StopWakeup();
+        return;
+    }
+
+    delta = (int32_t)(expiry - RTC_GetMilliseconds());
+    if (delta <= 0) {
+        delta = 1;
+    }
+    RTC_SetWakeupMs(delta);
+}
@@ -1,15 +1,21 @@
 #include "stm32f429zi.h"
 
+/* Static functions */
+static void SysTick_ServicePending(void);
+static uint8_t SysTick_CanPreempt(void);
+
 /* Global variables */
 
-// Updated in the SysTick handler which occurs every 1 ms. Used for delay
-// function
-volatile uint32_t global_ticks;
-// Update in the TIM6 interruption which occurs every 1 s. Used in the Scheduler
-volatile uint32_t global_seconds;
+
+// Milliseconds since the SysTick was initialized, updated in the SysTick
+// handler which occurs every 1 ms. Never reset, 64 bit-wide so it never wraps.
+// Read within a critical section, the update takes two accesses
+static volatile uint64_t systick_ms;
 
 /*
- * SysTick initializaiton function
+ * SysTick initializaiton function. The SysTick runs from here on as the
+ * monotonic millisecond timebase, it is halted in Stop and Standby modes (the
+ * RTC keeps the time across them)
  *
  * Params:
  *    * None
@@ -18,154 +24,193 @@ volatile uint32_t global_seconds;
  */
 void SysTick_Init(void) {
 
-    // Configuring for ticking every 1ms with the default clock frequency
-    // (16Mhz), Loading the tick count
-    // (16Mhz / 1kHz) in the load register of the SysTick Timer and enabling the
-    // IRQ.
-
-    SysTick->LOAD = 16000000 / 1000;
-    SysTick->VAL = 0x00;
+    // Configuring for ticking every 1ms with the current clock frequency,
+    // Loading the tick count (HCLK / 1kHz) in the load register of the SysTick
+    // Timer and enabling the IRQ.
+    SysTick_UpdateClock();
 
-    // Interruption settings. The SysTick is enabled in the delay function only
-    // when it is used
-    NVIC_SetPriority(SysTick_IRQn, 15);
+    // Interruption settings. It preempts the deferred work (PendSV, lowest
+    // priority) so the waiting functions sleep in it
+    NVIC_SetPriority(SysTick_IRQn, DEFER_PRIORITY - 1);
     SysTick->CTRL |= SysTick_CTRL_CLKSOURCE_Msk; // Processor as Systick Source
     SysTick->CTRL |=
         SysTick_CTRL_TICKINT_Msk; // Interruption triggered when reaching 0
+    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk; // Free running
 }
 
 /*
- * Handles the SysTick interruption, updates the global ticks count
+ * Reloads the SysTick with the ticks of 1 ms at the current HCLK, invoked on
+ * every clock profile switch
  *
  * Params:
  *    * None
  * Returns:
  *    * None
  */
-void SysTick_Handler(void) { global_ticks++; }
+void SysTick_UpdateClock(void) {
+    // The counter reloads after LOAD + 1 ticks
+    SysTick->LOAD = (Clock_GetHCLK() / 1000) - 1;
+    SysTick->VAL = 0x00;
+}
 
 /*
- * Halts the CPU during desired milliseconds
+ * Handles the SysTick interruption, updates the milliseconds count
  *
  * Params:
- *    * ms, an 32 bit-wide integer that represents the amount of delays to
- * elapse Returns:
+ *    * None
+ * Returns:
  *    * None
  */
-void delay(uint32_t ms) {
+void SysTick_Handler(void) { systick_ms++; }
 
-    // resets the amount of global ticks
-    global_ticks = 0;
-
-    // Enable the SysTick accessing the CTRL register
-    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+/*
+ * Returns the milliseconds since the SysTick was initialized. Monotonic, it is
+ * never reset
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * ms, a 64 bit-wide integer with the elapsed milliseconds
+ */
+uint64_t SysTick_GetMs(void) {
+    uint32_t state;
+    uint64_t ms;
 
-    // halt the CPU until the global ticks meet the desired ticks to elapse
-    uint32_t count = global_ticks + ms;
-    while (global_ticks < count) {
-        ;
-    }
+    // The count takes two accesses, the SysTick must not update it in between
+    state = Atomic_EnterCritical();
+    ms = systick_ms;
+    Atomic_ExitCritical(state);
 
-    // Disable the SysTick interruption
-    SysTick->CTRL &= ~(SysTick_CTRL_ENABLE_Msk);
+    return ms;
 }
 
 /*
- * Initialazes the Timer 6 as the scheduler clock source. This is configured to
- * trigger every second.
+ * Returns the low 32 bits of the milliseconds count. It takes a single access,
+ * can be invoked from any interruption (even one that preempts the SysTick
+ * handler). Wraps every ~49 days, times are compared by their difference
  *
  * Params:
  *    * None
  * Returns:
- *    * None
+ *    * ms, a 32 bit-wide integer with the elapsed milliseconds
  */
-void Timer_Init(void) {
-    // Enabling Timer clock
-    RCC->APB1ENR = (RCC_APB1ENR_TIM6EN);
-
-    // TIM6 is connected to APB1 bus. By default, the pre-escalers between the
-    // main clock and the APB1 timer clock are set as one, this means that the
-    // APB1 runs at 16 MHz. 1 s interruption can be achieved by the following:
-    //    * Timer 6 PSC (prescaler) = 250
-    //    * Timer 6 frequency = 16 Mhz / 250 = 64kHz (64k ticks per second)
-    //    * Timer ARR (Auto Reload Register) = 64k (to reach 1 second period)
-    TIM6->PSC = 250 - 1;
-    TIM6->ARR = 64000 - 1;
-
-    Timer_Start();
+uint32_t SysTick_GetMs32(void) {
+    // Little endian, the low word is the first one
+    return *(volatile uint32_t *)&systick_ms;
 }
 
 /*
- *  Sets the interruption configuration of the timer 6 and enables the
- * interruption
+ * Returns the deadline reached once some milliseconds elapse from now
+ *
+ * Params:
+ *    * ms, a 32 bit-wide integer with the milliseconds to elapse
+ * Returns:
+ *    * Deadline, a 64 bit-wide integer to be checked with SysTick_Expired or
+ * waited with sleep_until
+ */
+uint64_t SysTick_Deadline(uint32_t ms) { return SysTick_GetMs() + ms; }
+
+/*
+ * Returns whether a deadline has been reached
  *
- *  Params:
- *      * None
- *  Returns:
- *      * None
+ * Params:
+ *    * Deadline, a 64 bit-wide integer with the deadline (SysTick_Deadline)
+ * Returns:
+ *    * FlagStatus, FLAG_HIGH once the deadline is reached
  */
-void Timer_Start(void) {
-    // Enable and configure interruption
-    TIM6->DIER = (TIM_DIER_UIE);
+FlagStatus SysTick_Expired(uint64_t Deadline) {
+    SysTick_ServicePending();
 
-    NVIC_SetPriority(TIM6_DAC_IRQn, 15);
-    NVIC_EnableIRQ(TIM6_DAC_IRQn);
+    if (SysTick_GetMs() >= Deadline) {
+        return FLAG_HIGH;
+    }
+    return FLAG_LOW;
 }
 
 /*
- * Enables the timer interruption when the ARR count reaches 0
+ * Returns whether some milliseconds have elapsed since a start time, used to
+ * bound the waits on a peripheral
  *
  * Params:
- *    * None
+ *    * Start, a 64 bit-wide integer with the start time (SysTick_GetMs)
+ *    * ms, a 32 bit-wide integer with the timeout in milliseconds
  * Returns:
- *    * None
+ *    * FlagStatus, FLAG_HIGH once the timeout has elapsed
  */
-void Timer_Enable(void) {
-    // enabling the counter
-    TIM6->CR1 = (TIM_CR1_CEN);
+FlagStatus SysTick_Timeout(uint64_t Start, uint32_t ms) {
+    return SysTick_Expired(Start + ms);
 }
 
 /*
- * Disables the timer interruption
+ * Sleeps the CPU until a deadline is reached. The SysTick wakes the CPU every
+ * millisecond, other interruptions are served meanwhile. Can be invoked from
+ * any interruption: when the SysTick cannot preempt it, the count is advanced
+ * from here and the CPU spins instead of sleeping
  *
  * Params:
- *    * None
+ *    * Deadline, a 64 bit-wide integer with the deadline (SysTick_Deadline)
  * Returns:
  *    * None
  */
-void Timer_Disable(void) {
-    // Enabling the counter
-    TIM6->CR1 &= ~(TIM_CR1_CEN);
+void sleep_until(uint64_t Deadline) {
+    uint8_t sleep = SysTick_CanPreempt();
+
+    while (SysTick_Expired(Deadline) != FLAG_HIGH) {
+        if (sleep) {
+            __WFI();
+        }
+    }
 }
 
 /*
- * Handles the Timer 6 interruption. Entry of the NVIC vector table
+ * Halts the CPU during desired milliseconds
+ *
+ * Params:
+ *    * ms, an 32 bit-wide integer that represents the amount of milliseconds
+ * to elapse
+ * Returns:
+ *    * None
+ */
+void delay(uint32_t ms) { sleep_until(SysTick_Deadline(ms)); }
+
+/*
+ * Counts a SysTick interruption that is pending but cannot be served, the
+ * caller runs at its priority or above it
  *
  * Params:
  *    * None
  * Returns:
  *    * None
  */
-void TIM6_DAC_IRQHandler(void) {
-
-    // Check if the interruption is enabled
-    if (TIM6->DIER & TIM_DIER_UIE) {
-        // Check the Update Interrupt Flag
-        if (TIM6->SR & TIM_SR_UIF) {
-            // Clear the flag
-            TIM6->SR &= ~(TIM_SR_UIF);
-        }
+static void SysTick_ServicePending(void) {
+    uint32_t state;
+
+    // With the SysTick masked it cannot be served between the check and the
+    // clear, it is counted once
+    state = Atomic_EnterCritical();
+    if (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) {
+        SCB->ICSR = SCB_ICSR_PENDSTCLR_Msk;
+        systick_ms++;
     }
-    global_seconds++;
-    Scheduler();
+    Atomic_ExitCritical(state);
 }
 
 /*
- * Weak implementation of the scheduler, overriden in user layer
+ * Returns whether the SysTick interruption can preempt the current context,
+ * otherwise WFI would never wake up on it
  *
  * Params:
  *    * None
  * Returns:
- *    * None
+ *    * preempt, 1 in thread mode or in an exception of lower priority
  */
-__weak void Scheduler(void) { ; }
+static uint8_t SysTick_CanPreempt(void) {
+    uint32_t active = __get_IPSR();
+
+    if (active == 0) {
+        return 1;
+    }
+    // IPSR holds the exception number, IRQ numbers start at -16
+    return NVIC_GetPriority((IRQn_Type)((int32_t)active - 16)) >
+           NVIC_GetPriority(SysTick_IRQn);
+}
@@ -0,0 +1,278 @@
+#ifndef __STM32F429XX_H__
+#define __STM32F429XX_H__
+
+#include <stdint.h>
+
+/*
+ * Host stand-in of the CMSIS device header, used by the unit tests (make test) only. The core intrinsics are plain C
+ * (the memory barriers are full host barriers). The peripherals keep their addresses, test/Src/device.c maps host
+ * memory there before main and the tests drive the registers. Only the registers and bits used by the tested modules
+ * are declared
+ */
+
+/* Core intrinsics */
+
+#define __IO volatile
+#define __I volatile const
+#define __NVIC_PRIO_BITS 4
+
+#define __DSB() __sync_synchronize()
+#define __DMB() __sync_synchronize()
+#define __ISB() __sync_synchronize()
+#define __WFI() ((void)0)
+#define __WFE() ((void)0)
+#define __SEV() ((void)0)
+#define __enable_irq() ((void)0)
+#define __disable_irq() ((void)0)
+
+static inline uint32_t __get_BASEPRI(void) { return 0; }
+static inline void __set_BASEPRI(uint32_t Value) { (void)Value; }
+static inline void __set_BASEPRI_MAX(uint32_t Value) { (void)Value; }
+static inline uint32_t __get_IPSR(void) { return 0; }
+
+// No interruption runs between the load and the store of the host threads that share a variable, they are atomic
+static inline uint32_t __LDREXW(volatile uint32_t *pAddress) { return *pAddress; }
+static inline uint32_t __STREXW(uint32_t Value, volatile uint32_t *pAddress) {
+    *pAddress = Value;
+    return 0;
+}
+static inline void __CLREX(void) {}
+static inline uint8_t __CLZ(uint32_t Value) {
+    return Value ? __builtin_clz(Value) : 32;
+}
+
+/* Interruptions */
+
+typedef enum {
+ PendSV_IRQn = -2,
+ SysTick_IRQn = -1,
+ RTC_WKUP_IRQn = 3,
+ EXTI0_IRQn = 6,
+ DMA1_Stream4_IRQn = 15,
+ EXTI9_5_IRQn = 23,
+ SPI1_IRQn = 35,
+ SPI2_IRQn = 36,
+ EXTI15_10_IRQn = 40,
+ TIM6_DAC_IRQn = 54,
+ DMA2_Stream3_IRQn = 59,
+} IRQn_Type;
+
+void __NVIC_EnableIRQ(IRQn_Type IRQn);
+void __NVIC_DisableIRQ(IRQn_Type IRQn);
+void __NVIC_SetPriority(IRQn_Type IRQn, uint32_t Priority);
+void __NVIC_SetPendingIRQ(IRQn_Type IRQn);
+#define NVIC_EnableIRQ __NVIC_EnableIRQ
+#define NVIC_DisableIRQ __NVIC_DisableIRQ
+#define NVIC_SetPriority __NVIC_SetPriority
+
+/* System control block */
+
+typedef struct {
+  __IO uint32_t CPUID, ICSR, VTOR, AIRCR, SCR, CCR;
+} SCB_Type;
+
+// Host memory of test/Src/device.c, the core registers are not mapped
+extern SCB_Type Test_SCB;
+#define SCB (&Test_SCB)
+
+#define SCB_SCR_SLEEPONEXIT_Msk (1UL << 1)
+#define SCB_SCR_SLEEPDEEP_Msk (1UL << 2)
+
+/* Peripheral registers */
+
+typedef struct {
+  __IO uint32_t MODER, OTYPER, OSPEEDR, PUPDR, IDR, ODR, BSRR, LCKR, AFR[2];
+} GPIO_TypeDef;
+
+typedef struct {
+  __IO uint32_t CR1, CR2, SR, DR, CRCPR, RXCRCR, TXCRCR, I2SCFGR, I2SPR;
+} SPI_TypeDef;
+
+typedef struct {
+  __IO uint32_t CR, NDTR, PAR, M0AR, M1AR, FCR;
+} DMA_Stream_TypeDef;
+
+typedef struct {
+  __IO uint32_t LISR, HISR, LIFCR, HIFCR;
+} DMA_TypeDef;
+
+typedef struct {
+  __IO uint32_t CR1, CR2, SMCR, DIER, SR, EGR, CCMR1, CCMR2, CCER, CNT, PSC, ARR;
+} TIM_TypeDef;
+
+typedef struct {
+  __IO uint32_t CR, PLLCFGR, CFGR, CIR, AHB1RSTR, AHB2RSTR, AHB3RSTR, RESERVED0, APB1RSTR, APB2RSTR, RESERVED1[2];
+  __IO uint32_t AHB1ENR, AHB2ENR, AHB3ENR, RESERVED2, APB1ENR, APB2ENR, RESERVED3[2];
+  __IO uint32_t AHB1LPENR, AHB2LPENR, AHB3LPENR, RESERVED4, APB1LPENR, APB2LPENR, RESERVED5[2];
+  __IO uint32_t BDCR, CSR;
+} RCC_TypeDef;
+
+typedef struct {
+  __IO uint32_t CR, CSR;
+} PWR_TypeDef;
+
+typedef struct {
+  __IO uint32_t IMR, EMR, RTSR, FTSR, SWIER, PR;
+} EXTI_TypeDef;
+
+typedef struct {
+  __IO uint32_t MEMRMP, PMC, EXTICR[4];
+  uint32_t RESERVED[2];
+  __IO uint32_t CMPCR;
+} SYSCFG_TypeDef;
+
+typedef struct {
+  __IO uint32_t TR, DR, CR, ISR, PRER, WUTR, CALIBR, ALRMAR, ALRMBR, WPR, SSR;
+  __IO uint32_t SHIFTR, TSTR, TSDR, TSSSR, CALR, TAFCR;
+} RTC_TypeDef;
+
+/* Peripheral instances */
+
+// Host memory mapped by test/Src/device.c
+#define PERIPH_BASE 0x40000000UL
+#define PERIPH_SIZE 0x00080000UL
+
+#define RTC_BASE (PERIPH_BASE + 0x2800UL)
+#define SPI2_BASE (PERIPH_BASE + 0x3800UL)
+#define SPI3_BASE (PERIPH_BASE + 0x3C00UL)
+#define PWR_BASE (PERIPH_BASE + 0x7000UL)
+#define SPI1_BASE (PERIPH_BASE + 0x13000UL)
+#define SPI4_BASE (PERIPH_BASE + 0x13400UL)
+#define SYSCFG_BASE (PERIPH_BASE + 0x13800UL)
+#define EXTI_BASE (PERIPH_BASE + 0x13C00UL)
+#define SPI5_BASE (PERIPH_BASE + 0x15000UL)
+#define SPI6_BASE (PERIPH_BASE + 0x15400UL)
+#define GPIOA_BASE (PERIPH_BASE + 0x20000UL)
+#define GPIOB_BASE (PERIPH_BASE + 0x20400UL)
+#define GPIOC_BASE (PERIPH_BASE + 0x20800UL)
+#define GPIOD_BASE (PERIPH_BASE + 0x20C00UL)
+#define GPIOE_BASE (PERIPH_BASE + 0x21000UL)
+#define GPIOF_BASE (PERIPH_BASE + 0x21400UL)
+#define GPIOG_BASE (PERIPH_BASE + 0x21800UL)
+#define GPIOH_BASE (PERIPH_BASE + 0x21C00UL)
+#define GPIOI_BASE (PERIPH_BASE + 0x22000UL)
+#define GPIOJ_BASE (PERIPH_BASE + 0x22400UL)
+#define GPIOK_BASE (PERIPH_BASE + 0x22800UL)
+#define RCC_BASE (PERIPH_BASE + 0x23800UL)
+#define DMA1_BASE (PERIPH_BASE + 0x26000UL)
+#define DMA2_BASE (PERIPH_BASE + 0x26400UL)
+#define DMA1_Stream4_BASE (DMA1_BASE + 0x070UL)
+#define DMA2_Stream3_BASE (DMA2_BASE + 0x058UL)
+
+#define SPI1 ((SPI_TypeDef *)SPI1_BASE)
+#define SPI2 ((SPI_TypeDef *)SPI2_BASE)
+#define SPI3 ((SPI_TypeDef *)SPI3_BASE)
+#define SPI4 ((SPI_TypeDef *)SPI4_BASE)
+#define SPI5 ((SPI_TypeDef *)SPI5_BASE)
+#define SPI6 ((SPI_TypeDef *)SPI6_BASE)
+#define GPIOA ((GPIO_TypeDef *)GPIOA_BASE)
+#define GPIOB ((GPIO_TypeDef *)GPIOB_BASE)
+#define GPIOC ((GPIO_TypeDef *)GPIOC_BASE)
+#define GPIOD ((GPIO_TypeDef *)GPIOD_BASE)
+#define GPIOE ((GPIO_TypeDef *)GPIOE_BASE)
+#define GPIOF ((GPIO_TypeDef *)GPIOF_BASE)
+#define GPIOG ((GPIO_TypeDef *)GPIOG_BASE)
+#define GPIOH ((GPIO_TypeDef *)GPIOH_BASE)
+#define GPIOI ((GPIO_TypeDef *)GPIOI_BASE)
+#define GPIOJ ((GPIO_TypeDef *)GPIOJ_BASE)
+#define GPIOK ((GPIO_TypeDef *)GPIOK_BASE)
+#define SYSCFG ((SYSCFG_TypeDef *)SYSCFG_BASE)
+#define RCC ((RCC_TypeDef *)RCC_BASE)
+#define DMA1 ((DMA_TypeDef *)DMA1_BASE)
+#define DMA2 ((DMA_TypeDef *)DMA2_BASE)
+#define DMA1_Stream4 ((DMA_Stream_TypeDef *)DMA1_Stream4_BASE)
+#define DMA2_Stream3 ((DMA_Stream_TypeDef *)DMA2_Stream3_BASE)
+#define PWR ((PWR_TypeDef *)PWR_BASE)
+#define EXTI ((EXTI_TypeDef *)EXTI_BASE)
+#define RTC ((RTC_TypeDef *)RTC_BASE)
+
+/* Register bits */
+
+#define SPI_CR1_CPHA (1UL << 0)
+#define SPI_CR1_CPOL (1UL << 1)
+#define SPI_CR1_MSTR_Pos 2
+#define SPI_CR1_BR_Pos 3
+#define SPI_CR1_BR (7UL << SPI_CR1_BR_Pos)
+#define SPI_CR1_SPE (1UL << 6)
+#define SPI_CR1_LSBFIRST_Pos 7
+#define SPI_CR1_SSI (1UL << 8)
+#define SPI_CR1_SSM (1UL << 9)
+#define SPI_CR1_RXONLY (1UL << 10)
+#define SPI_CR1_DFF_Pos 11
+#define SPI_CR1_DFF (1UL << SPI_CR1_DFF_Pos)
+#define SPI_CR1_BIDIMODE (1UL << 15)
+#define SPI_CR2_TXDMAEN (1UL << 1)
+#define SPI_CR2_SSOE (1UL << 2)
+#define SPI_CR2_TXEIE (1UL << 7)
+#define SPI_SR_TXE (1UL << 1)
+#define SPI_SR_BSY (1UL << 7)
+
+#define RCC_AHB1ENR_BKPSRAMEN (1UL << 18)
+#define RCC_APB1ENR_PWREN (1UL << 28)
+#define RCC_APB1ENR_SPI2EN (1UL << 14)
+#define RCC_APB1ENR_SPI3EN (1UL << 15)
+#define RCC_APB2ENR_SPI1EN (1UL << 12)
+#define RCC_APB2ENR_SPI4EN (1UL << 13)
+#define RCC_APB2ENR_SPI5EN (1UL << 20)
+#define RCC_APB2ENR_SPI6EN (1UL << 21)
+#define RCC_APB2ENR_SYSCFGEN (1UL << 14)
+#define RCC_BDCR_LSEON (1UL << 0)
+#define RCC_BDCR_LSERDY (1UL << 1)
+#define RCC_BDCR_RTCSEL_0 (1UL << 8)
+#define RCC_BDCR_RTCSEL_1 (1UL << 9)
+#define RCC_BDCR_RTCSEL (RCC_BDCR_RTCSEL_0 | RCC_BDCR_RTCSEL_1)
+#define RCC_BDCR_RTCEN (1UL << 15)
+#define RCC_CSR_LSION (1UL << 0)
+#define RCC_CSR_LSIRDY (1UL << 1)
+
+#define PWR_CR_LPDS (1UL << 0)
+#define PWR_CR_PDDS (1UL << 1)
+#define PWR_CR_CWUF (1UL << 2)
+#define PWR_CR_CSBF (1UL << 3)
+#define PWR_CR_DBP (1UL << 8)
+#define PWR_CR_FPDS (1UL << 9)
+#define PWR_CSR_SBF (1UL << 1)
+#define PWR_CSR_BRR (1UL << 3)
+#define PWR_CSR_BRE (1UL << 9)
+
+#define EXTI_PR_PR0 (1UL << 0)
+#define EXTI_PR_PR1 (1UL << 1)
+#define EXTI_PR_PR2 (1UL << 2)
+#define EXTI_PR_PR3 (1UL << 3)
+#define EXTI_PR_PR4 (1UL << 4)
+#define EXTI_IMR_MR22 (1UL << 22)
+#define EXTI_RTSR_TR22 (1UL << 22)
+#define EXTI_PR_PR22 (1UL << 22)
+
+#define RTC_TR_SU_Pos 0
+#define RTC_TR_SU (0xFUL << RTC_TR_SU_Pos)
+#define RTC_TR_ST_Pos 4
+#define RTC_TR_ST (0x7UL << RTC_TR_ST_Pos)
+#define RTC_TR_MNU_Pos 8
+#define RTC_TR_MNU (0xFUL << RTC_TR_MNU_Pos)
+#define RTC_TR_MNT_Pos 12
+#define RTC_TR_MNT (0x7UL << RTC_TR_MNT_Pos)
+#define RTC_TR_HU_Pos 16
+#define RTC_TR_HU (0xFUL << RTC_TR_HU_Pos)
+#define RTC_TR_HT_Pos 20
+#define RTC_TR_HT (0x3UL << RTC_TR_HT_Pos)
+#define RTC_CR_WUCKSEL (0x7UL << 0)
+#define RTC_CR_WUCKSEL_2 (1UL << 2)
+#define RTC_CR_BYPSHAD (1UL << 5)
+#define RTC_CR_FMT (1UL << 6)
+#define RTC_CR_WUTE (1UL << 10)
+#define RTC_CR_WUTIE (1UL << 14)
+#define RTC_ISR_WUTWF (1UL << 2)
+#define RTC_ISR_INITS (1UL << 4)
+#define RTC_ISR_INITF (1UL << 6)
+#define RTC_ISR_INIT (1UL << 7)
+#define RTC_ISR_WUTF (1UL << 10)
+#define RTC_ISR_TAMP1F (1UL << 13)
+#define RTC_TAFCR_TAMP1E (1UL << 0)
+#define RTC_TAFCR_TAMP1TRG (1UL << 1)
+#define RTC_TAFCR_TAMPIE (1UL << 2)
+#define RTC_PRER_PREDIV_S (0x7FFFUL << 0)
+#define RTC_PRER_PREDIV_A_Pos 16
+#define RTC_SSR_SS (0xFFFFUL << 0)
+
+#endif // !__STM32F429XX_H__
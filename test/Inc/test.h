@@ -0,0 +1,39 @@
+#ifndef __TEST_H__
+#define __TEST_H__
+
+#include <stdio.h>
+
+/*
+ * Minimal host unit test support. A test file defines its test functions and runs them from main with TEST_RUN,
+ * main returns TEST_RESULT (0 when every check passed)
+ */
+
+/* Exported variables */
+
+// Checks failed so far, defined by TEST_MAIN_VARIABLES in the test file
+extern unsigned test_failures;
+#define TEST_MAIN_VARIABLES unsigned test_failures
+
+/* Exported macros */
+
+// Checks a condition, a failure is reported and the test goes on
+#define TEST_CHECK(Cond)                                                       \
+    do {                                                                       \
+        if (!(Cond)) {                                                         \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #Cond);    \
+            test_failures++;                                                   \
+        }                                                                      \
+    } while (0)
+
+// Runs a test function and reports its result
+#define TEST_RUN(Function)                                                     \
+    do {                                                                       \
+        unsigned failures = test_failures;                                     \
+        Function();                                                            \
+        printf("%s %s\n", (test_failures == failures) ? "PASS" : "FAIL",       \
+               #Function);                                                     \
+    } while (0)
+
+#define TEST_RESULT (test_failures != 0)
+
+#endif // !__TEST_H__
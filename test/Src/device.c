@@ -0,0 +1,43 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+#include "stm32f429xx.h"
+
+/* Global variables */
+
+// System control block of the stand-in
+SCB_Type Test_SCB;
+
+/*
+ * Maps zeroed host memory at the peripheral addresses before main, the
+ * registers are then plain memory set and checked by the tests
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+__attribute__((constructor)) static void Test_MapPeripherals(void) {
+    void *pMemory = mmap((void *)PERIPH_BASE, PERIPH_SIZE,
+                         PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE,
+                         -1, 0);
+
+    if (pMemory != (void *)PERIPH_BASE) {
+        printf("device: the peripherals can not be mapped at 0x%08lX\n",
+               PERIPH_BASE);
+        exit(1);
+    }
+}
+
+/*
+ * NVIC functions of the stand-in, the tests invoke the handlers themselves
+ */
+void __NVIC_EnableIRQ(IRQn_Type IRQn) { (void)IRQn; }
+void __NVIC_DisableIRQ(IRQn_Type IRQn) { (void)IRQn; }
+void __NVIC_SetPendingIRQ(IRQn_Type IRQn) { (void)IRQn; }
+void __NVIC_SetPriority(IRQn_Type IRQn, uint32_t Priority) {
+    (void)IRQn;
+    (void)Priority;
+}
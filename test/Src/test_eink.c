@@ -0,0 +1,367 @@
+#include "einkPaper_2_13.h"
+#include "test.h"
+
+// Timeline of the displays, in microseconds: a byte on the SPIx (8 MHz), the
+// Busy periods of the SW reset and of a full refresh
+#define TEST_BYTE_US 1
+#define TEST_SWRESET_US 3000
+#define TEST_REFRESH_US 2000000
+
+// Start of the updates, the power up delay of the displays has elapsed
+#define TEST_START_US 1000000
+
+// Events served before an update is considered stuck
+#define TEST_MAX_EVENTS 4096
+
+/*
+ * Simulated side of a display: its Busy pin, the DMA stream of its SPIx and
+ * the timer of the driver. Times are in microseconds
+ */
+typedef struct {
+    EinkPaper_TypeDef *pDisplay;   // Display driven by the simulation
+    uint64_t BusyEnd;              // Busy pin HIGH until then
+    uint8_t BusyEdge;              // The falling edge of Busy is to come
+    GPIO_IRQCallback BusyCallback; // Registered on the Busy line, or NULL
+    uint64_t StreamEnd;            // End of the frame streamed by the DMA
+    uint8_t Streaming;             // The DMA stream is enabled
+    uint64_t TimerEnd;             // Expiry of the timer of the driver
+    uint8_t TimerActive;           // The timer of the driver is started
+} Test_DisplayTypeDef;
+
+/* Global variables */
+TEST_MAIN_VARIABLES;
+static Test_DisplayTypeDef displays[2] = {{.pDisplay = &epaper},
+                                          {.pDisplay = &epaper_status}};
+static uint64_t now = TEST_START_US;
+static uint32_t progress;
+static uint32_t refreshing;
+static uint8_t refreshing_both;
+static int32_t locks[Power_Mode_Count];
+static const uint8_t frame[2][EINK_DISPLAY_HALF_SIZE];
+
+/*
+ * Finds the simulated side of a display
+ *
+ * Params:
+ *    * pDisplay, a pointer to the EinkPaper_TypeDef of the display
+ * Returns:
+ *    * pSim, a pointer to the Test_DisplayTypeDef of the display
+ */
+static Test_DisplayTypeDef *test_display(const EinkPaper_TypeDef *pDisplay) {
+    return (pDisplay == &epaper) ? &displays[0] : &displays[1];
+}
+
+/*
+ * Finds the display of an SPIx driver
+ *
+ * Params:
+ *    * pSPIDriver, a pointer to the SPI_DriverTypeDef of a display
+ * Returns:
+ *    * pSim, a pointer to the Test_DisplayTypeDef of the display
+ */
+static Test_DisplayTypeDef *test_spi(const SPI_DriverTypeDef *pSPIDriver) {
+    return (pSPIDriver == &epaper.SPIDriver) ? &displays[0] : &displays[1];
+}
+
+/*
+ * Command received by a display, the SW reset and the master activation hold
+ * Busy HIGH
+ *
+ * Params:
+ *    * pSim, a pointer to the Test_DisplayTypeDef of the display
+ *    * Command, an 8 bit-wide integer with the command byte
+ * Returns:
+ *    * None
+ */
+static void test_command(Test_DisplayTypeDef *pSim, uint8_t Command) {
+    if (Command == 0x12) {
+        pSim->BusyEnd = now + TEST_SWRESET_US;
+        pSim->BusyEdge = 1;
+    } else if (Command == 0x20) {
+        pSim->BusyEnd = now + TEST_REFRESH_US;
+        pSim->BusyEdge = 1;
+    }
+}
+
+/* Stubs of the SPI API, the CPU is blocked while it sends */
+
+DriverStatus SPI_Init(SPI_DriverTypeDef *pSPIDriver) {
+    (void)pSPIDriver;
+    return OK;
+}
+void SPI_ControlPins_Init(SPI_DriverTypeDef *pSPIDriver, GPIO_TypeDef *pGPIOx,
+                          uint16_t DC_Mask, uint16_t CS_Mask) {
+    (void)pSPIDriver;
+    (void)pGPIOx;
+    (void)DC_Mask;
+    (void)CS_Mask;
+}
+void SPI_IRQ_Control(IRQn_Type IRQNumber, EnableDisable EnOrDi) {
+    (void)IRQNumber;
+    (void)EnOrDi;
+}
+void SPI_OpenSession(SPI_DriverTypeDef *pSPIDriver) { (void)pSPIDriver; }
+void SPI_Flush(SPI_DriverTypeDef *pSPIDriver) { (void)pSPIDriver; }
+void SPI_CloseSession(SPI_DriverTypeDef *pSPIDriver) { (void)pSPIDriver; }
+DriverStatus SPI_SetDataFormat(SPI_DriverTypeDef *pSPIDriver,
+                               SPI_Config_DataFormat DataFormat) {
+    (void)pSPIDriver;
+    (void)DataFormat;
+    return OK;
+}
+void SPI_DMA_IRQHandling(SPI_DriverTypeDef *pSPIDriver,
+                         DMA_DriverTypeDef *pDMADriver) {
+    (void)pSPIDriver;
+    (void)pDMADriver;
+}
+DriverStatus SPI_GetStatusDMA(SPI_DriverTypeDef *pSPIDriver,
+                              DMA_DriverTypeDef *pDMADriver) {
+    (void)pSPIDriver;
+    (void)pDMADriver;
+    return OK;
+}
+uint8_t SPI_Queue_GetFree(SPI_DriverTypeDef *pSPIDriver) {
+    (void)pSPIDriver;
+    return SPI_QUEUE_SIZE;
+}
+
+void SPI_SendData(SPI_DriverTypeDef *pSPIDriver, const uint8_t *pTxBuffer,
+                  uint32_t Len) {
+    Test_DisplayTypeDef *pSim = test_spi(pSPIDriver);
+    uint16_t dc = 1U << pSim->pDisplay->DC_PinNumber;
+
+    // D/C is driven LOW by the last selection for a command
+    now += Len * TEST_BYTE_US;
+    if ((pSim->pDisplay->pGPIOx->BSRR >> 16) & dc) {
+        test_command(pSim, pTxBuffer[0]);
+    }
+}
+
+DriverStatus SPI_Queue_Push(SPI_DriverTypeDef *pSPIDriver,
+                            const SPI_DescriptorTypeDef *pDescriptor) {
+    now += pDescriptor->Len * TEST_BYTE_US;
+    if (pDescriptor->DC == LOW) {
+        test_command(test_spi(pSPIDriver), pDescriptor->pTxBuffer[0]);
+    }
+    return OK;
+}
+
+DriverStatus SPI_SendSegmentsDMA(SPI_DriverTypeDef *pSPIDriver,
+                                 DMA_DriverTypeDef *pDMADriver,
+                                 const SPI_SegmentTypeDef *pSegments,
+                                 uint8_t Count) {
+    Test_DisplayTypeDef *pSim = test_spi(pSPIDriver);
+    uint32_t len = 0;
+    (void)pDMADriver;
+
+    for (uint8_t i = 0; i < Count; i++) {
+        len += pSegments[i].Len;
+    }
+    pSim->StreamEnd = now + len * TEST_BYTE_US;
+    pSim->Streaming = 1;
+    return OK;
+}
+
+/* Stubs of the DMA API */
+
+DriverStatus DMA_Init(DMA_DriverTypeDef *pDMADriver) {
+    (void)pDMADriver;
+    return OK;
+}
+void DMA_IRQ_Control(IRQn_Type IRQNumber, EnableDisable EnOrDi) {
+    (void)IRQNumber;
+    (void)EnOrDi;
+}
+FlagStatus DMA_GetEnabled(DMA_DriverTypeDef *pDMADriver) {
+    uint8_t streaming = (pDMADriver == &epaper.DMADriver)
+                            ? displays[0].Streaming
+                            : displays[1].Streaming;
+
+    return streaming ? FLAG_HIGH : FLAG_LOW;
+}
+
+/* Stubs of the GPIO API, Busy follows the commands */
+
+DriverStatus GPIO_Init(GPIO_DriverTypeDef *pGPIODriver) {
+    (void)pGPIODriver;
+    return OK;
+}
+void GPIO_IRQ_Control(IRQn_Type IRQNumber, EnableDisable EnOrDi) {
+    (void)IRQNumber;
+    (void)EnOrDi;
+}
+DriverStatus GPIO_IRQ_Register(uint8_t PinNumber, GPIO_IRQCallback Callback,
+                               void *pContext) {
+    (void)PinNumber;
+    test_display(pContext)->BusyCallback = Callback;
+    return OK;
+}
+void GPIO_Pin_Write(GPIO_TypeDef *pGPIOx, uint8_t PinNumber,
+                    PinLogicalLevel LorH) {
+    (void)pGPIOx;
+    (void)PinNumber;
+    (void)LorH;
+}
+uint8_t GPIO_Pin_Read(GPIO_TypeDef *pGPIOx, uint8_t PinNumber) {
+    (void)PinNumber;
+    return now < ((pGPIOx == epaper.pGPIOx) ? displays[0].BusyEnd
+                                            : displays[1].BusyEnd);
+}
+
+/* Stubs of the Power, SysTick and SWTimer APIs */
+
+void Power_Lock(Power_Mode Mode) { locks[Mode]++; }
+void Power_Unlock(Power_Mode Mode) { locks[Mode]--; }
+uint64_t SysTick_GetMs(void) { return now / 1000; }
+uint64_t SysTick_Deadline(uint32_t ms) { return (now / 1000) + ms; }
+
+void SWTimer_Start(SWTimer_TypeDef *pTimer, uint32_t Milliseconds) {
+    Test_DisplayTypeDef *pSim = test_display(pTimer->pContext);
+
+    pSim->TimerEnd = now + (uint64_t)Milliseconds * 1000;
+    pSim->TimerActive = 1;
+}
+
+/* Callbacks of the driver */
+
+void eInkDisplay_CallbackProgress(EinkPaper_TypeDef *pDisplay) {
+    (void)pDisplay;
+    progress++;
+}
+
+void eInkDisplay_CallbackRefreshing(void) {
+    refreshing++;
+    refreshing_both = (epaper.State == EinkPaper_State_Refresh) &&
+                      (epaper_status.State == EinkPaper_State_Refresh);
+}
+
+/*
+ * Moves the time to the next event (end of a stream, falling edge of Busy,
+ * timer expiry) and serves it as its interruption does
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * served, 1 if an event was served, 0 if none is left
+ */
+static uint8_t test_event(void) {
+    Test_DisplayTypeDef *pNext = NULL;
+    uint64_t next = UINT64_MAX;
+    uint8_t kind = 0;
+
+    for (uint8_t i = 0; i < 2; i++) {
+        Test_DisplayTypeDef *pSim = &displays[i];
+
+        if (pSim->Streaming && (pSim->StreamEnd < next)) {
+            next = pSim->StreamEnd;
+            pNext = pSim;
+            kind = 0;
+        }
+        if (pSim->BusyEdge && (pSim->BusyEnd < next)) {
+            next = pSim->BusyEnd;
+            pNext = pSim;
+            kind = 1;
+        }
+        if (pSim->TimerActive && (pSim->TimerEnd < next)) {
+            next = pSim->TimerEnd;
+            pNext = pSim;
+            kind = 2;
+        }
+    }
+    if (pNext == NULL) {
+        return 0;
+    }
+
+    if (next > now) {
+        now = next;
+    }
+    if (kind == 0) {
+        pNext->Streaming = 0;
+        eInkDisplay_DMA_IRQHandling(pNext->pDisplay);
+    } else if (kind == 1) {
+        pNext->BusyEdge = 0;
+        if (pNext->BusyCallback != NULL) {
+            pNext->BusyCallback(pNext->pDisplay->Busy_PinNumber,
+                                pNext->pDisplay);
+        }
+    } else {
+        pNext->TimerActive = 0;
+        pNext->pDisplay->Timer.Callback(&pNext->pDisplay->Timer);
+    }
+    return 1;
+}
+
+/*
+ * Runs an update of several displays from deep sleep, processing it on every
+ * signaled progress only. The displays are put in deep sleep again
+ *
+ * Params:
+ *    * pUpdates, a pointer to the EinkPaper_UpdateTypeDef array
+ *    * Count, an 8 bit-wide integer with the amount of updates
+ * Returns:
+ *    * elapsed, the microseconds from the start to the end of the update
+ */
+static uint64_t test_update(EinkPaper_UpdateTypeDef *pUpdates, uint8_t Count) {
+    uint64_t start = now;
+    uint64_t elapsed = 0;
+
+    progress = 0;
+    refreshing = 0;
+    TEST_CHECK(eInkDisplay_StartImages(pUpdates, Count) == OK);
+    for (uint32_t i = 0; i < TEST_MAX_EVENTS; i++) {
+        if (progress) {
+            progress = 0;
+            if (eInkDisplay_ProcessImages(pUpdates, Count) == OK) {
+                elapsed = now - start;
+                break;
+            }
+        } else if (!test_event()) {
+            break;
+        }
+    }
+
+    TEST_CHECK(elapsed != 0);
+    TEST_CHECK(refreshing == 1);
+    TEST_CHECK(locks[Power_Mode_Stop] == 0);
+    TEST_CHECK(locks[Power_Mode_Standby] == 0);
+    for (uint8_t i = 0; i < Count; i++) {
+        TEST_CHECK(eInkDisplay_Sleep(pUpdates[i].pDisplay) == OK);
+    }
+    return elapsed;
+}
+
+/*
+ * Both displays updated at once take about as long as the slowest one alone:
+ * the wake ups and frame streams overlap and so do both refreshes. The status
+ * display polls its Busy pin, it may end a poll period late
+ */
+static void test_eink_overlap(void) {
+    EinkPaper_UpdateTypeDef updates[] = {
+        {&epaper, frame[0], frame[1]},
+        {&epaper_status, frame[1], frame[0]},
+    };
+    uint64_t main_only, status_only, both, slowest;
+
+    eInkDisplay_Init(&epaper);
+    eInkDisplay_Init(&epaper_status);
+    TEST_CHECK(displays[0].BusyCallback != NULL);
+    TEST_CHECK(displays[1].BusyCallback == NULL);
+
+    main_only = test_update(&updates[0], 1);
+    status_only = test_update(&updates[1], 1);
+    TEST_CHECK(main_only >= TEST_REFRESH_US);
+    TEST_CHECK(status_only >= TEST_REFRESH_US);
+    slowest = (main_only > status_only) ? main_only : status_only;
+
+    both = test_update(updates, 2);
+    TEST_CHECK(refreshing_both);
+    TEST_CHECK(both >= slowest);
+    TEST_CHECK(both <= slowest + EINK_BUSY_POLL_MS * 1000);
+    TEST_CHECK(both < main_only + status_only - TEST_REFRESH_US / 2);
+}
+
+int main(void) {
+    TEST_RUN(test_eink_overlap);
+
+    return TEST_RESULT;
+}
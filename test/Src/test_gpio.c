@@ -0,0 +1,87 @@
+#include "stm32f429zi.h"
+#include "test.h"
+
+// Written to the port before every check: the BSRR store must replace it, the
+// ODR must keep it (the stand-in does not apply BSRR to ODR)
+#define TEST_BSRR_SENTINEL 0xDEADBEEFUL
+#define TEST_ODR_SENTINEL 0x0000A5C3UL
+
+/* Global variables */
+TEST_MAIN_VARIABLES;
+
+/*
+ * Fills the output registers of a port with the sentinels
+ *
+ * Params:
+ *    * pGPIOx, pointer to the GPIO_TypeDef of the port
+ * Returns:
+ *    * None
+ */
+static void test_reset(GPIO_TypeDef *pGPIOx) {
+    pGPIOx->BSRR = TEST_BSRR_SENTINEL;
+    pGPIOx->ODR = TEST_ODR_SENTINEL;
+}
+
+/*
+ * A port write sets and resets its masks in a single BSRR store, the reset
+ * masks go to the upper half
+ */
+static void test_gpio_port_write(void) {
+    test_reset(GPIOB);
+    GPIO_Port_Write(GPIOB, (1 << 3) | (1 << 15), (1 << 0) | (1 << 12));
+    TEST_CHECK(GPIOB->BSRR ==
+               ((((1UL << 0) | (1UL << 12)) << 16) | (1UL << 3) | (1UL << 15)));
+    TEST_CHECK(GPIOB->ODR == TEST_ODR_SENTINEL);
+
+    // Set only, reset only
+    test_reset(GPIOB);
+    GPIO_Port_Write(GPIOB, 0xFFFF, 0);
+    TEST_CHECK(GPIOB->BSRR == 0x0000FFFFUL);
+    GPIO_Port_Write(GPIOB, 0, 0xFFFF);
+    TEST_CHECK(GPIOB->BSRR == 0xFFFF0000UL);
+    TEST_CHECK(GPIOB->ODR == TEST_ODR_SENTINEL);
+}
+
+/*
+ * Setting, resetting and writing a pin store its single bit, the other pins of
+ * the port are untouched
+ */
+static void test_gpio_pin(void) {
+    for (uint8_t pin = 0; pin < 16; pin++) {
+        test_reset(GPIOC);
+        GPIO_Pin_Set(GPIOC, pin);
+        TEST_CHECK(GPIOC->BSRR == (1UL << pin));
+
+        GPIO_Pin_Reset(GPIOC, pin);
+        TEST_CHECK(GPIOC->BSRR == (1UL << (pin + 16)));
+
+        GPIO_Pin_Write(GPIOC, pin, HIGH);
+        TEST_CHECK(GPIOC->BSRR == (1UL << pin));
+
+        GPIO_Pin_Write(GPIOC, pin, LOW);
+        TEST_CHECK(GPIOC->BSRR == (1UL << (pin + 16)));
+        TEST_CHECK(GPIOC->ODR == TEST_ODR_SENTINEL);
+    }
+}
+
+/*
+ * A toggle reads the level from ODR and stores the opposite one through BSRR
+ */
+static void test_gpio_toggle(void) {
+    test_reset(GPIOD);
+    // Pin 0 HIGH in the sentinel
+    GPIO_Pin_Toggle(GPIOD, 0);
+    TEST_CHECK(GPIOD->BSRR == (1UL << 16));
+    // Pin 2 LOW in the sentinel
+    GPIO_Pin_Toggle(GPIOD, 2);
+    TEST_CHECK(GPIOD->BSRR == (1UL << 2));
+    TEST_CHECK(GPIOD->ODR == TEST_ODR_SENTINEL);
+}
+
+int main(void) {
+    TEST_RUN(test_gpio_port_write);
+    TEST_RUN(test_gpio_pin);
+    TEST_RUN(test_gpio_toggle);
+
+    return TEST_RESULT;
+}
@@ -0,0 +1,158 @@
+#include "stm32f429zi.h"
+#include "test.h"
+
+// Pomodoro hour of the firmware, in milliseconds: a display update on every
+// minute boundary. The frame is rendered (Run), the display woken up and the
+// frame streamed with Stop mode locked (Sleep), then the refresh waits on the
+// Busy edge (Stop)
+#define TEST_HOUR_MS 3600000
+#define TEST_RENDER_MS 5
+#define TEST_TRANSFER_MS 25
+#define TEST_REFRESH_MS 2000
+#define TEST_BUSY_EDGE_MS 1
+
+/* Global variables */
+TEST_MAIN_VARIABLES;
+static uint32_t now;
+static Clock_Profile profile = Clock_Profile_Run;
+
+/* Stubs of the Clock, GPIO and RTC APIs */
+
+const Clock_ProfileTypeDef Clock_Profiles[Clock_Profile_Count] = {
+    [Clock_Profile_Idle] = {.Source = Clock_Source_HSI},
+    [Clock_Profile_Run] = {.Source = Clock_Source_HSI},
+    [Clock_Profile_Render] = {.Source = Clock_Source_PLL},
+};
+Clock_Profile Clock_GetProfile(void) { return profile; }
+DriverStatus Clock_SetProfile(Clock_Profile Profile) {
+    profile = Profile;
+    return OK;
+}
+uint8_t GPIO_Pin_Read(GPIO_TypeDef *pGPIOx, uint8_t PinNumber) {
+    (void)pGPIOx;
+    (void)PinNumber;
+    return LOW;
+}
+uint32_t RTC_GetMilliseconds(void) { return now; }
+
+/*
+ * Starts the power manager at a time of the day, no mode is locked
+ *
+ * Params:
+ *    * Start, a 32 bit-wide integer with the milliseconds of the RTC
+ * Returns:
+ *    * None
+ */
+static void test_reset(uint32_t Start) {
+    now = Start;
+    profile = Clock_Profile_Run;
+    PWR->CSR = PWR_CSR_BRR;
+    Power_Init();
+}
+
+/*
+ * Sleeps on exit of the deferred work until the next one, the time elapses
+ * in the mode returned by Power_SleepOnExit
+ *
+ * Params:
+ *    * Deadline, a 32 bit-wide integer with the seconds until the wakeup
+ *    * Ms, a 32 bit-wide integer with the milliseconds until the deferred
+ * work runs again
+ * Returns:
+ *    * Power_Mode, the mode entered on exit
+ */
+static Power_Mode test_sleep(uint32_t Deadline, uint32_t Ms) {
+    Power_Mode mode = Power_SleepOnExit(Deadline);
+
+    now += Ms;
+    Power_ClearDeepSleep();
+    return mode;
+}
+
+/*
+ * Every interval is accounted to the mode entered on exit, the deferred work
+ * to Run mode. The current mode is accounted up to now
+ */
+static void test_power_residency(void) {
+    test_reset(1000);
+
+    now += 50;
+    TEST_CHECK(test_sleep(60, 59950) == Power_Mode_Stop);
+    now += 20;
+    TEST_CHECK(test_sleep(0, 500) == Power_Mode_Sleep);
+    now += 10;
+
+    TEST_CHECK(Power_GetResidency(Power_Mode_Run) == 80);
+    TEST_CHECK(Power_GetResidency(Power_Mode_Stop) == 59950);
+    TEST_CHECK(Power_GetResidency(Power_Mode_Sleep) == 500);
+    TEST_CHECK(Power_GetResidency(Power_Mode_Standby) == 0);
+
+    // Power_Idle enters the mode from thread mode and returns to Run mode
+    TEST_CHECK(Power_Idle(0) == Power_Mode_Sleep);
+    TEST_CHECK(Power_GetResidency(Power_Mode_Run) == 80);
+}
+
+/*
+ * The locks and the clock profile limit the mode, the time is accounted to
+ * the mode actually entered
+ */
+static void test_power_locks(void) {
+    test_reset(0);
+
+    Power_Lock(Power_Mode_Stop);
+    TEST_CHECK(test_sleep(60, 100) == Power_Mode_Sleep);
+    Power_Lock(Power_Mode_Sleep);
+    TEST_CHECK(test_sleep(60, 30) == Power_Mode_Run);
+    Power_Unlock(Power_Mode_Sleep);
+    Power_Unlock(Power_Mode_Stop);
+
+    // Thread mode can't restore the PLL after Stop mode
+    profile = Clock_Profile_Render;
+    TEST_CHECK(test_sleep(60, 200) == Power_Mode_Sleep);
+
+    TEST_CHECK(Power_GetResidency(Power_Mode_Sleep) == 300);
+    TEST_CHECK(Power_GetResidency(Power_Mode_Run) == 30);
+    TEST_CHECK(Power_GetResidency(Power_Mode_Stop) == 0);
+}
+
+/*
+ * Residency over a Pomodoro hour, 60 display updates: every interval is
+ * accounted once and the MCU spends 99% of the hour in Stop mode
+ */
+static void test_power_hour(void) {
+    uint32_t run, sleep, stop;
+    uint32_t busy = TEST_TRANSFER_MS + TEST_REFRESH_MS + TEST_BUSY_EDGE_MS;
+
+    test_reset(123456);
+    for (uint8_t minute = 0; minute < 60; minute++) {
+        // RTC wakeup: the tick task renders the frame and starts the update
+        now += TEST_RENDER_MS;
+        Power_Lock(Power_Mode_Stop);
+        TEST_CHECK(test_sleep(0, TEST_TRANSFER_MS) == Power_Mode_Sleep);
+
+        // Frame streamed, the refresh ends with the Busy edge
+        Power_Unlock(Power_Mode_Stop);
+        TEST_CHECK(test_sleep(59, TEST_REFRESH_MS) == Power_Mode_Stop);
+        now += TEST_BUSY_EDGE_MS;
+
+        // Next minute boundary
+        TEST_CHECK(test_sleep(57, 60000 - TEST_RENDER_MS - busy) ==
+                   Power_Mode_Stop);
+    }
+
+    run = Power_GetResidency(Power_Mode_Run);
+    sleep = Power_GetResidency(Power_Mode_Sleep);
+    stop = Power_GetResidency(Power_Mode_Stop);
+    TEST_CHECK(run == 60 * (TEST_RENDER_MS + TEST_BUSY_EDGE_MS));
+    TEST_CHECK(sleep == 60 * TEST_TRANSFER_MS);
+    TEST_CHECK(run + sleep + stop == TEST_HOUR_MS);
+    TEST_CHECK(stop >= TEST_HOUR_MS / 100 * 99);
+}
+
+int main(void) {
+    TEST_RUN(test_power_residency);
+    TEST_RUN(test_power_locks);
+    TEST_RUN(test_power_hour);
+
+    return TEST_RESULT;
+}
@@ -0,0 +1,160 @@
+#include <pthread.h>
+#include <sched.h>
+
+#include "stm32f429zi.h"
+#include "test.h"
+
+// Items streamed by the stress test, the free running indexes wrap around
+// 2^32 on the way
+#define TEST_RING_ITEMS 1000000U
+#define TEST_RING_START 0xFFFFF000U
+
+/*
+ * Item of the stress test, a torn copy breaks the check word
+ */
+typedef struct {
+    uint32_t Sequence;
+    uint32_t Check;
+} Test_ItemTypeDef;
+
+RING_DEFINE(Test_Ring, Test_ItemTypeDef, 8)
+
+/* Global variables */
+TEST_MAIN_VARIABLES;
+static Test_Ring_TypeDef ring;
+static volatile uint32_t torn;
+static volatile uint32_t unordered;
+static volatile uint32_t overfull;
+
+/*
+ * Producer side of the stress test, retries while the ring is full. The
+ * retries yield, the test also runs on a single core
+ *
+ * Params:
+ *    * pArg, unused
+ * Returns:
+ *    * None
+ */
+static void *test_producer(void *pArg) {
+    (void)pArg;
+
+    for (uint32_t i = 0; i < TEST_RING_ITEMS; i++) {
+        Test_ItemTypeDef item = {.Sequence = i, .Check = ~i};
+
+        while (Test_Ring_Push(&ring, &item) == BUSY) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Consumer side of the stress test, every item must arrive once, in order and
+ * intact
+ *
+ * Params:
+ *    * pArg, unused
+ * Returns:
+ *    * None
+ */
+static void *test_consumer(void *pArg) {
+    Test_ItemTypeDef item;
+    uint32_t expected = 0;
+
+    (void)pArg;
+
+    while (expected < TEST_RING_ITEMS) {
+        if (Test_Ring_Count(&ring) > 8) {
+            overfull++;
+        }
+        if (Test_Ring_Pop(&ring, &item) != OK) {
+            sched_yield();
+            continue;
+        }
+        if (item.Check != ~item.Sequence) {
+            torn++;
+        }
+        if (item.Sequence != expected) {
+            unordered++;
+        }
+        expected++;
+    }
+    return NULL;
+}
+
+/*
+ * Empty and full rings, a zeroed ring is empty
+ */
+static void test_ring_bounds(void) {
+    Test_Ring_TypeDef bounds = {0};
+    Test_ItemTypeDef item = {0};
+
+    TEST_CHECK(Test_Ring_Pop(&bounds, &item) == ERROR);
+    for (uint32_t i = 0; i < 8; i++) {
+        item.Sequence = i;
+        TEST_CHECK(Test_Ring_Push(&bounds, &item) == OK);
+    }
+    TEST_CHECK(Test_Ring_Push(&bounds, &item) == BUSY);
+    TEST_CHECK(Test_Ring_Count(&bounds) == 8);
+
+    for (uint32_t i = 0; i < 8; i++) {
+        TEST_CHECK(Test_Ring_Pop(&bounds, &item) == OK);
+        TEST_CHECK(item.Sequence == i);
+    }
+    TEST_CHECK(Test_Ring_Pop(&bounds, &item) == ERROR);
+    TEST_CHECK(Test_Ring_Count(&bounds) == 0);
+}
+
+/*
+ * Full and empty detection across the wrap of the free running indexes
+ */
+static void test_ring_wrap(void) {
+    Test_Ring_TypeDef wrap = {.Index = {.Head = 0xFFFFFFFC,
+                                        .Tail = 0xFFFFFFFC}};
+    Test_ItemTypeDef item = {0};
+
+    for (uint32_t i = 0; i < 8; i++) {
+        item.Sequence = i;
+        TEST_CHECK(Test_Ring_Push(&wrap, &item) == OK);
+    }
+    TEST_CHECK(wrap.Index.Head == 4);
+    TEST_CHECK(Test_Ring_Push(&wrap, &item) == BUSY);
+    TEST_CHECK(Test_Ring_Count(&wrap) == 8);
+
+    for (uint32_t i = 0; i < 8; i++) {
+        TEST_CHECK(Test_Ring_Pop(&wrap, &item) == OK);
+        TEST_CHECK(item.Sequence == i);
+    }
+    TEST_CHECK(Test_Ring_Pop(&wrap, &item) == ERROR);
+}
+
+/*
+ * One producer thread and one consumer thread hammer a small ring, the
+ * barriers must keep every item intact and in order
+ */
+static void test_ring_stress(void) {
+    pthread_t producer;
+    pthread_t consumer;
+
+    ring.Index.Head = TEST_RING_START;
+    ring.Index.Tail = TEST_RING_START;
+
+    pthread_create(&consumer, NULL, test_consumer, NULL);
+    pthread_create(&producer, NULL, test_producer, NULL);
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+
+    TEST_CHECK(torn == 0);
+    TEST_CHECK(unordered == 0);
+    TEST_CHECK(overfull == 0);
+    TEST_CHECK(Test_Ring_Count(&ring) == 0);
+    TEST_CHECK(ring.Index.Head == TEST_RING_START + TEST_RING_ITEMS);
+}
+
+int main(void) {
+    TEST_RUN(test_ring_bounds);
+    TEST_RUN(test_ring_wrap);
+    TEST_RUN(test_ring_stress);
+
+    return TEST_RESULT;
+}
@@ -0,0 +1,332 @@
+#include "stm32f429zi.h"
+#include "test.h"
+
+// Entry of the vector table, not declared by the driver header
+void RTC_WKUP_IRQHandler(void);
+
+/* Global variables */
+TEST_MAIN_VARIABLES;
+
+// Simulated RTCCLK / 16 ticks (2048 Hz, LSE) and the tick at which the
+// wakeup timer elapses, while wakeup_armed is set
+static uint32_t rtc_ticks;
+static uint32_t wakeup_at;
+static uint8_t wakeup_armed;
+
+// Deferred work posted by the wakeup callback (SWTimer API) and the posts
+static Defer_Callback deferred;
+static uint32_t wakeups;
+
+// Pomodoro hour run by test_minute: minutes of every state, current state and
+// its start (RTC seconds), minute ticks served
+static const uint32_t pomodoro[] = {25, 5, 25, 5};
+static uint8_t pomodoro_state;
+static uint32_t state_start;
+static uint32_t minute_ticks;
+
+/*
+ * Stub of the Defer API, the wheel processing posted by the wakeup callback
+ * runs once the interruption returns
+ *
+ * Params:
+ *    * Callback, the deferred work
+ * Returns:
+ *    * DriverStatus, OK
+ */
+DriverStatus Defer_Post(Defer_Callback Callback) {
+    deferred = Callback;
+    wakeups++;
+    return OK;
+}
+
+/*
+ * Sets the calendar and the sub-second counter of the simulated RTC
+ *
+ * Params:
+ *    * Hours, Minutes, Seconds, 32 bit-wide integers with the time of day
+ *    * SubSeconds, a 32 bit-wide integer with SS[15:0], counting down from
+ * PREDIV_S
+ * Returns:
+ *    * None
+ */
+static void test_set_time(uint32_t Hours, uint32_t Minutes, uint32_t Seconds,
+                          uint32_t SubSeconds) {
+    RTC->TR = ((Hours / 10) << RTC_TR_HT_Pos) |
+              ((Hours % 10) << RTC_TR_HU_Pos) |
+              ((Minutes / 10) << RTC_TR_MNT_Pos) |
+              ((Minutes % 10) << RTC_TR_MNU_Pos) |
+              ((Seconds / 10) << RTC_TR_ST_Pos) |
+              ((Seconds % 10) << RTC_TR_SU_Pos);
+    RTC->SSR = SubSeconds;
+}
+
+/*
+ * Sets the calendar of the simulated RTC to a tick of RTCCLK / 16
+ *
+ * Params:
+ *    * Ticks, a 32 bit-wide integer with the ticks since midnight
+ * Returns:
+ *    * None
+ */
+static void test_set_ticks(uint32_t Ticks) {
+    uint32_t second = Ticks / 2048;
+
+    rtc_ticks = Ticks;
+    test_set_time((second / 3600) % 24, (second / 60) % 60, second % 60,
+                  255 - ((Ticks % 2048) / 8));
+}
+
+/*
+ * Latches the wakeup timer programmed at the current tick. RTCCLK / 16 counts
+ * WUTR + 1 ticks, ck_spre counts WUTR + 1 second boundaries
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+static void test_latch_wakeup(void) {
+    wakeup_armed = ((RTC->CR & RTC_CR_WUTE) != 0);
+    if (RTC->CR & RTC_CR_WUCKSEL_2) {
+        wakeup_at = ((rtc_ticks / 2048) + 1 + RTC->WUTR) * 2048;
+    } else {
+        wakeup_at = rtc_ticks + RTC->WUTR + 1;
+    }
+}
+
+/*
+ * Resets the simulated RTC to a calendar already running (backup domain
+ * powered) from a clock and initializes the driver on it
+ *
+ * Params:
+ *    * Source, a RTC_Config_Source with the clock selected before the reset
+ * Returns:
+ *    * None
+ */
+static void test_reset(RTC_Config_Source Source) {
+    RCC->BDCR = RCC_BDCR_RTCEN | ((Source == RTC_Source_LSE)
+                                      ? RCC_BDCR_RTCSEL_0
+                                      : RCC_BDCR_RTCSEL_1);
+    RCC->CSR = RCC_CSR_LSIRDY;
+    RTC->ISR = RTC_ISR_INITS | RTC_ISR_WUTWF;
+    RTC->PRER = (127 << RTC_PRER_PREDIV_A_Pos) |
+                ((Source == RTC_Source_LSE) ? 255 : 249);
+    RTC->CR = 0;
+    RTC->WUTR = 0;
+    test_set_time(0, 0, 0, 0);
+
+    RTC_Init();
+    wakeups = 0;
+}
+
+/*
+ * The seconds keep counting across midnight, every rollover is counted once
+ * however often the time is read
+ */
+static void test_rtc_rollover(void) {
+    test_reset(RTC_Source_LSE);
+    TEST_CHECK(RTC_GetSource() == RTC_Source_LSE);
+    // A running calendar is kept
+    TEST_CHECK(!(RTC->ISR & RTC_ISR_INIT));
+    TEST_CHECK(RTC->CR & RTC_CR_BYPSHAD);
+
+    test_set_time(12, 34, 56, 255);
+    TEST_CHECK(RTC_GetSeconds() == (12 * 3600) + (34 * 60) + 56);
+
+    test_set_time(23, 59, 59, 0);
+    TEST_CHECK(RTC_GetSeconds() == 86399);
+
+    test_set_time(0, 0, 0, 255);
+    TEST_CHECK(RTC_GetSeconds() == 86400);
+    TEST_CHECK(RTC_GetSeconds() == 86400);
+
+    test_set_time(0, 0, 1, 255);
+    TEST_CHECK(RTC_GetSeconds() == 86401);
+
+    // Second day, read once in the evening as the scheduler does
+    test_set_time(18, 0, 0, 255);
+    TEST_CHECK(RTC_GetSeconds() == 86400 + (18 * 3600));
+    test_set_time(0, 0, 5, 255);
+    TEST_CHECK(RTC_GetSeconds() == (2 * 86400) + 5);
+}
+
+/*
+ * The milliseconds count SS[15:0] down from PREDIV_S and stay monotonic across
+ * the second and the day boundaries
+ */
+static void test_rtc_timing(void) {
+    uint32_t before;
+    uint32_t after;
+
+    test_reset(RTC_Source_LSE);
+
+    test_set_time(0, 0, 10, 255);
+    TEST_CHECK(RTC_GetMilliseconds() == 10000);
+    test_set_time(0, 0, 10, 127);
+    TEST_CHECK(RTC_GetMilliseconds() == 10500);
+    test_set_time(0, 0, 10, 0);
+    TEST_CHECK(RTC_GetMilliseconds() == 10996);
+
+    // Last tick of the day and first of the next one, a prescaler tick apart
+    test_set_time(23, 59, 59, 0);
+    before = RTC_GetMilliseconds();
+    test_set_time(0, 0, 0, 255);
+    after = RTC_GetMilliseconds();
+    TEST_CHECK(before == 86399996);
+    TEST_CHECK(after == 86400000);
+    TEST_CHECK((int32_t)(after - before) == 4);
+
+    // A whole day of ticks, every reading is later than the previous one
+    before = RTC_GetMilliseconds();
+    for (uint32_t second = 1; second <= 86400; second++) {
+        for (uint32_t tick = 0; tick < 4; tick++) {
+            test_set_time((second / 3600) % 24, (second / 60) % 60,
+                          second % 60, 255 - (tick * 64));
+            after = RTC_GetMilliseconds();
+            TEST_CHECK((int32_t)(after - before) > 0);
+            before = after;
+        }
+    }
+    TEST_CHECK(RTC_GetSeconds() == 2 * 86400);
+}
+
+/*
+ * The wakeup periods select the RTCCLK / 16 clock up to RTC_WAKEUP_FINE_MAX
+ * and ck_spre beyond, a single period is programmed at a time
+ */
+static void test_rtc_wakeup(void) {
+    test_reset(RTC_Source_LSE);
+
+    // 2048 Hz, rounded up
+    RTC_SetWakeupMs(100);
+    TEST_CHECK(RTC->WUTR == 204);
+    TEST_CHECK((RTC->CR & RTC_CR_WUCKSEL) == 0);
+    TEST_CHECK((RTC->CR & (RTC_CR_WUTE | RTC_CR_WUTIE)) ==
+               (RTC_CR_WUTE | RTC_CR_WUTIE));
+    TEST_CHECK(RTC->WPR == 0xFF);
+
+    RTC_SetWakeupMs(0);
+    TEST_CHECK(RTC->WUTR == 0);
+
+    RTC_SetWakeupMs(RTC_WAKEUP_FINE_MAX);
+    TEST_CHECK(RTC->WUTR == 61439);
+    TEST_CHECK((RTC->CR & RTC_CR_WUCKSEL) == 0);
+
+    // 1 Hz, rounded up to the second boundaries. Right on a boundary the
+    // first one is a second away
+    test_set_time(0, 0, 0, 255);
+    RTC_SetWakeupMs(RTC_WAKEUP_FINE_MAX + 1);
+    TEST_CHECK(RTC->WUTR == 30);
+    TEST_CHECK((RTC->CR & RTC_CR_WUCKSEL) == RTC_CR_WUCKSEL_2);
+    RTC_SetWakeupMs(60000);
+    TEST_CHECK(RTC->WUTR == 59);
+    // Half a second to the first boundary, elapses at 60.5 s
+    test_set_time(0, 0, 0, 127);
+    RTC_SetWakeupMs(60000);
+    TEST_CHECK(RTC->WUTR == 60);
+
+    RTC_SetWakeup(70000);
+    TEST_CHECK(RTC->WUTR == RTC_WAKEUP_MAX - 1);
+    RTC_SetWakeup(0);
+    TEST_CHECK(RTC->WUTR == 0);
+
+    // The interruption clears the flags and stops the timer
+    RTC->ISR |= RTC_ISR_WUTF;
+    EXTI->PR = 0;
+    RTC_WKUP_IRQHandler();
+    TEST_CHECK(wakeups == 1);
+    TEST_CHECK(!(RTC->ISR & RTC_ISR_WUTF));
+    TEST_CHECK(EXTI->PR == EXTI_PR_PR22);
+    TEST_CHECK(!(RTC->CR & (RTC_CR_WUTE | RTC_CR_WUTIE)));
+    TEST_CHECK(RTC->WPR == 0xFF);
+
+    RTC_SetWakeupMs(10);
+    RTC_StopWakeup();
+    TEST_CHECK(!(RTC->CR & (RTC_CR_WUTE | RTC_CR_WUTIE)));
+    TEST_CHECK(wakeups == 1);
+
+    // 2000 Hz, the LSI is taken as its nominal 32 kHz
+    test_reset(RTC_Source_LSI);
+    TEST_CHECK(RTC_GetSource() == RTC_Source_LSI);
+    TEST_CHECK(RCC->CSR & RCC_CSR_LSION);
+    RTC_SetWakeupMs(100);
+    TEST_CHECK(RTC->WUTR == 199);
+}
+
+/*
+ * Runs the minute ticks of the Pomodoro hour as the scheduler does (tasks.c
+ * Scheduler), the timer is started to the next minute boundary of the state.
+ * Invoked by the SWTimer API
+ *
+ * Params:
+ *    * pTimer, pointer to the minute timer
+ * Returns:
+ *    * None
+ */
+static void test_minute(SWTimer_TypeDef *pTimer) {
+    uint32_t elapsed = RTC_GetSeconds() - state_start;
+
+    minute_ticks++;
+    if (elapsed / 60 >= pomodoro[pomodoro_state]) {
+        pomodoro_state++;
+        if (pomodoro_state == sizeof(pomodoro) / sizeof(pomodoro[0])) {
+            return;
+        }
+        state_start = RTC_GetSeconds();
+        elapsed = 0;
+    }
+    SWTimer_Start(pTimer, (60 - (elapsed % 60)) * 1000);
+}
+
+/*
+ * A Pomodoro hour (focus, short rest, focus, short rest) on the timer wheel
+ * costs a single wakeup interruption per minute tick: the wakeups never
+ * elapse before the expiry
+ */
+static void test_rtc_hour(void) {
+    SWTimer_TypeDef minute = {.Callback = test_minute};
+    uint32_t interruptions = 0;
+    uint32_t start;
+
+    test_reset(RTC_Source_LSE);
+    // 12.3 s, the ticks are not aligned on the second boundaries
+    test_set_ticks((12 * 2048) + 614);
+
+    SWTimer_Init();
+    pomodoro_state = 0;
+    minute_ticks = 0;
+    state_start = RTC_GetSeconds();
+    start = state_start;
+    SWTimer_Start(&minute, 60000);
+    test_latch_wakeup();
+
+    while (wakeup_armed) {
+        test_set_ticks(wakeup_at);
+        RTC->ISR |= RTC_ISR_WUTF;
+        RTC_WKUP_IRQHandler();
+        interruptions++;
+
+        if (deferred != NULL) {
+            Defer_Callback callback = deferred;
+
+            deferred = NULL;
+            callback();
+        }
+        test_latch_wakeup();
+    }
+
+    TEST_CHECK(minute_ticks == 60);
+    TEST_CHECK(interruptions == 60);
+    // The last state ends an hour after the first one started (seconds of
+    // the calendar)
+    TEST_CHECK(RTC_GetSeconds() - start == 3600);
+}
+
+int main(void) {
+    TEST_RUN(test_rtc_rollover);
+    TEST_RUN(test_rtc_timing);
+    TEST_RUN(test_rtc_wakeup);
+    TEST_RUN(test_rtc_hour);
+
+    return TEST_RESULT;
+}
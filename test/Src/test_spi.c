@@ -0,0 +1,615 @@
+// REG_ERR and REG_EFL of the signal context, used by the timing model
+#define _GNU_SOURCE
+#include <signal.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+
+#include "stm32f429zi.h"
+#include "test.h"
+
+// Control pins of the queue on GPIOB, D/C on pin 0 and CS on pin 1
+#define TEST_DC_MASK (1U << 0)
+#define TEST_CS_MASK (1U << 1)
+
+// Data register value while no frame has been written, frames are 8-bit
+#define TEST_NO_FRAME 0xFFFFU
+
+// Frames and completed descriptors recorded, more than any test sends
+#define TEST_FRAMES 64
+#define TEST_DONE 16
+
+// Interruptions served before a run is considered stuck
+#define TEST_MAX_INTERRUPTS 256
+
+// Timing model of SPI1, in CPU cycles: an 8-bit frame at PCLK/2 and a
+// register access (load or store through the APB bridge)
+#define TEST_FRAME_CYCLES 16
+#define TEST_ACCESS_CYCLES 2
+
+// Page of the SPI1 registers, trapped by the timing model
+#define TEST_SPI_PAGE ((void *)SPI1_BASE)
+#define TEST_PAGE_SIZE 4096
+
+// Trap flag of RFLAGS, single steps the trapped access
+#define TEST_TRAP_FLAG 0x100
+
+/*
+ * Frame written in the data register and the control pins while it is sent
+ */
+typedef struct {
+    uint8_t Byte;
+    uint8_t DC;
+    uint8_t CS;
+} Test_FrameTypeDef;
+
+/*
+ * Control pins seen by the callback of a descriptor
+ */
+typedef struct {
+    uint8_t DC;
+    uint8_t CS;
+} Test_DoneTypeDef;
+
+/*
+ * Timing model of the SPI1 transmitter: the Tx buffer (data register) and the
+ * shift register. The time only goes on with the register accesses
+ */
+typedef struct {
+    uint64_t Now;       // Cycles elapsed
+    uint8_t Buffered;   // A frame waits in the Tx buffer (TXE LOW)
+    uint8_t Shifting;   // A frame is being shifted out
+    uint8_t Started;    // A frame has been shifted out already
+    uint64_t ShiftEnd;  // End of the frame being shifted out (or last one)
+    uint64_t Idle;      // Cycles the bus idles between the first and last frame
+    uint32_t Frames;    // Frames shifted out
+    uint32_t Offset;    // Register of the access being single stepped
+    uint8_t Write;      // The access being single stepped is a store
+} Test_ModelTypeDef;
+
+/* Global variables */
+TEST_MAIN_VARIABLES;
+static SPI_DriverTypeDef driver;
+static Test_FrameTypeDef frames[TEST_FRAMES];
+static uint8_t frame_count;
+static Test_DoneTypeDef done[TEST_DONE];
+static uint8_t done_count;
+static uint32_t interrupts;
+static volatile Test_ModelTypeDef model;
+
+/* Stubs of the Clock and DMA APIs, unused by the queue */
+
+uint32_t Clock_GetPCLK1(void) { return HSI_VALUE; }
+uint32_t Clock_GetPCLK2(void) { return HSI_VALUE; }
+
+DriverStatus DMA_Start(DMA_DriverTypeDef *pDMADriver, const void *pMemory,
+                       volatile void *pPeripheral, uint16_t Len) {
+    (void)pDMADriver;
+    (void)pMemory;
+    (void)pPeripheral;
+    (void)Len;
+    return ERROR;
+}
+FlagStatus DMA_GetTransferComplete(DMA_DriverTypeDef *pDMADriver) {
+    (void)pDMADriver;
+    return FLAG_LOW;
+}
+void DMA_ClearTransferComplete(DMA_DriverTypeDef *pDMADriver) {
+    (void)pDMADriver;
+}
+FlagStatus DMA_GetTransferError(DMA_DriverTypeDef *pDMADriver) {
+    (void)pDMADriver;
+    return FLAG_LOW;
+}
+void DMA_ClearTransferError(DMA_DriverTypeDef *pDMADriver) {
+    (void)pDMADriver;
+}
+FlagStatus DMA_GetEnabled(DMA_DriverTypeDef *pDMADriver) {
+    (void)pDMADriver;
+    return FLAG_LOW;
+}
+void DMA_Stop(DMA_DriverTypeDef *pDMADriver) { (void)pDMADriver; }
+
+/*
+ * Applies the last BSRR write to the output levels of GPIOB, as the port does
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+static void test_port(void) {
+    uint32_t bsrr = GPIOB->BSRR;
+
+    GPIOB->ODR = (GPIOB->ODR | (bsrr & 0xFFFF)) & ~(bsrr >> 16);
+    GPIOB->BSRR = 0;
+}
+
+/*
+ * Callback of the descriptors, records the control pins once the descriptor
+ * is sent
+ *
+ * Params:
+ *    * pContext, unused
+ * Returns:
+ *    * None
+ */
+static void test_sent(void *pContext) {
+    (void)pContext;
+
+    // CS is released before the callback, D/C of the next descriptor is
+    // driven after it
+    test_port();
+    if (done_count < TEST_DONE) {
+        done[done_count] =
+            (Test_DoneTypeDef){.DC = (GPIOB->ODR & TEST_DC_MASK) != 0,
+                               .CS = (GPIOB->ODR & TEST_CS_MASK) != 0};
+    }
+    done_count++;
+}
+
+/*
+ * Serves one TXE interruption and records the frame written, the SPIx is
+ * always idle (TXE HIGH, BSY LOW)
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+static void test_interrupt(void) {
+    // The first frame of the queue is written after D/C and CS are driven,
+    // the others before the pins change for the next descriptor
+    uint8_t loading = (driver.TxLen == 0);
+    uint32_t levels = GPIOB->ODR;
+
+    SPI1->DR = TEST_NO_FRAME;
+    SPI_IRQ_Handling(&driver);
+    interrupts++;
+
+    if (loading) {
+        test_port();
+        levels = GPIOB->ODR;
+    }
+    if ((SPI1->DR != TEST_NO_FRAME) && (frame_count < TEST_FRAMES)) {
+        frames[frame_count++] =
+            (Test_FrameTypeDef){.Byte = SPI1->DR,
+                                .DC = (levels & TEST_DC_MASK) != 0,
+                                .CS = (levels & TEST_CS_MASK) != 0};
+    }
+    test_port();
+}
+
+/*
+ * Serves the TXE interruptions while they are unmasked
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+static void test_run(void) {
+    for (uint32_t i = 0; i < TEST_MAX_INTERRUPTS; i++) {
+        if (!(SPI1->CR2 & SPI_CR2_TXEIE)) {
+            return;
+        }
+        test_interrupt();
+    }
+}
+
+/*
+ * Resets the SPIx, the control pins (CS HIGH) and the records
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+static void test_reset(void) {
+    *SPI1 = (SPI_TypeDef){.SR = SPI_SR_TXE};
+    *GPIOB = (GPIO_TypeDef){.ODR = TEST_CS_MASK};
+    driver = (SPI_DriverTypeDef){.pSPIx = SPI1,
+                                 .Config.DataFormat = SPI_DataFormat_8bit};
+    SPI_ControlPins_Init(&driver, GPIOB, TEST_DC_MASK, TEST_CS_MASK);
+    frame_count = 0;
+    done_count = 0;
+    interrupts = 0;
+}
+
+/*
+ * Checks the recorded frames against the bytes and levels expected
+ *
+ * Params:
+ *    * First, an 8 bit-wide integer with the first recorded frame to check
+ *    * pBytes, a pointer to the expected bytes
+ *    * Len, an 8 bit-wide integer with the amount of frames
+ *    * DC, the expected D/C level
+ * Returns:
+ *    * None
+ */
+static void test_frames(uint8_t First, const uint8_t *pBytes, uint8_t Len,
+                        PinLogicalLevel DC) {
+    for (uint8_t i = 0; i < Len; i++) {
+        TEST_CHECK(frames[First + i].Byte == pBytes[i]);
+        TEST_CHECK(frames[First + i].DC == DC);
+        TEST_CHECK(frames[First + i].CS == LOW);
+    }
+}
+
+/*
+ * A command then its data in one transaction, D/C changes between the
+ * descriptors while CS stays LOW
+ */
+static void test_spi_dc_change(void) {
+    static const uint8_t command[] = {0x4E, 0x4F};
+    static const uint8_t data[] = {0x01, 0x02, 0x03};
+    SPI_DescriptorTypeDef descriptors[] = {
+        {.pTxBuffer = command, .Len = sizeof(command), .DC = LOW,
+         .CS = SPI_CS_Keep, .Callback = test_sent},
+        {.pTxBuffer = data, .Len = sizeof(data), .DC = HIGH,
+         .CS = SPI_CS_Release, .Callback = test_sent},
+    };
+
+    test_reset();
+    TEST_CHECK(SPI_Queue_Push(&driver, &descriptors[0]) == OK);
+    TEST_CHECK(SPI_Queue_Push(&driver, &descriptors[1]) == OK);
+    TEST_CHECK(SPI1->CR2 & SPI_CR2_TXEIE);
+    TEST_CHECK(SPI1->CR1 & SPI_CR1_SPE);
+    test_run();
+
+    TEST_CHECK(frame_count == sizeof(command) + sizeof(data));
+    test_frames(0, command, sizeof(command), LOW);
+    test_frames(sizeof(command), data, sizeof(data), HIGH);
+    TEST_CHECK(done_count == 2);
+    TEST_CHECK(done[0].CS == LOW);
+    TEST_CHECK(done[1].CS == HIGH);
+
+    // Queue closed, the SPIx is disabled outside of a session
+    TEST_CHECK(!(SPI1->CR2 & SPI_CR2_TXEIE));
+    TEST_CHECK(!(SPI1->CR1 & SPI_CR1_SPE));
+    TEST_CHECK(SPI_Queue_IsEmpty(&driver));
+    TEST_CHECK(driver.TxState == SPI_TxState_Ready);
+}
+
+/*
+ * A descriptor that keeps CS leaves the transaction open once the queue is
+ * drained, CS goes HIGH after the last byte of the releasing one only
+ */
+static void test_spi_cs_release(void) {
+    static const uint8_t first[] = {0x10, 0x11};
+    static const uint8_t last[] = {0x20, 0x21};
+    SPI_DescriptorTypeDef keep = {.pTxBuffer = first, .Len = sizeof(first),
+                                  .DC = HIGH, .CS = SPI_CS_Keep,
+                                  .Callback = test_sent};
+    SPI_DescriptorTypeDef release = {.pTxBuffer = last, .Len = sizeof(last),
+                                     .DC = HIGH, .CS = SPI_CS_Release,
+                                     .Callback = test_sent};
+
+    test_reset();
+    SPI_Queue_Push(&driver, &keep);
+    test_run();
+    TEST_CHECK(frame_count == sizeof(first));
+    TEST_CHECK(!(GPIOB->ODR & TEST_CS_MASK));
+
+    SPI_Queue_Push(&driver, &release);
+    test_run();
+    TEST_CHECK(frame_count == sizeof(first) + sizeof(last));
+    test_frames(0, first, sizeof(first), HIGH);
+    test_frames(sizeof(first), last, sizeof(last), HIGH);
+    TEST_CHECK(done_count == 2);
+    TEST_CHECK(done[0].CS == LOW);
+    TEST_CHECK(done[1].CS == HIGH);
+    TEST_CHECK(GPIOB->ODR & TEST_CS_MASK);
+}
+
+/*
+ * Queued transactions are chained within the interruptions, one frame per
+ * TXE, CS is released and selected again between them
+ */
+static void test_spi_chaining(void) {
+    static const uint8_t a[] = {0xA0, 0xA1};
+    static const uint8_t b[] = {0xB0, 0xB1, 0xB2};
+    static const uint8_t c[] = {0xC0, 0xC1};
+    SPI_DescriptorTypeDef descriptors[] = {
+        {.pTxBuffer = a, .Len = sizeof(a), .DC = LOW, .CS = SPI_CS_Release,
+         .Callback = test_sent},
+        {.pTxBuffer = b, .Len = sizeof(b), .DC = HIGH, .CS = SPI_CS_Keep,
+         .Callback = test_sent},
+        {.pTxBuffer = c, .Len = sizeof(c), .DC = HIGH, .CS = SPI_CS_Release,
+         .Callback = test_sent},
+    };
+    SPI_DescriptorTypeDef empty = {.pTxBuffer = a, .Len = 0};
+
+    test_reset();
+    TEST_CHECK(SPI_Queue_Push(&driver, &empty) == ERROR);
+    for (uint8_t i = 0; i < 3; i++) {
+        TEST_CHECK(SPI_Queue_Push(&driver, &descriptors[i]) == OK);
+    }
+    TEST_CHECK(SPI_Queue_GetFree(&driver) == SPI_QUEUE_SIZE - 3);
+    test_run();
+
+    TEST_CHECK(frame_count == sizeof(a) + sizeof(b) + sizeof(c));
+    TEST_CHECK(interrupts == frame_count);
+    test_frames(0, a, sizeof(a), LOW);
+    test_frames(sizeof(a), b, sizeof(b), HIGH);
+    test_frames(sizeof(a) + sizeof(b), c, sizeof(c), HIGH);
+    TEST_CHECK(done_count == 3);
+    TEST_CHECK(done[0].CS == HIGH);
+    TEST_CHECK(done[1].CS == LOW);
+    TEST_CHECK(done[2].CS == HIGH);
+    TEST_CHECK(SPI_Queue_GetFree(&driver) == SPI_QUEUE_SIZE);
+
+    // A full queue refuses the push
+    for (uint8_t i = 0; i < SPI_QUEUE_SIZE; i++) {
+        TEST_CHECK(SPI_Queue_Push(&driver, &descriptors[0]) == OK);
+    }
+    TEST_CHECK(SPI_Queue_Push(&driver, &descriptors[0]) == BUSY);
+    test_run();
+    TEST_CHECK(SPI_Queue_IsEmpty(&driver));
+}
+
+/*
+ * Pushes the descriptor of its context, invoked from the interruption between
+ * the last byte of a descriptor and the close of the queue
+ *
+ * Params:
+ *    * pContext, pointer to the SPI_DescriptorTypeDef to push
+ * Returns:
+ *    * None
+ */
+static void test_push_late(void *pContext) {
+    test_sent(NULL);
+    SPI_Queue_Push(&driver, pContext);
+}
+
+/*
+ * Pushes racing the close of the queue: a push that lands before the close is
+ * chained, a push preempted by the close restores TXEIE on an empty queue and
+ * a push after the close restarts the queue
+ */
+static void test_spi_push_race(void) {
+    static const uint8_t first[] = {0x31, 0x32};
+    static const uint8_t late[] = {0x41, 0x42};
+    SPI_DescriptorTypeDef next = {.pTxBuffer = late, .Len = sizeof(late),
+                                  .DC = HIGH, .CS = SPI_CS_Release,
+                                  .Callback = test_sent};
+    SPI_DescriptorTypeDef racing = {.pTxBuffer = first, .Len = sizeof(first),
+                                    .DC = LOW, .CS = SPI_CS_Release,
+                                    .Callback = test_push_late,
+                                    .pContext = &next};
+    uint32_t cr2;
+
+    // Pushed from the interruption before the queue is found empty
+    test_reset();
+    SPI_Queue_Push(&driver, &racing);
+    test_run();
+    TEST_CHECK(frame_count == sizeof(first) + sizeof(late));
+    TEST_CHECK(interrupts == frame_count);
+    test_frames(0, first, sizeof(first), LOW);
+    test_frames(sizeof(first), late, sizeof(late), HIGH);
+    TEST_CHECK(SPI_Queue_IsEmpty(&driver));
+
+    // The push reads CR2 (TXEIE set by the transfer in progress), the
+    // interruption sends the last bytes and closes the queue, then the push
+    // writes TXEIE back. The spurious TXE sends nothing and masks TXE again
+    test_reset();
+    SPI_Queue_Push(&driver, &next);
+    cr2 = SPI1->CR2;
+    test_run();
+    SPI1->CR2 = cr2;
+    test_interrupt();
+    TEST_CHECK(frame_count == sizeof(late));
+    TEST_CHECK(!(SPI1->CR2 & SPI_CR2_TXEIE));
+    TEST_CHECK(driver.TxState == SPI_TxState_Ready);
+
+    // A push after the close starts the queue again
+    SPI_Queue_Push(&driver, &next);
+    test_run();
+    TEST_CHECK(frame_count == 2 * sizeof(late));
+    test_frames(sizeof(late), late, sizeof(late), HIGH);
+    TEST_CHECK(GPIOB->ODR & TEST_CS_MASK);
+}
+
+/*
+ * Shifts the frames out up to the current time, the buffered frame moves to
+ * the shift register as soon as the previous one ends
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+static void test_model_shift(void) {
+    while (model.Shifting && (model.ShiftEnd <= model.Now)) {
+        model.Shifting = 0;
+        model.Frames++;
+        if (model.Buffered && (SPI1->CR1 & SPI_CR1_SPE)) {
+            model.Buffered = 0;
+            model.Shifting = 1;
+            model.ShiftEnd += TEST_FRAME_CYCLES;
+        }
+    }
+}
+
+/*
+ * Writes a frame in the Tx buffer, it is shifted out at once on an idle bus.
+ * The idle time since the end of the previous frame is accounted
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+static void test_model_write(void) {
+    if (model.Shifting) {
+        model.Buffered = 1;
+        return;
+    }
+    if (model.Started) {
+        model.Idle += model.Now - model.ShiftEnd;
+    }
+    model.Started = 1;
+    model.Shifting = 1;
+    model.ShiftEnd = model.Now + TEST_FRAME_CYCLES;
+}
+
+/*
+ * Traps an access to the SPI1 registers: the time goes on, the status
+ * register is updated for a load and the access is single stepped
+ *
+ * Params:
+ *    * Signal, unused
+ *    * pInfo, a pointer to the siginfo_t with the address accessed
+ *    * pContext, a pointer to the ucontext_t of the access
+ * Returns:
+ *    * None
+ */
+static void test_model_access(int Signal, siginfo_t *pInfo, void *pContext) {
+    ucontext_t *pUContext = pContext;
+    (void)Signal;
+
+    mprotect(TEST_SPI_PAGE, TEST_PAGE_SIZE, PROT_READ | PROT_WRITE);
+    model.Offset = (uintptr_t)pInfo->si_addr - SPI1_BASE;
+    model.Write = (pUContext->uc_mcontext.gregs[REG_ERR] & 2) != 0;
+    model.Now += TEST_ACCESS_CYCLES;
+    test_model_shift();
+
+    if (!model.Write && (model.Offset == offsetof(SPI_TypeDef, SR))) {
+        uint8_t busy = model.Shifting || model.Buffered;
+        SPI1->SR = (model.Buffered ? 0 : SPI_SR_TXE) | (busy ? SPI_SR_BSY : 0);
+    }
+    pUContext->uc_mcontext.gregs[REG_EFL] |= TEST_TRAP_FLAG;
+}
+
+/*
+ * Ends a trapped access once it is single stepped: a store to the data
+ * register writes a frame, the registers are trapped again
+ *
+ * Params:
+ *    * Signal, unused
+ *    * pInfo, unused
+ *    * pContext, a pointer to the ucontext_t after the access
+ * Returns:
+ *    * None
+ */
+static void test_model_step(int Signal, siginfo_t *pInfo, void *pContext) {
+    ucontext_t *pUContext = pContext;
+    (void)Signal;
+    (void)pInfo;
+
+    pUContext->uc_mcontext.gregs[REG_EFL] &= ~TEST_TRAP_FLAG;
+    if (model.Write && (model.Offset == offsetof(SPI_TypeDef, DR))) {
+        test_model_write();
+    }
+    mprotect(TEST_SPI_PAGE, TEST_PAGE_SIZE, PROT_NONE);
+}
+
+/*
+ * Starts or stops the timing model, every access to the SPI1 registers is
+ * trapped while it runs
+ *
+ * Params:
+ *    * EnOrDi, ENABLE to reset and start the model, DISABLE to stop it
+ * Returns:
+ *    * None
+ */
+static void test_model(EnableDisable EnOrDi) {
+    struct sigaction access = {.sa_sigaction = test_model_access,
+                               .sa_flags = SA_SIGINFO};
+    struct sigaction step = {.sa_sigaction = test_model_step,
+                             .sa_flags = SA_SIGINFO};
+
+    if (EnOrDi == ENABLE) {
+        model = (Test_ModelTypeDef){0};
+        sigaction(SIGSEGV, &access, NULL);
+        sigaction(SIGTRAP, &step, NULL);
+        mprotect(TEST_SPI_PAGE, TEST_PAGE_SIZE, PROT_NONE);
+    } else {
+        mprotect(TEST_SPI_PAGE, TEST_PAGE_SIZE, PROT_READ | PROT_WRITE);
+        signal(SIGSEGV, SIG_DFL);
+        signal(SIGTRAP, SIG_DFL);
+    }
+}
+
+/*
+ * Sends three bursts of the same D/C level, within a session or not
+ *
+ * Params:
+ *    * Session, 1 to send them within a session
+ * Returns:
+ *    * None
+ */
+static void test_bursts(uint8_t Session) {
+    static const uint8_t bytes[] = {0x51, 0x52, 0x53, 0x54};
+
+    test_reset();
+    test_model(ENABLE);
+    if (Session) {
+        SPI_OpenSession(&driver);
+    }
+    for (uint8_t i = 0; i < 3; i++) {
+        SPI_SendData(&driver, bytes, sizeof(bytes));
+    }
+    if (Session) {
+        SPI_CloseSession(&driver);
+    }
+    test_model(DISABLE);
+}
+
+/*
+ * Bursts within a session keep the shift register fed, the bus never idles
+ * between them. Outside of a session every burst drains the bus and toggles
+ * SPE, which idles it before the next one
+ */
+static void test_spi_session_gap(void) {
+#if defined(__x86_64__)
+    uint64_t idle;
+
+    test_bursts(0);
+    TEST_CHECK(model.Frames == 12);
+    idle = model.Idle;
+    TEST_CHECK(idle >= 2 * 4 * TEST_ACCESS_CYCLES);
+
+    test_bursts(1);
+    TEST_CHECK(model.Frames == 12);
+    TEST_CHECK(model.Idle == 0);
+    TEST_CHECK(idle > model.Idle);
+
+    // Closed session, the bus is drained and the SPIx disabled
+    TEST_CHECK(!model.Shifting && !model.Buffered);
+    TEST_CHECK(!(SPI1->CR1 & SPI_CR1_SPE));
+    TEST_CHECK(!driver.SessionOpen);
+#endif
+}
+
+/*
+ * A flush within a session drains the bus before D/C or CS change, the SPIx
+ * stays enabled
+ */
+static void test_spi_session_flush(void) {
+#if defined(__x86_64__)
+    static const uint8_t bytes[] = {0x61, 0x62, 0x63};
+
+    test_reset();
+    test_model(ENABLE);
+    SPI_OpenSession(&driver);
+    SPI_SendData(&driver, bytes, sizeof(bytes));
+    TEST_CHECK(model.Shifting);
+    SPI_Flush(&driver);
+    TEST_CHECK(!model.Shifting && !model.Buffered);
+    TEST_CHECK(model.Frames == sizeof(bytes));
+    TEST_CHECK(SPI1->CR1 & SPI_CR1_SPE);
+    SPI_CloseSession(&driver);
+    test_model(DISABLE);
+#endif
+}
+
+int main(void) {
+    TEST_RUN(test_spi_dc_change);
+    TEST_RUN(test_spi_cs_release);
+    TEST_RUN(test_spi_chaining);
+    TEST_RUN(test_spi_push_race);
+    TEST_RUN(test_spi_session_gap);
+    TEST_RUN(test_spi_session_flush);
+
+    return TEST_RESULT;
+}
@@ -0,0 +1,273 @@
+#include "stm32f429zi.h"
+#include "test.h"
+
+// Expiries recorded per timer, more than any test expects
+#define TEST_EXPIRIES 8
+
+/*
+ * Timer under test and the RTC milliseconds of its expiries
+ */
+typedef struct {
+    SWTimer_TypeDef Timer;
+    uint32_t Expiries[TEST_EXPIRIES];
+    uint8_t Count;
+} Test_TimerTypeDef;
+
+/* Global variables */
+TEST_MAIN_VARIABLES;
+
+// Simulated RTC: current millisecond and the wakeup timer, armed while
+// wakeup_armed is set
+static uint32_t rtc_now;
+static uint32_t wakeup_at;
+static uint8_t wakeup_armed;
+
+// Deferred work posted by the wakeup callback and the wakeups served
+static Defer_Callback deferred;
+static uint32_t wakeups;
+
+// Start of the state timed by test_minute (RTC milliseconds)
+static uint32_t state_start;
+
+/* Stubs of the RTC and Defer APIs */
+
+uint32_t RTC_GetMilliseconds(void) { return rtc_now; }
+
+void RTC_SetWakeupMs(uint32_t Milliseconds) {
+    wakeup_at = rtc_now + Milliseconds;
+    wakeup_armed = 1;
+}
+
+void RTC_StopWakeup(void) { wakeup_armed = 0; }
+
+DriverStatus Defer_Post(Defer_Callback Callback) {
+    deferred = Callback;
+    return OK;
+}
+
+/*
+ * Records the expiry of a timer
+ *
+ * Params:
+ *    * pTimer, pointer to the SWTimer_TypeDef of a Test_TimerTypeDef
+ * Returns:
+ *    * None
+ */
+static void test_expired(SWTimer_TypeDef *pTimer) {
+    Test_TimerTypeDef *pTest = (Test_TimerTypeDef *)pTimer;
+
+    if (pTest->Count < TEST_EXPIRIES) {
+        pTest->Expiries[pTest->Count] = rtc_now;
+    }
+    pTest->Count++;
+}
+
+/*
+ * Resets the simulated RTC to a time and empties the wheel
+ *
+ * Params:
+ *    * Now, a 32 bit-wide integer with the RTC milliseconds
+ * Returns:
+ *    * None
+ */
+static void test_reset(uint32_t Now) {
+    rtc_now = Now;
+    wakeup_armed = 0;
+    wakeups = 0;
+    SWTimer_Init();
+}
+
+/*
+ * Runs the simulated time up to a millisecond, every wakeup of the RTC defers
+ * the wheel processing as the firmware does
+ *
+ * Params:
+ *    * Until, a 32 bit-wide integer with the RTC milliseconds to reach
+ * Returns:
+ *    * None
+ */
+static void test_advance(uint32_t Until) {
+    while (wakeup_armed && ((int32_t)(Until - wakeup_at) >= 0)) {
+        rtc_now = wakeup_at;
+        wakeup_armed = 0;
+        wakeups++;
+
+        deferred = NULL;
+        RTC_CallbackWakeup();
+        if (deferred != NULL) {
+            deferred();
+        }
+    }
+    rtc_now = Until;
+}
+
+/*
+ * Timers placed on both sides of the level boundaries (64, 64^2 and 64^3 ms)
+ * expire at their exact millisecond, once cascaded down to level 0
+ */
+static void test_swtimer_cascade(void) {
+    static const uint32_t delays[] = {1,    63,   64,     65,     127,
+                                      4095, 4096, 4097,   262143, 262144,
+                                      262145, 300000, 16777215};
+    static Test_TimerTypeDef timers[sizeof(delays) / sizeof(delays[0])];
+    uint32_t start = 4000;
+
+    // The start is close to a level 2 boundary, the first cascades happen
+    // early
+    test_reset(start);
+    for (uint8_t i = 0; i < sizeof(delays) / sizeof(delays[0]); i++) {
+        timers[i] = (Test_TimerTypeDef){.Timer = {.Callback = test_expired}};
+        SWTimer_Start(&timers[i].Timer, delays[i]);
+    }
+
+    test_advance(start + 16777216);
+    for (uint8_t i = 0; i < sizeof(delays) / sizeof(delays[0]); i++) {
+        TEST_CHECK(timers[i].Count == 1);
+        TEST_CHECK(timers[i].Expiries[0] == start + delays[i]);
+        TEST_CHECK(!SWTimer_IsActive(&timers[i].Timer));
+    }
+    TEST_CHECK(!wakeup_armed);
+}
+
+/*
+ * An active timer restarted expires from the restart on, a stopped one never
+ * expires. A periodic timer keeps its period
+ */
+static void test_swtimer_restart_stop(void) {
+    Test_TimerTypeDef restarted = {.Timer = {.Callback = test_expired}};
+    Test_TimerTypeDef stopped = {.Timer = {.Callback = test_expired}};
+    Test_TimerTypeDef periodic = {
+        .Timer = {.Callback = test_expired, .Period = 100}};
+
+    test_reset(0);
+    SWTimer_Start(&restarted.Timer, 100);
+    SWTimer_Start(&stopped.Timer, 5000);
+    SWTimer_Start(&periodic.Timer, 100);
+
+    test_advance(50);
+    TEST_CHECK(SWTimer_IsActive(&restarted.Timer));
+    SWTimer_Start(&restarted.Timer, 100);
+    SWTimer_Stop(&stopped.Timer);
+    TEST_CHECK(!SWTimer_IsActive(&stopped.Timer));
+    // Stopping an inactive timer does nothing
+    SWTimer_Stop(&stopped.Timer);
+
+    test_advance(349);
+    TEST_CHECK(restarted.Count == 1);
+    TEST_CHECK(restarted.Expiries[0] == 150);
+    TEST_CHECK(periodic.Count == 3);
+    TEST_CHECK(periodic.Expiries[0] == 100);
+    TEST_CHECK(periodic.Expiries[1] == 200);
+    TEST_CHECK(periodic.Expiries[2] == 300);
+
+    // Restarted on expiry
+    SWTimer_Start(&restarted.Timer, 1000);
+    SWTimer_Stop(&periodic.Timer);
+
+    test_advance(10000);
+    TEST_CHECK(restarted.Count == 2);
+    TEST_CHECK(restarted.Expiries[1] == 1349);
+    TEST_CHECK(periodic.Count == 3);
+    TEST_CHECK(stopped.Count == 0);
+    TEST_CHECK(!wakeup_armed);
+}
+
+/*
+ * The RTC milliseconds wrap around 2^32 (~49.7 days), the expiries are
+ * compared modulo 2^32
+ */
+static void test_swtimer_wrap(void) {
+    Test_TimerTypeDef oneshot = {.Timer = {.Callback = test_expired}};
+    Test_TimerTypeDef periodic = {
+        .Timer = {.Callback = test_expired, .Period = 300}};
+    uint32_t start = 0xFFFFFF00U;
+
+    test_reset(start);
+    SWTimer_Start(&oneshot.Timer, 0x200);
+    SWTimer_Start(&periodic.Timer, 300);
+
+    test_advance(start + 0x1000);
+    TEST_CHECK(oneshot.Count == 1);
+    TEST_CHECK(oneshot.Expiries[0] == 0x100);
+    TEST_CHECK(periodic.Count >= 3);
+    TEST_CHECK(periodic.Expiries[0] == start + 300);
+    TEST_CHECK(periodic.Expiries[1] == start + 600);
+    TEST_CHECK(periodic.Expiries[2] == start + 900);
+}
+
+/*
+ * A long timer is reached in a few wakeups, the empty slots are skipped. A
+ * wheel left empty for hours restarts from the current time, the next timer
+ * needs a single wakeup
+ */
+static void test_swtimer_long_jump(void) {
+    Test_TimerTypeDef hour = {.Timer = {.Callback = test_expired}};
+    Test_TimerTypeDef beyond = {.Timer = {.Callback = test_expired}};
+    Test_TimerTypeDef later = {.Timer = {.Callback = test_expired}};
+
+    test_reset(123);
+    SWTimer_Start(&hour.Timer, 3600000);
+    // Beyond the span of the wheel (64^4 ms), cascaded again
+    SWTimer_Start(&beyond.Timer, 20000000);
+
+    test_advance(123 + 20000000);
+    TEST_CHECK(hour.Count == 1);
+    TEST_CHECK(hour.Expiries[0] == 123 + 3600000);
+    TEST_CHECK(beyond.Count == 1);
+    TEST_CHECK(beyond.Expiries[0] == 123 + 20000000);
+    TEST_CHECK(wakeups <= 2 * 4 * SWTIMER_LEVELS);
+
+    // Ten hours without any timer (the wakeup timer is stopped)
+    TEST_CHECK(!wakeup_armed);
+    test_advance(123 + 20000000 + 36000000);
+    wakeups = 0;
+    SWTimer_Start(&later.Timer, 10);
+    test_advance(rtc_now + 1000);
+    TEST_CHECK(later.Count == 1);
+    TEST_CHECK(later.Expiries[0] == 123 + 20000000 + 36000000 + 10);
+    TEST_CHECK(wakeups == 1);
+}
+
+/*
+ * Restarts the timer to the next minute boundary of the state, as the
+ * scheduler does (tasks.c schedule_wakeup)
+ *
+ * Params:
+ *    * pTimer, pointer to the SWTimer_TypeDef of a Test_TimerTypeDef
+ * Returns:
+ *    * None
+ */
+static void test_minute(SWTimer_TypeDef *pTimer) {
+    uint32_t elapsed = (rtc_now - state_start) / 1000;
+
+    test_expired(pTimer);
+    SWTimer_Start(pTimer, (60 - (elapsed % 60)) * 1000);
+}
+
+/*
+ * A Pomodoro hour of minute ticks costs a single wakeup per tick, the slots of
+ * the higher levels crossed meanwhile are cascaded without waking up the MCU
+ */
+static void test_swtimer_hour(void) {
+    uint32_t start = 123457;
+    Test_TimerTypeDef minute = {.Timer = {.Callback = test_minute}};
+
+    test_reset(start);
+    state_start = start;
+    SWTimer_Start(&minute.Timer, 60000);
+
+    test_advance(start + 3600000);
+    TEST_CHECK(minute.Count == 60);
+    TEST_CHECK(minute.Expiries[0] == start + 60000);
+    TEST_CHECK(wakeups == 60);
+}
+
+int main(void) {
+    TEST_RUN(test_swtimer_cascade);
+    TEST_RUN(test_swtimer_restart_stop);
+    TEST_RUN(test_swtimer_wrap);
+    TEST_RUN(test_swtimer_long_jump);
+    TEST_RUN(test_swtimer_hour);
+
+    return TEST_RESULT;
+}
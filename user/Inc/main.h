@@ -1,6 +1,7 @@
 #include "stm32f429zi.h"
 #include "einkPaper_2_13.h"
 #include "Image.h"
+#include "button.h"
 #include "tasks.h"
 
 
@@ -6,12 +6,34 @@
 /* Extern variables defined in other files */
 
 // Array representation of the images for every state
-extern uint8_t focus_monkey[];
-extern uint8_t beer_monkey[];
-extern uint8_t sleeping_monkey[];
-extern uint8_t empty_tamagotchi[];
+extern const uint8_t focus_monkey[];
+extern const uint8_t beer_monkey[];
+extern const uint8_t sleeping_monkey[];
+extern const uint8_t empty_tamagotchi[];
 // Pointer to the array image that will be displayed
-extern uint8_t *current_tamagotchi;
+extern const uint8_t *current_tamagotchi;
+
+/* Exported macros */
+
+// Marks a valid Scheduler_ContextTypeDef in the backup SRAM
+#define SCHEDULER_CONTEXT_MAGIC 0x504F4D4F
+
+// Priorities of the tasks (Defer API), 0 is the highest
+#define TASKS_PRIORITY_BUTTON 0       // Debounce and gestures (pause, skip, power on/off), runs before any pending update
+#define TASKS_PRIORITY_STATE 1        // Minute tick and state switches, draw the frame
+#define TASKS_PRIORITY_DISPLAY 2      // Display commit, a single update for every frame drawn meanwhile
+
+// Events signaled to the tasks
+#define TASKS_EVENT_EDGE (1 << 0)     // Button task: an edge of the built-in button was queued
+#define TASKS_EVENT_CLICK (1 << 1)    // Button task: short press, pauses/resumes the state
+#define TASKS_EVENT_DOUBLE (1 << 2)   // Button task: double press, skips to the next state
+#define TASKS_EVENT_HOLD (1 << 3)     // Button task: long press, powers the device off
+#define TASKS_EVENT_MINUTE (1 << 0)   // Tick task: a minute boundary of the state elapsed
+#define TASKS_EVENT_ENTER (1 << 0)    // Focus task: the focus state starts
+#define TASKS_EVENT_SHORT (1 << 0)    // Rest task: a short rest starts
+#define TASKS_EVENT_LONG (1 << 1)     // Rest task: a long rest starts
+#define TASKS_EVENT_COMMIT (1 << 0)   // Display task: the frame changed
+#define TASKS_EVENT_PROGRESS (1 << 1) // Display task: an update can go on (DMA stream, Busy pin, timer)
 
 /* Exported TypeDefs */
 
@@ -43,6 +65,22 @@ typedef struct{
   uint8_t cycles;                     // Gets track of the current amount of cycles, used to decide betweeen states when scheduled
 } Scheduler_TypeDef;
 
+/*
+ * Pomodoro state saved in the backup SRAM when the device is powered off, resumed by the next power on (also after
+ * a Standby mode wakeup)
+ */
+typedef struct{
+  uint32_t Magic;                     // SCHEDULER_CONTEXT_MAGIC when the context is valid
+  Scheduler_State State;              // State running when the device was powered off, values can be of Scheduler_State
+  uint8_t cycles;                     // Cycles of the scheduler when the device was powered off
+  uint32_t elapsed;                   // Seconds of the state elapsed when the device was powered off
+} Scheduler_ContextTypeDef;
+
+
+/*
+ * Edges of the built-in button (time and level), passed from the EXTI interruption to the button task
+ */
+RING_DEFINE(Tasks_EdgeRing, Button_EdgeTypeDef, 8)
 
 /* Exported functions */
 
@@ -58,5 +96,9 @@ void tasks_Init(void);
 void Start_Scheduler(void);
 void Scheduler(void);
 
+// Frequency policy functions
+void tasks_SetProfile(Clock_Profile Profile);
+uint32_t tasks_GetProfileTime(Clock_Profile Profile);
+
 
 #endif
@@ -1,19 +1,55 @@
 #include "it.h"
 
 /*
- * Vector table entry that handles EXTI lines (10..15), used fot built-in button
+ * Vector table entry that handles SPI1 interruption, serves the transaction
+ * queue of the main display
  *
  * Params:
  *    * None
  * Returns:
  *    * None
  */
+__ramfunc void SPI1_IRQHandler(void) {
+    SPI_IRQ_Handling(&epaper.SPIDriver);
+}
+
+/*
+ * Vector table entry that handles DMA2 stream 3 interruption, chains the
+ * segments of the frames streamed to the main display and signals their end
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+void DMA2_Stream3_IRQHandler(void) {
+    eInkDisplay_DMA_IRQHandling(&epaper);
+}
+
+#ifdef EINK_STATUS_DISPLAY
+/*
+ * Vector table entry that handles SPI2 interruption, serves the transaction
+ * queue of the status display
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+__ramfunc void SPI2_IRQHandler(void) {
+    SPI_IRQ_Handling(&epaper_status.SPIDriver);
+}
 
-void EXTI15_10_IRQHandler(void) {
-    // Software debouncer, avoid multiple IRQ triggering
-    for (volatile uint32_t i = 0; i < 500000; i++) {
-        ;
-    }
-    // GPIO API handler
-    GPIO_IRQ_Handling(13);
+/*
+ * Vector table entry that handles DMA1 stream 4 interruption, chains the
+ * segments of the frames streamed to the status display and signals their end
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+void DMA1_Stream4_IRQHandler(void) {
+    eInkDisplay_DMA_IRQHandling(&epaper_status);
 }
+#endif
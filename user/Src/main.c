@@ -5,13 +5,19 @@ void GPIO_initialization(void);
 
 int main(void) {
     System_Init();
-    eInkDisplay_Init();
+    eInkDisplay_Init(&epaper);
+#ifdef EINK_STATUS_DISPLAY
+    eInkDisplay_Init(&epaper_status);
+#endif
     Start_Scheduler();
 
     Test();
 
+    // The scheduler runs from the RTC wakeup and button interruptions, the
+    // MCU sleeps on exit of them and only returns here while the displays
+    // lock every power mode
     while (1) {
-    ;
+        task_Idle();
     }
 
     return 0;
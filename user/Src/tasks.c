@@ -2,9 +2,10 @@
 
 /* Global variables */
 
-// Type structure variables
+// Type structure variables. The scheduler is only accessed by the tasks, run
+// one at a time by the PendSV exception, it needs no locking
 Scheduler_TypeDef scheduler;
-GPIO_DriverTypeDef scheduler_button;
+Button_TypeDef scheduler_button;
 
 // Time of each Pomogotchi technique state
 uint8_t focus_time = 25;
@@ -16,20 +17,73 @@ uint8_t amount_of_cycles = 3;
 // triggering)
 volatile uint8_t poweredOff = 0;
 
+// Time spent in every clock profile (ms, RTC) and start of the current one
+static uint32_t profile_ms[Clock_Profile_Count];
+static uint32_t profile_since;
+
+// Start of the current state (RTC seconds)
+static uint32_t state_start;
+
+// Set while the state is paused by a short press, the seconds of the state
+// elapsed until then are kept
+static uint8_t paused;
+static uint32_t paused_elapsed;
+
+// State kept while the device is powered off, survives Standby mode
+static __bkpsram Scheduler_ContextTypeDef context;
+
+// Minute boundaries of the current state, the scheduler runs on its expiry
+static SWTimer_TypeDef scheduler_timer;
+
+// Edges of the button not debounced yet, the EXTI interruption is the only
+// producer and the button task the only consumer
+static Tasks_EdgeRing_TypeDef button_edges;
+
+// Tasks run by the PendSV exception, the interruptions only signal them
+static Defer_TaskTypeDef button_task;
+static Defer_TaskTypeDef tick_task;
+static Defer_TaskTypeDef focus_task;
+static Defer_TaskTypeDef rest_task;
+static Defer_TaskTypeDef display_task;
+
+// Protothread of the display task and the frame commit it waits for, set
+// whenever a frame is drawn
+static PT_TypeDef display_thread;
+static uint8_t display_commit;
+
 /* Static functions */
 
 static void switch_task(void);
+static void scheduler_expired(SWTimer_TypeDef *pTimer);
+static void run_tick(uint32_t Events);
+static void run_focus(uint32_t Events);
+static void run_rest(uint32_t Events);
+static void run_display(uint32_t Events);
+static DriverStatus display_show(void);
+static void schedule_wakeup(void);
+static uint32_t next_wakeup(void);
+static uint32_t idle_deadline(void);
+static uint32_t state_elapsed(void);
+static void resume_task(void);
+static void restore_state(Scheduler_State State, uint8_t Cycles,
+                          uint32_t Elapsed);
 static void GPIO_buttonInit(void);
-static void task_Button(void);
+static void button_IRQTrigger(uint8_t PinNumber, void *pContext);
+static void task_Button(uint32_t Events);
+static void toggle_pause(void);
+static void skip_state(void);
+static void toggle_power(void);
 
 /* Function implementations */
 
 /*
- * The scheduler is invoked every second by the Timer 6 interruption. It handles
- * the following:
+ * The scheduler is invoked by the RTC wakeup interruption at every minute
+ * boundary of the current state (state ends are minute boundaries too). It
+ * handles the following:
  *    * Switching the task whenever the time of the current state is met.
  *    * Whenever a minute elapses, display the current time left.
- *    * Invoke the idle state when there is no display updating operations.
+ *    * Start the timer of the next minute boundary, the MCU stays in Stop
+ * mode until then (task_Idle).
  *
  * Params:
  *    * None
@@ -37,28 +91,41 @@ static void task_Button(void);
  *    * None
  */
 void Scheduler(void) {
+    uint32_t elapsed = RTC_GetSeconds() - state_start;
 
-    // Switch the task when the time of the current state has elapsed
-    if (scheduler.minutes_to_elapse == global_seconds / 60) {
+    // Switch the task when the time of the current state has elapsed, the
+    // next state task displays the time left and starts the timer again. A
+    // tick dropped while paused leaves the state past its end
+    if (elapsed / 60 >= scheduler.minutes_to_elapse) {
         // handler that switches the next task based on a state machine
         switch_task();
+        return;
     }
-    // Check if a minute has elapsed, not exclusive of the task switching in
-    // order to display the time left after swithing to the next state
-    if (global_seconds % 60 == 0) {
-        uint16_t minutes_left =
-            scheduler.minutes_to_elapse - (global_seconds / 60);
+    // Check if a minute has elapsed
+    if (elapsed % 60 == 0) {
+        uint16_t minutes_left = scheduler.minutes_to_elapse - (elapsed / 60);
         task_MinuteElapsed(minutes_left);
     }
-    if (scheduler.Availability == Available) {
-        task_Idle();
-    }
+    schedule_wakeup();
+}
+
+/*
+ * Signals the tick task whenever the scheduler timer expires. Invoked by the
+ * SWTimer API
+ *
+ * Params:
+ *    * pTimer, pointer to the scheduler timer
+ * Returns:
+ *    * None
+ */
+static void scheduler_expired(SWTimer_TypeDef *pTimer) {
+    Defer_Signal(&tick_task, TASKS_EVENT_MINUTE);
 }
 
 /*
  * Initialazes the built-in button that triggers a new task and switches On/Off
- * the device. Enables the Timer to trigger the strigger the scheduler and
- * invokes the first required tasks. Invoked from main function after hardware
+ * the device. Starts the timer that triggers the scheduler and invokes the
+ * first required tasks. Invoked from main function after hardware
  * intitializations.
  *
  * Params:
@@ -67,10 +134,88 @@ void Scheduler(void) {
  *    * None
  */
 void Start_Scheduler(void) {
+    button_task = (Defer_TaskTypeDef){.pName = "button",
+                                      .Handler = task_Button,
+                                      .Priority = TASKS_PRIORITY_BUTTON};
+    tick_task = (Defer_TaskTypeDef){.pName = "tick",
+                                    .Handler = run_tick,
+                                    .Priority = TASKS_PRIORITY_STATE};
+    focus_task = (Defer_TaskTypeDef){.pName = "focus",
+                                     .Handler = run_focus,
+                                     .Priority = TASKS_PRIORITY_STATE};
+    rest_task = (Defer_TaskTypeDef){.pName = "rest",
+                                    .Handler = run_rest,
+                                    .Priority = TASKS_PRIORITY_STATE};
+    display_task = (Defer_TaskTypeDef){.pName = "display",
+                                       .Handler = run_display,
+                                       .Priority = TASKS_PRIORITY_DISPLAY};
+    scheduler_timer.Callback = scheduler_expired;
+
     GPIO_buttonInit();
-    Timer_Enable();
-    task_Focus();
-    task_MinuteElapsed(focus_time);
+    profile_since = RTC_GetMilliseconds();
+
+    // Powered on by the button from Standby mode, the saved state goes on.
+    // Any other reset starts over
+    if (Power_WokeFromStandby()) {
+        resume_task();
+    } else {
+        task_Focus();
+        task_MinuteElapsed(focus_time);
+    }
+    schedule_wakeup();
+}
+
+/*
+ * Frequency policy: the clock is boosted (Render profile) while the frame is
+ * composed and streamed to the displays, and lowered (Idle profile) during the
+ * refresh of the displays and between tasks (Stop mode included). The time
+ * spent in the profile being left is accounted
+ *
+ * Params:
+ *    * Profile, the profile to switch to, values can be of Clock_Profile
+ * Returns:
+ *    * None
+ */
+void tasks_SetProfile(Clock_Profile Profile) {
+    uint32_t now = RTC_GetMilliseconds();
+
+    profile_ms[Clock_GetProfile()] += now - profile_since;
+    profile_since = now;
+
+    if (Profile != Clock_GetProfile()) {
+        Clock_SetProfile(Profile);
+    }
+}
+
+/*
+ * Returns the time spent in a clock profile since the scheduler started
+ *
+ * Params:
+ *    * Profile, values can be of Clock_Profile
+ * Returns:
+ *    * time, a 32 bit-wide integer with the milliseconds spent in the profile
+ */
+uint32_t tasks_GetProfileTime(Clock_Profile Profile) {
+    uint32_t ms = profile_ms[Profile];
+
+    // The current profile is accounted up to now
+    if (Profile == Clock_GetProfile()) {
+        ms += RTC_GetMilliseconds() - profile_since;
+    }
+    return ms;
+}
+
+/*
+ * Lowers the clock once the frames are in the display RAM, the refresh only
+ * waits on the Busy pin. Invoked by the bsp e-ink layer
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+void eInkDisplay_CallbackRefreshing(void) {
+    tasks_SetProfile(Clock_Profile_Idle);
 }
 
 /*
@@ -85,8 +230,8 @@ void Start_Scheduler(void) {
 void task_Focus(void) {
     current_tamagotchi = focus_monkey;
 
-    // Resetting global seconds variable to start over the count
-    global_seconds = 0;
+    // Start over the count of the state
+    state_start = RTC_GetSeconds();
 
     // Setting the current state and the time to elapse
     scheduler.State = State_Focus;
@@ -95,17 +240,11 @@ void task_Focus(void) {
     // Updates the amount of cycles, used to know whenever a long rest is next
     scheduler.cycles++;
 
-    // Avoid to call the Idle task
-    scheduler.Availability = NotAvailable;
-
-    // Display operations
+    // Draw the frame, the display task commits it
     Image_clearStrings();
     Image_clearMinutesLeft();
     Image_drawString((uint8_t *)" FOCUS\0");
-    Image_displayImage();
-
-    // Release the CPU
-    scheduler.Availability = Available;
+    Defer_Signal(&display_task, TASKS_EVENT_COMMIT);
 }
 
 /*
@@ -120,25 +259,19 @@ void task_Focus(void) {
 void task_ShortRest(void) {
     current_tamagotchi = beer_monkey;
 
-    // Resetting global seconds variable to start over the count
-    global_seconds = 0;
+    // Start over the count of the state
+    state_start = RTC_GetSeconds();
 
     // Setting the current state and the time to elapse
     scheduler.State = State_ShortRest;
     scheduler.minutes_to_elapse = short_rest_time;
 
-    // Avoid to call the Idle task
-    scheduler.Availability = NotAvailable;
-
-    // Display operations
+    // Draw the frame, the display task commits it
     Image_clearStrings();
     Image_clearMinutesLeft();
     Image_drawString((uint8_t *)" SHORT\0");
     Image_drawString((uint8_t *)"  REST\0");
-    Image_displayImage();
-
-    // Release the CPU
-    scheduler.Availability = Available;
+    Defer_Signal(&display_task, TASKS_EVENT_COMMIT);
 }
 
 /*
@@ -153,8 +286,8 @@ void task_ShortRest(void) {
 void task_LongRest(void) {
     current_tamagotchi = sleeping_monkey;
 
-    // Resetting global seconds variable to start over the count
-    global_seconds = 0;
+    // Start over the count of the state
+    state_start = RTC_GetSeconds();
 
     // Setting the current state and the time to elapse
     scheduler.State = State_LongRest;
@@ -163,18 +296,12 @@ void task_LongRest(void) {
     // Reset the cycles variable to run again short rests
     scheduler.cycles = 0;
 
-    // Avoid to call the Idle task
-    scheduler.Availability = NotAvailable;
-
-    // Display operations
+    // Draw the frame, the display task commits it
     Image_clearStrings();
     Image_clearMinutesLeft();
     Image_drawString((uint8_t *)" LONG\0");
     Image_drawString((uint8_t *)"  REST\0");
-    Image_displayImage();
-
-    // Release the CPU
-    scheduler.Availability = Available;
+    Defer_Signal(&display_task, TASKS_EVENT_COMMIT);
 }
 /*
  * Displays the minutes elapsed on the screen.
@@ -187,13 +314,152 @@ void task_LongRest(void) {
 void task_MinuteElapsed(uint16_t minutes_left) {
     // Clear the previous minutes displayed
     Image_clearMinutesLeft();
-    // Draw on the image array the minutes left sent by the scheduler
+    // Draw on the image array the minutes left sent by the scheduler, the
+    // display task commits it
     Image_drawMinutesLeft(minutes_left);
-    Image_displayImage();
+    Defer_Signal(&display_task, TASKS_EVENT_COMMIT);
+}
+
+/*
+ * Runs the scheduler on every minute boundary of the state. Tick task handler
+ *
+ * Params:
+ *    * Events, TASKS_EVENT_MINUTE
+ * Returns:
+ *    * None
+ */
+static void run_tick(uint32_t Events) {
+    // A tick signaled before the pause is dropped, the state is frozen
+    if (paused) {
+        return;
+    }
+    Scheduler();
+}
+
+/*
+ * Starts the focus state, its whole time is left. Focus task handler
+ *
+ * Params:
+ *    * Events, TASKS_EVENT_ENTER
+ * Returns:
+ *    * None
+ */
+static void run_focus(uint32_t Events) {
+    task_Focus();
+    task_MinuteElapsed(scheduler.minutes_to_elapse);
+    schedule_wakeup();
+}
+
+/*
+ * Starts a short or a long rest, its whole time is left. Rest task handler
+ *
+ * Params:
+ *    * Events, TASKS_EVENT_SHORT or TASKS_EVENT_LONG
+ * Returns:
+ *    * None
+ */
+static void run_rest(uint32_t Events) {
+    if (Events & TASKS_EVENT_LONG) {
+        task_LongRest();
+    } else {
+        task_ShortRest();
+    }
+    task_MinuteElapsed(scheduler.minutes_to_elapse);
+    schedule_wakeup();
+}
+
+/*
+ * Sends the frame to the displays, every frame drawn since the last commit is
+ * shown by a single update. The task never waits for the displays, it goes on
+ * whenever they signal their progress. Display task handler
+ *
+ * Params:
+ *    * Events, TASKS_EVENT_COMMIT or TASKS_EVENT_PROGRESS
+ * Returns:
+ *    * None
+ */
+static void run_display(uint32_t Events) {
+    if (Events & TASKS_EVENT_COMMIT) {
+        display_commit = 1;
+    }
+    display_show();
 }
 
 /*
- * Invokes the WFE (Wait For Event) instruction, which is a CPU instruction.
+ * Protothread of the display task, shows the frames drawn until no commit is
+ * left. Once powered off, the bye frame is followed by a blank frame and the
+ * displays are put to sleep. Every wait ends with the progress of the displays
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * DriverStatus, BUSY while an update is in progress, OK once the displays
+ * are idle
+ */
+static DriverStatus display_show(void) {
+    PT_TypeDef *pPt = &display_thread;
+
+    PT_BEGIN(pPt);
+
+    while (display_commit) {
+        // Every frame drawn until here is shown by this update, the frames
+        // drawn meanwhile by the next one
+        display_commit = 0;
+
+        // Avoid to call the Idle task
+        scheduler.Availability = NotAvailable;
+
+        // Display operations, the clock is lowered once the frame is sent
+        // (eInkDisplay_CallbackRefreshing)
+        tasks_SetProfile(Clock_Profile_Render);
+        Image_displayImage();
+        PT_WAIT_UNTIL(pPt, Image_processImage() == OK);
+
+        if (poweredOff) {
+            // The bye frame is cleared, the tamagotchi is already empty
+            Image_clearStrings();
+            Image_clearMinutesLeft();
+            tasks_SetProfile(Clock_Profile_Render);
+            Image_displayImage();
+            PT_WAIT_UNTIL(pPt, Image_processImage() == OK);
+
+            // The displays keep the image while sleeping, they are woken up by
+            // the next update
+            Image_sleepDisplays();
+        }
+    }
+
+    // Release the CPU
+    tasks_SetProfile(Clock_Profile_Idle);
+    scheduler.Availability = Available;
+
+    PT_END(pPt);
+}
+
+/*
+ * Signals the display task whenever an update can go on. Invoked by the bsp
+ * e-ink layer, from the DMA stream and EXTI interruptions too (Defer_Signal is
+ * lock-free)
+ *
+ * Params:
+ *    * pDisplay, pointer to the EinkPaper_TypeDef of the display
+ * Returns:
+ *    * None
+ */
+void eInkDisplay_CallbackProgress(EinkPaper_TypeDef *pDisplay) {
+    Defer_Signal(&display_task, TASKS_EVENT_PROGRESS);
+}
+
+/*
+ * Hands the MCU over to the interruptions once the scheduler has started. The
+ * tasks run from the PendSV handler (signaled by the RTC wakeup and the button
+ * interruptions) and the core sleeps on exit of the last interruption, thread
+ * mode is only resumed while every power mode is locked. Invoked from the main
+ * loop:
+ *    * Running: Stop mode, the RTC wakeup (next minute boundary) or the button
+ * interruption wakes the MCU.
+ *    * Powered off: Standby mode, the button resets the MCU and the saved state
+ * is resumed.
  *
  * Params:
  *    * None
@@ -201,60 +467,177 @@ void task_MinuteElapsed(uint16_t minutes_left) {
  *    * None
  */
 void task_Idle(void) {
-    // Using macro defined in cmsis_gcc header file.
-    __WFE();
+    if (scheduler.Availability != Available) {
+        return;
+    }
+
+    if (Power_SleepOnExit(idle_deadline()) != Power_Mode_Run) {
+        __WFI();
+    }
+}
+
+/*
+ * Sets the power mode entered on exit of the interruptions once the deferred
+ * tasks have run, the displays may have locked or released a mode and the
+ * deadline has moved. Invoked by the Defer API
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+void Defer_CallbackQueueEmpty(void) { Power_SleepOnExit(idle_deadline()); }
+
+/*
+ * Handles the built-in button. The edges queued by the interruption are
+ * debounced, the gestures recognized meanwhile drive the device:
+ *    * Short press: pauses/resumes the current state.
+ *    * Double press: skips to the next state.
+ *    * Long press: powers the device off. Any gesture powers it on again.
+ * Button task handler
+ *
+ * Params:
+ *    * Events, TASKS_EVENT_EDGE, TASKS_EVENT_CLICK, TASKS_EVENT_DOUBLE or
+ * TASKS_EVENT_HOLD
+ * Returns:
+ *    * None
+ */
+static void task_Button(uint32_t Events) {
+    Button_EdgeTypeDef edge;
+
+    while (Tasks_EdgeRing_Pop(&button_edges, &edge) == OK) {
+        Button_Edge(&scheduler_button, &edge);
+    }
+
+    if (!(Events & (TASKS_EVENT_CLICK | TASKS_EVENT_DOUBLE |
+                    TASKS_EVENT_HOLD))) {
+        return;
+    }
+
+    if (poweredOff || (Events & TASKS_EVENT_HOLD)) {
+        toggle_power();
+    } else if (Events & TASKS_EVENT_DOUBLE) {
+        skip_state();
+    } else {
+        toggle_pause();
+    }
+}
+
+/*
+ * Signals the gestures of the built-in button to the button task. Invoked by
+ * the Button API
+ *
+ * Params:
+ *    * pButton, pointer to the built-in Button_TypeDef
+ *    * Gesture, the recognized gesture, values can be of Button_Gesture
+ * Returns:
+ *    * None
+ */
+void Button_CallbackGesture(Button_TypeDef *pButton, Button_Gesture Gesture) {
+    static const uint32_t events[] = {
+        [Button_Gesture_Short] = TASKS_EVENT_CLICK,
+        [Button_Gesture_Double] = TASKS_EVENT_DOUBLE,
+        [Button_Gesture_Long] = TASKS_EVENT_HOLD,
+    };
+
+    Defer_Signal(&button_task, events[Gesture]);
+}
+
+/*
+ * Pauses the current state, or resumes it where it was paused. The scheduler
+ * timer is stopped meanwhile
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+static void toggle_pause(void) {
+    if (paused) {
+        paused = 0;
+        restore_state(scheduler.State, scheduler.cycles, paused_elapsed);
+        schedule_wakeup();
+        return;
+    }
+
+    paused_elapsed = state_elapsed();
+    paused = 1;
+    SWTimer_Stop(&scheduler_timer);
+
+    // The minutes left stay on the screen
+    Image_clearStrings();
+    Image_drawString((uint8_t *)" PAUSE\0");
+    Defer_Signal(&display_task, TASKS_EVENT_COMMIT);
 }
 
 /*
- * Handles the built-in button interruption. Checks wether the MCU was powered
- * off or not.
+ * Ends the current state at once, the next one starts with its whole time. A
+ * paused state is skipped too
  *
  * Params:
  *    * None
  * Returns:
  *    * None
  */
-static void task_Button(void) {
+static void skip_state(void) {
+    paused = 0;
+    SWTimer_Stop(&scheduler_timer);
+    switch_task();
+}
+
+/*
+ * Switches the device On/Off. Checks wether the MCU was powered off or not.
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+static void toggle_power(void) {
     if (poweredOff) {
         // Set the variable as not powered off (whenever is pressed again the
         // button, it will turn off the device)
         poweredOff = 0;
 
-        // Re-initialazes all variables, start with focus state again
-        current_tamagotchi = focus_monkey;
-        scheduler.cycles = 0;
-
-        // Display operations
-        Timer_Enable();
-        task_Focus();
-        task_MinuteElapsed(focus_time);
+        // Display operations, the saved state goes on and the scheduler is
+        // woken up again every minute
+        resume_task();
+        schedule_wakeup();
     } else {
         // Set the variable as powered off (whenever the button is pressed
         // again, the device will turn on and follow the re-initialization
         // sequence)
         poweredOff = 1;
 
-        // Disable the timer to avoid triggering the scheduler
-        Timer_Disable();
+        // Stop the timer to avoid triggering the scheduler
+        SWTimer_Stop(&scheduler_timer);
+
+        // Save the state, the next power on resumes it (not paused)
+        context.State = scheduler.State;
+        context.cycles = scheduler.cycles;
+        context.elapsed = state_elapsed();
+        context.Magic = SCHEDULER_CONTEXT_MAGIC;
+        paused = 0;
 
         // emtpy the image
         current_tamagotchi = empty_tamagotchi;
 
-        // Display operations
+        // Draw the bye frame, the display task commits it and then blanks and
+        // puts the displays to sleep
         Image_clearStrings();
         Image_clearMinutesLeft();
         Image_drawString((uint8_t *)" BYE\0");
         Image_drawString((uint8_t *)" BYE\0");
-        Image_displayImage();
-        eInkDisplay_FillWhite();
+        Defer_Signal(&display_task, TASKS_EVENT_COMMIT);
 
-        // Put the CPU to sleep with Wait For Event instruction
-        __WFE();
+        // The MCU enters Standby mode once the displays are done (they lock
+        // it meanwhile) until the button is pressed
     }
 }
 
 /*
- * Defines how the task will switch based on the current conditions
+ * Defines how the task will switch based on the current conditions, the state
+ * task is signaled
  *
  * Params:
  *    * None
@@ -265,17 +648,138 @@ static void switch_task(void) {
 
     if ((scheduler.State == State_Focus) &&
         (scheduler.cycles <= amount_of_cycles)) {
-        task_ShortRest();
+        Defer_Signal(&rest_task, TASKS_EVENT_SHORT);
     } else if ((scheduler.State == State_Focus)) {
-        task_LongRest();
+        Defer_Signal(&rest_task, TASKS_EVENT_LONG);
     } else {
+        Defer_Signal(&focus_task, TASKS_EVENT_ENTER);
+    }
+}
+
+/*
+ * Starts the scheduler timer to the next minute boundary of the current state,
+ * the displays only change then
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+static void schedule_wakeup(void) {
+    SWTimer_Start(&scheduler_timer, next_wakeup() * 1000);
+}
+
+/*
+ * Returns the seconds left to the next minute boundary of the current state
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * seconds, a 32 bit-wide integer (1..60)
+ */
+static uint32_t next_wakeup(void) {
+    uint32_t elapsed = RTC_GetSeconds() - state_start;
+
+    return 60 - (elapsed % 60);
+}
+
+/*
+ * Returns the deadline of the idle power mode, there is none while powered off
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * deadline, a 32 bit-wide integer with the seconds left to the next
+ * wakeup, POWER_NO_DEADLINE while powered off
+ */
+static uint32_t idle_deadline(void) {
+    if (poweredOff) {
+        return POWER_NO_DEADLINE;
+    }
+    // Stop mode until the button resumes the state
+    if (paused) {
+        return RTC_WAKEUP_MAX;
+    }
+    return next_wakeup();
+}
+
+/*
+ * Returns the seconds of the current state elapsed, the time paused is not
+ * counted
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * seconds, a 32 bit-wide integer
+ */
+static uint32_t state_elapsed(void) {
+    if (paused) {
+        return paused_elapsed;
+    }
+    return RTC_GetSeconds() - state_start;
+}
+
+/*
+ * Resumes the state saved when the device was powered off, the elapsed time of
+ * the state is kept. Starts over with the focus state when there is no saved
+ * state
+ *
+ * Params:
+ *    * None
+ * Returns:
+ *    * None
+ */
+static void resume_task(void) {
+    if (context.Magic != SCHEDULER_CONTEXT_MAGIC) {
+        scheduler.cycles = 0;
         task_Focus();
+        task_MinuteElapsed(focus_time);
+        return;
     }
+    context.Magic = 0;
+
+    restore_state(context.State, context.cycles, context.elapsed);
 }
 
 /*
- * Buil-in initialization as interruption mode. Set the trigger interruption on
- * the falling edge
+ * Enters a state again with part of its time elapsed, its frame is drawn. A
+ * state whose time is over switches to the next one
+ *
+ * Params:
+ *    * State, the state to enter, values can be of Scheduler_State
+ *    * Cycles, an 8 bit-wide integer with the cycles of the scheduler
+ *    * Elapsed, a 32 bit-wide integer with the seconds of the state elapsed
+ * Returns:
+ *    * None
+ */
+static void restore_state(Scheduler_State State, uint8_t Cycles,
+                          uint32_t Elapsed) {
+    switch (State) {
+    case State_ShortRest:
+        task_ShortRest();
+        break;
+    case State_LongRest:
+        task_LongRest();
+        break;
+    default:
+        task_Focus();
+        break;
+    }
+
+    // The state goes on where it was left, a state already over switches at
+    // once
+    scheduler.cycles = Cycles;
+    state_start = RTC_GetSeconds() - Elapsed;
+    if (Elapsed / 60 >= scheduler.minutes_to_elapse) {
+        switch_task();
+        return;
+    }
+    task_MinuteElapsed(scheduler.minutes_to_elapse - (Elapsed / 60));
+}
+
+/*
+ * Buil-in initialization as interruption mode. The interruption is triggered
+ * on both edges, they are debounced by the Button API (HIGH while pressed)
  *
  * Params:
  *    * None
@@ -284,28 +788,42 @@ static void switch_task(void) {
  */
 static void GPIO_buttonInit(void) {
     // built-in button configuration
-    scheduler_button.pGPIOx = GPIOC;
-    scheduler_button.InterruptMode = GPIO_It_Fall;
-    scheduler_button.Config.Number = 13;
-    scheduler_button.Config.Mode = GPIO_Mode_Input;
-    scheduler_button.Config.PullUpDown = GPIO_PuPd_None;
-    GPIO_Init(&scheduler_button);
-
-    // Interruption confuguration
+    scheduler_button.GPIODriver.pGPIOx = GPIOC;
+    scheduler_button.GPIODriver.Config.Number = 13;
+    scheduler_button.GPIODriver.Config.PullUpDown = GPIO_PuPd_None;
+    scheduler_button.ActiveLevel = HIGH;
+    Button_Init(&scheduler_button);
+    GPIO_IRQ_Register(scheduler_button.GPIODriver.Config.Number,
+                      button_IRQTrigger, &scheduler_button);
+
+    // Interruption confuguration. Above ATOMIC_CRITICAL_PRIORITY, the critical
+    // sections never delay it: it only uses the edge ring and Defer_Signal
+    // (lock-free)
     GPIO_IRQ_Control(EXTI15_10_IRQn, ENABLE);
-    GPIO_IRQ_PriorityConfig(EXTI15_10_IRQn, 25);
+    GPIO_IRQ_PriorityConfig(EXTI15_10_IRQn, ATOMIC_CRITICAL_PRIORITY - 1);
 }
 
 /*
- * Calls the task button whenever the built-in function is triggered. Invoked by
- * the GPIO API.
+ * Queues the edge and signals the button task whenever the built-in function
+ * is triggered, it runs from the PendSV handler. No busy waiting, the line is
+ * masked until the button task confirms the level. Registered on the button
+ * line, invoked by the GPIO API.
  *
  * Params:
- *    * Pin number: Corresponds to the Pin number that triggered the
+ *    * PinNumber: Corresponds to the Pin number that triggered the
  * interruption
+ *    * pContext: pointer to the Button_TypeDef of the pin
+ * Returns:
+ *    * None
  */
-void GPIO_Callback_IRQTrigger(uint8_t PinNumber) {
-    if (PinNumber == 13) {
-        task_Button();
+static void button_IRQTrigger(uint8_t PinNumber, void *pContext) {
+    Button_EdgeTypeDef edge = Button_IRQHandling(pContext);
+
+    if (Tasks_EdgeRing_Push(&button_edges, &edge) == OK) {
+        Defer_Signal(&button_task, TASKS_EVENT_EDGE);
+    } else {
+        // Edges beyond the ring capacity are dropped, the line must not stay
+        // masked
+        GPIO_IRQ_LineControl(PinNumber, ENABLE);
     }
 }
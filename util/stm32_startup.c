@@ -4,7 +4,12 @@
 #define SRAM_SIZE (192U * 1024U)
 #define SRAM_END ((SRAM_START) + (SRAM_SIZE))
 
-#define STACK_START SRAM_END
+#define CCMRAM_START 0X10000000U
+#define CCMRAM_SIZE (64U * 1024U)
+#define CCMRAM_END ((CCMRAM_START) + (CCMRAM_SIZE))
+
+// main stack in the CCM-RAM, enabled at reset and free of DMA contention
+#define STACK_START CCMRAM_END
 
 
 void Reset_Handler(void);
@@ -118,6 +123,8 @@ void __libc_init_array(void);
 // extern symbols
 
 extern uint32_t _etext,_sdata,_edata,_sbss,_ebss, _la_data;
+extern uint32_t _sramfunc,_eramfunc,_la_ramfunc;
+extern uint32_t _sccmram,_eccmram,_siccmram,_sccmbss,_eccmbss;
 
 uint32_t vectors[] __attribute__((section(".isr_vector"))) = {
     STACK_START,
@@ -246,6 +253,26 @@ void Reset_Handler(void)
         *pDest++= *pSource++;
     }
 
+    // functions tagged __ramfunc, copied before any of them is called
+    size = (uint32_t)&_eramfunc - (uint32_t)&_sramfunc;
+    pDest = (uint8_t*)&_sramfunc;
+    pSource = (uint8_t*)&_la_ramfunc;
+
+    for(uint32_t i = 0; i < size; i++)
+    {
+        *pDest++= *pSource++;
+    }
+
+    // CPU-only data in the CCM-RAM
+    size = (uint32_t)&_eccmram - (uint32_t)&_sccmram;
+    pDest = (uint8_t*)&_sccmram;
+    pSource = (uint8_t*)&_siccmram;
+
+    for(uint32_t i = 0; i < size; i++)
+    {
+        *pDest++= *pSource++;
+    }
+
     size = (uint32_t)&_ebss - (uint32_t)&_sbss;
     pDest = (uint8_t*)&_sbss;
 
@@ -254,6 +281,14 @@ void Reset_Handler(void)
         *pDest++ = 0;
     }
 
+    size = (uint32_t)&_eccmbss - (uint32_t)&_sccmbss;
+    pDest = (uint8_t*)&_sccmbss;
+
+    for(uint32_t i = 0; i < size; i++)
+    {
+        *pDest++ = 0;
+    }
+
     __libc_init_array();
 
     main();